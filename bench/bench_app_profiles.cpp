@@ -0,0 +1,350 @@
+// Per-application profiles (app_profiles.h): resolving an executable to its
+// profile through the hash table, and what focus changes cost the hook path.
+// The hook loop mirrors HandleMove (echo table, snapshot acquire, active
+// profile load, EdgeRemapStage over the rect list or the profile's policy
+// table) over synthetic motion (trajectory.h), with:
+//   - no profile ever set, and the loop without the profile load at all
+//   - one profile active throughout
+//   - a focus thread switching the foreground app every --switch-us,
+//     resolving paths and storing the profile as the Windows tracker does;
+//     reports switch latency (store to first event mapped with it)
+// Checks: lookups are case-insensitive, take full paths, miss unknown apps
+// and reject duplicates; a scripted run of focus changes at fixed events
+// maps every event exactly as the scheduled profile's table does; no event
+// is remapped while a pass-through profile is active, including steps over
+// a narrow monitor and past a corner that no portal covers (exit code 1
+// otherwise).
+//
+//   bench_app_profiles [--apps=N] [--samples=N] [--switch-us=N] [--lookups=N]
+
+#include "app_profiles.h"
+#include "bench_common.h"
+#include "echo_filter.h"
+#include "filter_chain.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int    REPS            = 3;
+static constexpr size_t SCRIPT_INTERVAL = 997;  // events between scripted focus changes
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+static const RemapStrategy kCycle[] = {RemapStrategy::PassThrough, RemapStrategy::Offset, RemapStrategy::Clamped,
+                                       RemapStrategy::Percent, RemapStrategy::Physical};
+
+static std::string AppName(size_t i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "app%03zu.exe", i);
+    return buf;
+}
+
+// What a focus tracker is handed: full paths, odd case, apps without a profile
+static std::vector<std::string> MakeScript(size_t apps) {
+    std::vector<std::string> out;
+    for (size_t i = 0; i < apps; ++i) {
+        std::string name = AppName(i);
+        if (i % 3 == 0) std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        out.push_back(i % 2 ? "C:\\Program Files\\Vendor\\" + name : "/opt/vendor/bin/" + name);
+        out.push_back("C:\\Windows\\explorer.exe");
+    }
+    return out;
+}
+
+static bool CheckLookups(AppProfileTable& table, size_t apps) {
+    const char* why = nullptr;
+    for (size_t i = 0; i < apps && !why; ++i) {
+        std::string name = AppName(i), upper = name;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        const AppProfile* p = table.Find(name.c_str());
+        if (!p || p->index != i) why = "exact name";
+        else if (table.Find(upper.c_str()) != p) why = "upper case";
+        else if (table.FindPath(("C:\\Games\\" + upper).c_str()) != p) why = "windows path";
+        else if (table.FindPath(("/usr/bin/" + name).c_str()) != p) why = "posix path";
+        else if (table.Find((name + "x").c_str()) || table.Find(name.c_str(), name.size() - 1)) why = "near miss";
+    }
+    if (!why && (table.Find("explorer.exe") || table.FindPath(""))) why = "unknown app";
+    if (!why && table.Add("C:\\Other\\APP000.EXE", {})) why = "duplicate accepted";
+    std::string app;
+    PortalStrategyConfig config;
+    if (!why && !(ParseAppProfile("cad.exe=offset,0:1=pass-through,2:0=clamped", app, config) && app == "cad.exe" &&
+                  config.fallback == RemapStrategy::Offset && config.overrides.size() == 2 &&
+                  config.For(0, 1) == RemapStrategy::PassThrough && config.For(2, 0) == RemapStrategy::Clamped))
+        why = "parse";
+    if (!why && (ParseAppProfile("=percent", app, config) || ParseAppProfile("x.exe=warp", app, config) ||
+                 ParseAppProfile("x.exe=percent,0:1", app, config)))
+        why = "bad spec accepted";
+    if (why) printf("  lookup check failed: %s\n", why);
+    return !why;
+}
+
+// HandleMove minus the OS; the profile pointer comes from `active`.
+struct HookPath {
+    SnapshotPublisher&       publisher;
+    EdgeRemapStage           remap;
+    EchoTable                echoes;
+    uint64_t                 seenVersion = 0;
+    const TopologySnapshot*  policyTopo  = nullptr;
+    const PortalPolicyTable* table       = nullptr;
+    const AppProfile*        profile     = nullptr;
+
+    explicit HookPath(SnapshotPublisher& p) : publisher(p) {}
+
+    template <bool Profiles>
+    bool Handle(MotionSample& s, const ActiveProfile& active) {
+        if (echoes.Consume(s.pos, s.time)) return false;
+        const TopologySnapshot* topo = publisher.Acquire();
+        const AppProfile* p = Profiles ? active.Get() : nullptr;
+        if (topo && (topo->version != seenVersion || p != profile)) {
+            if (topo->version != seenVersion) remap.SetMonitors(topo->monitors);
+            seenVersion = topo->version;
+            profile     = p;
+            table       = ProfilePolicies(*topo, p);
+            policyTopo  = table ? topo : nullptr;
+        }
+        s.dx    = static_cast<double>(s.pos.x - remap.lastPos.x);
+        s.dy    = static_cast<double>(s.pos.y - remap.lastPos.y);
+        s.flags = 0;
+        if (policyTopo) {
+            const auto& mons = policyTopo->monitors;
+            remap.ProcessWith(PolicyTopology<>{mons.data(), mons.size(), table}, &s, 1);
+        } else {
+            remap.Process(&s, 1);
+        }
+        if (!(s.flags & MOTION_REMAPPED)) return false;
+        echoes.Record(s.pos, s.time);
+        return true;
+    }
+};
+
+template <bool Profiles>
+static void Replay(SnapshotPublisher& publisher, const ActiveProfile& active, const std::vector<MotionSample>& input,
+                   std::vector<MotionSample>& out) {
+    HookPath hook(publisher);
+    for (size_t i = 0; i < input.size(); ++i) {
+        out[i] = input[i];
+        // The warp's echo arrives next
+        if (hook.Handle<Profiles>(out[i], active)) {
+            MotionSample echo{hook.remap.lastPos, 0.0, 0.0, out[i].time, 0};
+            hook.Handle<Profiles>(echo, active);
+        }
+    }
+}
+
+// Crossings no portal covers, through the hook path: a step over a narrow
+// middle monitor each way and a diagonal past a corner. The default
+// (percent) remaps the steps; a pass-through profile must leave all alone.
+static bool CheckNonPortalCrossings() {
+    static const std::vector<Rect> row = {{0, 0, 1920, 1080}, {1920, 0, 2560, 1080}, {2560, 100, 4480, 1180},
+                                          {1920, 1080, 2560, 1800}};
+    static const Point path[] = {{1900, 500}, {2600, 500}, {3000, 600}, {1800, 600}, {1915, 1075}, {1925, 1085}};
+    AppProfileTable profiles;
+    PortalStrategyConfig passThrough;
+    passThrough.fallback = RemapStrategy::PassThrough;
+    profiles.Add("cad.exe", passThrough);
+    auto snap = std::make_unique<TopologySnapshot>();
+    snap->monitors = row;
+    snap->portals  = BuildPortals(row);
+    snap->policies = BuildPortalPolicies(row, snap->portals, {});
+    snap->profiles = BuildProfilePolicies(profiles, row, snap->portals);
+    SnapshotPublisher publisher;
+    publisher.Publish(std::move(snap));
+
+    auto remaps = [&](const AppProfile* profile) {
+        ActiveProfile active;
+        active.Set(profile);
+        HookPath hook(publisher);
+        size_t n = 0;
+        uint32_t t = 0;
+        for (Point p : path) {
+            MotionSample s{p, 0.0, 0.0, t += 8, 0};
+            n += hook.Handle<true>(s, active);
+        }
+        return n;
+    };
+    size_t byDefault = remaps(nullptr), byPassThrough = remaps(profiles.Find("cad.exe"));
+    printf("  no portal: %zu of 3 crossings remapped by default, %zu under pass-through\n", byDefault, byPassThrough);
+    return byDefault == 2 && byPassThrough == 0;
+}
+
+int main(int argc, char** argv) {
+    size_t apps = 64, samples = size_t{1} << 22, lookups = size_t{1} << 20;
+    uint64_t switchUs = 200;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--apps=", 7) == 0) apps = std::max<size_t>(1, strtoull(argv[i] + 7, nullptr, 10));
+        else if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--switch-us=", 12) == 0) switchUs = std::max<uint64_t>(1, strtoull(argv[i] + 12, nullptr, 10));
+        else if (strncmp(argv[i], "--lookups=", 10) == 0) lookups = std::max<size_t>(1, strtoull(argv[i] + 10, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    AppProfileTable table;
+    for (size_t i = 0; i < apps; ++i) {
+        PortalStrategyConfig config;
+        config.fallback = kCycle[i % std::size(kCycle)];
+        if (i % 7 == 6) config.overrides.push_back({0, 1, RemapStrategy::PassThrough});
+        table.Add(AppName(i), config);
+    }
+    std::vector<std::string> script = MakeScript(apps);
+
+    std::vector<Rect> mons = kMonitors;
+    auto snap = std::make_unique<TopologySnapshot>();
+    snap->monitors = mons;
+    snap->portals  = BuildPortals(mons);
+    snap->policies = BuildPortalPolicies(mons, snap->portals, {});
+    snap->profiles = BuildProfilePolicies(table, mons, snap->portals);
+    const TopologySnapshot* live = snap.get();
+    SnapshotPublisher publisher;
+    publisher.Publish(std::move(snap));
+
+    TrajectoryConfig cfg;
+    cfg.monitors = kMonitors;
+    cfg.seed     = 42;
+    const size_t chunk = size_t{1} << 16;
+    size_t chunks = std::max<size_t>(1, samples / chunk);
+    std::vector<MotionSample> input(chunks * chunk), out(input.size()), ref(input.size());
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, input.data(), 1, endMs);
+    printf("%zu app profiles, %zu monitors, %zu replay samples\n", table.Size(), kMonitors.size(), input.size());
+
+    bool ok = CheckLookups(table, apps);
+    ok = CheckNonPortalCrossings() && ok;
+
+    // --- Lookup ---
+    const AppProfile* found = nullptr;
+    PrintRow("resolve path -> profile", MeasureNsPerEvent(lookups, REPS, [&] {
+        for (size_t i = 0; i < lookups; ++i) {
+            found = table.FindPath(script[i % script.size()].c_str());
+            DoNotOptimize(found);
+        }
+    }));
+
+    // --- Hook path, no switching ---
+    ActiveProfile active;
+    PrintRow("replay, without profile load", MeasureNsPerEvent(input.size(), REPS, [&] {
+        Replay<false>(publisher, active, input, out);
+    }));
+    PrintRow("replay, default profile", MeasureNsPerEvent(input.size(), REPS, [&] {
+        Replay<true>(publisher, active, input, out);
+    }));
+    active.Set(table.Find(AppName(1).c_str()));
+    PrintRow("replay, offset profile throughout", MeasureNsPerEvent(input.size(), REPS, [&] {
+        Replay<true>(publisher, active, input, out);
+    }));
+
+    // --- Scripted focus changes, checked against the scheduled tables ---
+    {
+        HookPath hook(publisher), check(publisher);
+        ActiveProfile scripted;
+        size_t focus = 0, mismatches = 0, passThroughRemaps = 0;
+        for (size_t i = 0; i < input.size(); ++i) {
+            if (i % SCRIPT_INTERVAL == 0) {
+                // The tracker's work: resolve, then one store
+                scripted.Set(table.FindPath(script[focus].c_str()));
+                focus = (focus + 1) % script.size();
+            }
+            const AppProfile* want = scripted.Get();
+            MotionSample a = input[i], b = input[i];
+            bool warped = hook.Handle<true>(a, scripted);
+            // Reference: the scheduled profile's table picked directly
+            if (!check.echoes.Consume(b.pos, b.time)) {
+                const PortalPolicyTable& t = want ? live->profiles[want->index] : live->policies;
+                if (check.seenVersion != live->version) {
+                    check.remap.SetMonitors(live->monitors);
+                    check.seenVersion = live->version;
+                }
+                b.dx = static_cast<double>(b.pos.x - check.remap.lastPos.x);
+                b.dy = static_cast<double>(b.pos.y - check.remap.lastPos.y);
+                b.flags = 0;
+                if (t.Custom()) check.remap.ProcessWith(PolicyTopology<>{mons.data(), mons.size(), &t}, &b, 1);
+                else check.remap.Process(&b, 1);
+                if (b.flags & MOTION_REMAPPED) check.echoes.Record(b.pos, b.time);
+            }
+            if (a.pos != b.pos || a.flags != b.flags) ++mismatches;
+            bool passThrough = want && want->strategies.fallback == RemapStrategy::PassThrough &&
+                               want->strategies.overrides.empty();
+            if (passThrough && (a.flags & MOTION_REMAPPED)) ++passThroughRemaps;
+            if (warped) {
+                MotionSample echo{hook.remap.lastPos, 0.0, 0.0, a.time, 0};
+                hook.Handle<true>(echo, scripted);
+                check.echoes.Consume(b.pos, b.time);
+            }
+        }
+        printf("  scripted: %zu focus changes, %zu events differ from the scheduled table, "
+               "%zu remapped under pass-through\n",
+               input.size() / SCRIPT_INTERVAL + 1, mismatches, passThroughRemaps);
+        ok = ok && mismatches == 0 && passThroughRemaps == 0;
+    }
+
+    // --- Live switching from a focus thread ---
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> setNs{0};
+    uint64_t switches = 0;
+    active.Set(nullptr);
+    std::thread focusThread([&] {
+        size_t focus = 0;
+        const AppProfile* last = nullptr;
+        while (!stop.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(switchUs));
+            const AppProfile* p = table.FindPath(script[focus].c_str());
+            focus = (focus + 1) % script.size();
+            if (p == last) continue;
+            last = p;
+            setNs.store(NowNs(), std::memory_order_relaxed);
+            active.Set(p);
+            ++switches;
+        }
+    });
+    std::vector<uint64_t> latency;
+    latency.reserve(1 << 16);
+    size_t passThroughRemaps = 0;
+    uint64_t t0 = NowNs();
+    for (int r = 0; r < REPS; ++r) {
+        HookPath hook(publisher);
+        for (size_t i = 0; i < input.size(); ++i) {
+            MotionSample s = input[i];
+            const AppProfile* before = hook.profile;
+            bool warped = hook.Handle<true>(s, active);
+            if (hook.profile != before && latency.size() < latency.capacity())
+                latency.push_back(NowNs() - setNs.load(std::memory_order_relaxed));
+            const AppProfile* p = hook.profile;
+            if (p && p->strategies.fallback == RemapStrategy::PassThrough && p->strategies.overrides.empty() &&
+                (s.flags & MOTION_REMAPPED))
+                ++passThroughRemaps;
+            if (warped) {
+                MotionSample echo{hook.remap.lastPos, 0.0, 0.0, s.time, 0};
+                hook.Handle<true>(echo, active);
+            }
+        }
+    }
+    double secs = static_cast<double>(NowNs() - t0) / 1e9;
+    stop.store(true, std::memory_order_release);
+    focusThread.join();
+    PrintRow("replay, focus thread switching", secs * 1e9 / static_cast<double>(REPS * input.size()));
+    printf("  %llu switches (%.0f/s), %zu seen by the hook, %zu remapped under pass-through\n",
+           static_cast<unsigned long long>(switches), static_cast<double>(switches) / secs, latency.size(),
+           passThroughRemaps);
+    if (!latency.empty()) {
+        Percentiles p = ComputePercentiles(latency);
+        printf("  store -> first event mapped with it: p50 %.0f ns, p99 %.0f ns\n", p.p50, p.p99);
+    }
+    ok = ok && passThroughRemaps == 0;
+    return ok ? 0 : 1;
+}
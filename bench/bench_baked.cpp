@@ -0,0 +1,167 @@
+// Baked vs generic topology: layouts baked at build time by
+// cursor_mapper_bake (bench/layouts/*.layout) against the same rects mapped
+// through the runtime rect list. Per layout: monitor lookup over random
+// points, crossing decisions over segments across every portal, and a
+// synthetic replay (trajectory.h) through EdgeRemapStage. Baked and generic
+// must agree on every call and sample, and each layout must match only its
+// own rects (exit code 1 otherwise).
+//
+//   bench_baked [--samples=N] [--calls=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "topology.h"
+#include "trajectory.h"
+
+#include "kiosk_layout.h"  // generated
+#include "mixed_layout.h"  // generated
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+static constexpr int REPS = 7;
+
+struct Segment {
+    Point from, to;
+    int   src, dst;
+};
+
+// One short step across a random portal, from just inside src to just
+// inside dst
+static std::vector<Segment> MakeCrossings(const std::vector<Rect>& mons, size_t n) {
+    std::vector<TopologyPortal> portals = BuildPortals(mons);
+    std::mt19937 rng(42);
+    std::vector<Segment> out(n);
+    for (auto& seg : out) {
+        const TopologyPortal& p = portals[rng() % portals.size()];
+        const Rect& a = mons[p.src];
+        long along = p.overlapStart + static_cast<long>(rng() % static_cast<unsigned>(p.overlapEnd - p.overlapStart));
+        long in = 1 + static_cast<long>(rng() % 8), out2 = 1 + static_cast<long>(rng() % 8);
+        long skew = static_cast<long>(rng() % 9) - 4;
+        switch (p.edge) {
+        case Edge::Left:  seg.from = {a.left + in - 1, along};   seg.to = {a.left - out2, along + skew};   break;
+        case Edge::Right: seg.from = {a.right - in, along};      seg.to = {a.right + out2 - 1, along + skew}; break;
+        case Edge::Top:   seg.from = {along, a.top + in - 1};    seg.to = {along + skew, a.top - out2};    break;
+        default:          seg.from = {along, a.bottom - in};     seg.to = {along + skew, a.bottom + out2 - 1}; break;
+        }
+        seg.src = p.src;
+        seg.dst = p.dst;
+    }
+    return out;
+}
+
+static std::vector<Point> MakePoints(const std::vector<Rect>& mons, size_t n) {
+    long l = mons[0].left, t = mons[0].top, r = mons[0].right, b = mons[0].bottom;
+    for (const Rect& m : mons) {
+        l = std::min(l, m.left);
+        t = std::min(t, m.top);
+        r = std::max(r, m.right);
+        b = std::max(b, m.bottom);
+    }
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<long> px(l - 16, r + 15), py(t - 16, b + 15);
+    std::vector<Point> pts(n);
+    for (auto& p : pts) p = {px(rng), py(rng)};
+    return pts;
+}
+
+static bool SameDecision(const CrossingDecision& a, const CrossingDecision& b) {
+    return a.hit.edge == b.hit.edge && a.hit.t == b.hit.t && a.remapped == b.remapped && a.mapped == b.mapped;
+}
+
+template <typename Layout>
+static bool RunLayout(const char* name, size_t samples, size_t calls) {
+    const std::vector<Rect> mons(std::begin(Layout::MONITORS), std::end(Layout::MONITORS));
+    const RectListTopology generic{mons.data(), mons.size()};
+    const BakedTopology<Layout> baked;
+    printf("%s: %zu monitors\n", name, mons.size());
+    bool ok = true;
+
+    std::vector<Point> pts = MakePoints(mons, calls);
+    std::vector<int> idxGeneric(calls), idxBaked(calls);
+    PrintRow("monitor lookup, generic", MeasureNsPerEvent(calls, REPS, [&] {
+        for (size_t i = 0; i < calls; ++i) idxGeneric[i] = generic.MonitorIndex(pts[i]);
+        DoNotOptimize(idxGeneric.data());
+    }));
+    PrintRow("monitor lookup, baked", MeasureNsPerEvent(calls, REPS, [&] {
+        for (size_t i = 0; i < calls; ++i) idxBaked[i] = baked.MonitorIndex(pts[i]);
+        DoNotOptimize(idxBaked.data());
+    }));
+    if (idxGeneric != idxBaked) {
+        printf("    monitor lookup differs\n");
+        ok = false;
+    }
+
+    std::vector<Segment> segs = MakeCrossings(mons, calls);
+    std::vector<CrossingDecision> decGeneric(calls), decBaked(calls);
+    PrintRow("crossing decision, generic", MeasureNsPerEvent(calls, REPS, [&] {
+        for (size_t i = 0; i < calls; ++i) decGeneric[i] = generic.Cross(segs[i].src, segs[i].dst, segs[i].from, segs[i].to);
+        DoNotOptimize(decGeneric.data());
+    }));
+    PrintRow("crossing decision, baked", MeasureNsPerEvent(calls, REPS, [&] {
+        for (size_t i = 0; i < calls; ++i) decBaked[i] = baked.Cross(segs[i].src, segs[i].dst, segs[i].from, segs[i].to);
+        DoNotOptimize(decBaked.data());
+    }));
+    for (size_t i = 0; i < calls && ok; ++i) {
+        if (!SameDecision(decGeneric[i], decBaked[i])) {
+            printf("    crossing decision differs at %zu\n", i);
+            ok = false;
+        }
+    }
+
+    TrajectoryConfig cfg;
+    cfg.monitors = mons;
+    cfg.seed     = 42;
+    const size_t chunk = size_t{1} << 16;
+    size_t chunks = std::max<size_t>(1, samples / chunk);
+    std::vector<MotionSample> input(chunks * chunk), outGeneric(input.size()), outBaked(input.size());
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, input.data(), 1, endMs);
+    auto replay = [&](std::vector<MotionSample>& out, bool useBaked) {
+        EdgeRemapStage stage;
+        stage.SetMonitors(mons);
+        std::copy(input.begin(), input.end(), out.begin());
+        if (useBaked) stage.ProcessWith(baked, out.data(), out.size());
+        else stage.Process(out.data(), out.size());
+    };
+    PrintRow("replay, generic", MeasureNsPerEvent(input.size(), REPS, [&] { replay(outGeneric, false); }));
+    PrintRow("replay, baked", MeasureNsPerEvent(input.size(), REPS, [&] { replay(outBaked, true); }));
+    for (size_t i = 0; i < input.size() && ok; ++i) {
+        if (outGeneric[i].pos != outBaked[i].pos || outGeneric[i].flags != outBaked[i].flags) {
+            printf("    replay differs at sample %zu\n", i);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = size_t{1} << 22, calls = size_t{1} << 20;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--calls=", 8) == 0) calls = std::max<size_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    bool ok = RunLayout<KioskLayout>("kiosk", samples, calls);
+    ok = RunLayout<MixedLayout>("mixed", samples, calls) && ok;
+
+    // The runtime check: each layout matches its own rects only
+    const std::vector<Rect> kiosk(std::begin(KioskLayout::MONITORS), std::end(KioskLayout::MONITORS));
+    const std::vector<Rect> mixed(std::begin(MixedLayout::MONITORS), std::end(MixedLayout::MONITORS));
+    std::vector<Rect> moved = kiosk;
+    moved[1].top += 1;
+    if (!BakedLayoutMatches<KioskLayout>(0, kiosk) || BakedLayoutMatches<KioskLayout>(0, mixed) ||
+        BakedLayoutMatches<KioskLayout>(0, moved) || !BakedLayoutMatches<MixedLayout>(0, mixed)) {
+        printf("baked layout check accepted the wrong layout\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+// C API mapping cost: synthetic motion (trajectory.h) mapped through the
+// shared library one sample per call (cm_map_motion) and in batches of
+// several sizes (cm_map_motions), next to Chain<EdgeRemapStage> called
+// directly. A last run keeps a writer thread swapping topologies while the
+// mapping thread maps batches. Every run must produce the Chain's output
+// and, on the mapping thread, no heap allocation (exit code 1 otherwise).
+//
+// Allocations are counted by replacing operator new in this executable; on
+// ELF platforms that replacement also serves the library.
+//
+//   bench_c_api [--samples=N] [--rate=HZ] [--swap-us=N]
+
+#include "bench_common.h"
+#include "cursor_mapper.h"
+#include "filter_chain.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+static constexpr int REPS = 5;
+
+static thread_local uint64_t t_allocs = 0;
+
+void* operator new(size_t size) {
+    ++t_allocs;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Uneven sizes, offsets and a monitor stacked above, as in bench_mapping
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+static cm_topology* MakeTopology() {
+    cm_rect rects[4];
+    for (size_t i = 0; i < kMonitors.size(); ++i) {
+        const Rect& r = kMonitors[i];
+        rects[i] = {static_cast<int32_t>(r.left), static_cast<int32_t>(r.top), static_cast<int32_t>(r.right),
+                    static_cast<int32_t>(r.bottom)};
+    }
+    return cm_topology_create(rects, kMonitors.size(), nullptr);
+}
+
+static bool SameOutput(const std::vector<cm_result>& out, const std::vector<MotionSample>& expect) {
+    for (size_t i = 0; i < out.size(); ++i)
+        if (out[i].x != expect[i].pos.x || out[i].y != expect[i].pos.y || out[i].flags != expect[i].flags)
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = size_t{1} << 22;
+    double rate = 1000.0;
+    uint64_t swapUs = 1000;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--rate=", 7) == 0) rate = atof(argv[i] + 7);
+        else if (strncmp(argv[i], "--swap-us=", 10) == 0) swapUs = strtoull(argv[i] + 10, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    TrajectoryConfig cfg;
+    cfg.monitors = kMonitors;
+    cfg.pollHz   = rate;
+    cfg.seed     = 40;
+    const size_t chunk = size_t{1} << 16;
+    size_t chunks = std::max<size_t>(1, samples / chunk);
+    std::vector<MotionSample> input(chunks * chunk), expect(input.size());
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, input.data(), 1, endMs);
+
+    std::vector<cm_sample> in(input.size());
+    for (size_t i = 0; i < input.size(); ++i)
+        in[i] = {static_cast<int32_t>(input[i].pos.x), static_cast<int32_t>(input[i].pos.y), input[i].time, 0};
+    std::vector<cm_result> out(in.size());
+
+    printf("C API mapping: %zu samples at %.0f Hz, %zu monitors, ABI %u\n", in.size(), rate, kMonitors.size(),
+           cm_abi_version());
+
+    double directNs = MeasureNsPerEvent(input.size(), REPS, [&] {
+        Chain<EdgeRemapStage> chain;
+        chain.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+        std::copy(input.begin(), input.end(), expect.begin());
+        chain.Process(expect.data(), expect.size());
+    });
+    PrintRow("Chain<EdgeRemapStage> direct", directNs);
+
+    cm_mapper* mapper = cm_mapper_create();
+    if (!mapper || cm_mapper_set_topology(mapper, MakeTopology()) != CM_OK) {
+        printf("cannot create the mapper\n");
+        return 1;
+    }
+
+    bool ok = true;
+    auto check = [&](const char* name, uint64_t allocs) {
+        if (!SameOutput(out, expect)) {
+            printf("    %s: output differs from the direct chain\n", name);
+            ok = false;
+        }
+        if (allocs) {
+            printf("    %s: %llu allocation(s) on the mapping thread\n", name, static_cast<unsigned long long>(allocs));
+            ok = false;
+        }
+    };
+
+    {
+        uint64_t a0 = t_allocs;
+        double ns = MeasureNsPerEvent(in.size(), REPS, [&] {
+            cm_mapper_reset(mapper);
+            for (size_t i = 0; i < in.size(); ++i) cm_map_motion(mapper, &in[i], &out[i]);
+        });
+        PrintRow("cm_map_motion, one call per sample", ns);
+        check("cm_map_motion", t_allocs - a0);
+    }
+
+    for (size_t batch : {size_t{16}, size_t{256}, size_t{4096}, in.size()}) {
+        uint64_t a0 = t_allocs;
+        double ns = MeasureNsPerEvent(in.size(), REPS, [&] {
+            cm_mapper_reset(mapper);
+            for (size_t i = 0; i < in.size(); i += batch)
+                cm_map_motions(mapper, &in[i], std::min(batch, in.size() - i), &out[i]);
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "cm_map_motions, batch %zu", batch);
+        PrintRow(name, ns);
+        check(name, t_allocs - a0);
+    }
+
+    // Same layout republished: each swap resets the crossing state, so the
+    // output is only compared on the quiet runs above
+    {
+        const size_t batch = 256;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> swaps{0};
+        std::thread writer([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                cm_mapper_set_topology(mapper, MakeTopology());
+                swaps.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::microseconds(swapUs));
+            }
+        });
+        uint64_t a0 = t_allocs;
+        double ns = MeasureNsPerEvent(in.size(), REPS, [&] {
+            for (size_t i = 0; i < in.size(); i += batch)
+                cm_map_motions(mapper, &in[i], std::min(batch, in.size() - i), &out[i]);
+        });
+        uint64_t allocs = t_allocs - a0;
+        stop = true;
+        writer.join();
+        char name[64];
+        snprintf(name, sizeof(name), "batch %zu, swap every %llu us", batch, static_cast<unsigned long long>(swapUs));
+        PrintRow(name, ns);
+        printf("    %llu topology swaps\n", static_cast<unsigned long long>(swaps.load()));
+        if (allocs) {
+            printf("    %llu allocation(s) on the mapping thread\n", static_cast<unsigned long long>(allocs));
+            ok = false;
+        }
+    }
+
+    cm_mapper_destroy(mapper);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// Replay with induced stalls: the mapper is periodically descheduled, the
+// input queue backs up, and the backlog is drained either one sample at a
+// time or through CoalesceStage. Runs on a virtual clock so results are
+// deterministic; mapping itself runs for real.
+//
+//   bench_coalesce [--rate=HZ] [--seconds=N] [--stall-ms=N] [--stall-every-ms=N]
+//                  [--emit-us=N]
+//
+// Sample time is in microseconds here (CoalesceStage only needs the sample
+// time and `now` in the same units).
+//
+// Checks (exit code 1 otherwise): both modes apply identical remaps; with
+// coalescing the applied state is fresh again (no more than CAUGHT_UP_US
+// stale) within CAUGHT_UP_US of every stall ending; and without it, it is
+// not, so the run shows the stall actually hurts one-by-one draining.
+
+#include "bench_common.h"
+#include "filter_chain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+};
+
+struct Options {
+    uint64_t rateHz       = 8000;
+    uint64_t seconds      = 10;
+    uint64_t stallMs      = 100;
+    uint64_t stallEveryMs = 1000;
+    uint64_t emitUs       = 20;    // cost of applying one output (warp / inject)
+};
+
+// Point-to-point moves at up to 3000 px/s between targets on random
+// monitors, sampled at rateHz.
+static std::vector<MotionSample> MakeInput(const Options& opt) {
+    std::mt19937 rng(4242);
+    std::uniform_real_distribution<double> unit(0.0, 1.0), jitter(-0.3, 0.3);
+    std::uniform_int_distribution<size_t> pick(0, kMonitors.size() - 1);
+
+    size_t n = static_cast<size_t>(opt.rateHz * opt.seconds);
+    double step = 3000.0 / static_cast<double>(opt.rateHz);
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        double ddx = targetX - x, ddy = targetY - y;
+        double dist = std::sqrt(ddx * ddx + ddy * ddy);
+        while (dist < step) {
+            const Rect& m = kMonitors[pick(rng)];
+            targetX = m.left + unit(rng) * (m.right - m.left - 1);
+            targetY = m.top + unit(rng) * (m.bottom - m.top - 1);
+            ddx = targetX - x;
+            ddy = targetY - y;
+            dist = std::sqrt(ddx * ddx + ddy * ddy);
+        }
+        double dx = ddx / dist * step + jitter(rng);
+        double dy = ddy / dist * step + jitter(rng);
+        x += dx;
+        y += dy;
+        uint32_t arrivalUs = static_cast<uint32_t>(i * 1000000 / opt.rateHz);
+        out[i] = {{0, 0}, dx, dy, arrivalUs, 0};
+    }
+    return out;
+}
+
+static constexpr uint64_t CAUGHT_UP_US = 1000;  // applied state at most this stale
+
+struct ReplayResult {
+    Percentiles         latency;     // arrival -> applied, per input sample
+    uint64_t            maxCatchUpUs;  // stall end -> applied state fresh again
+    uint64_t            outputs;
+    std::vector<Point>  remaps;      // positions of applied remaps, in order
+    uint64_t            coalescedEvents   = 0;
+    uint64_t            coalescedSegments = 0;
+};
+
+// onBatch(vt) runs before each batch is mapped.
+template <typename ChainT, typename OnBatch>
+static ReplayResult Replay(ChainT& chain, const std::vector<MotionSample>& input,
+                           const Options& opt, OnBatch onBatch)
+{
+    static constexpr size_t MAX_BATCH = 4096;
+    std::vector<MotionSample> work(MAX_BATCH);
+    std::vector<uint64_t> lat;
+    lat.reserve(input.size());
+    ReplayResult res{};
+
+    uint64_t vt = 0;  // virtual time, us
+    uint64_t stallEnd = 0;
+    bool catchingUp = false;
+    size_t idx = 0;
+    while (idx < input.size()) {
+        // Descheduled: nothing runs until the stall window ends.
+        uint64_t phase = vt % (opt.stallEveryMs * 1000);
+        uint64_t stallStart = (opt.stallEveryMs - opt.stallMs) * 1000;
+        if (opt.stallMs && phase >= stallStart) {
+            // Still behind from the previous stall: that catch-up never ended
+            if (catchingUp) res.maxCatchUpUs = std::max(res.maxCatchUpUs, vt - stallEnd);
+            vt += opt.stallEveryMs * 1000 - phase;
+            stallEnd = vt;
+            catchingUp = true;
+        }
+
+        if (input[idx].time > vt) {
+            vt = input[idx].time;
+            continue;
+        }
+        size_t avail = idx;
+        while (avail < input.size() && avail - idx < MAX_BATCH && input[avail].time <= vt) ++avail;
+        size_t n = avail - idx;
+
+        std::copy_n(input.data() + idx, n, work.data());
+        onBatch(vt);
+        size_t out = chain.Process(work.data(), n);
+
+        // Each output costs emitUs; every input merged into it is applied then.
+        size_t k = idx;
+        for (size_t j = 0; j < out; ++j) {
+            vt += opt.emitUs;
+            if (catchingUp && vt - work[j].time <= CAUGHT_UP_US) {
+                res.maxCatchUpUs = std::max(res.maxCatchUpUs, vt - stallEnd);
+                catchingUp = false;
+            }
+            if (work[j].flags & MOTION_REMAPPED) res.remaps.push_back(work[j].pos);
+            for (; k < avail && input[k].time <= work[j].time; ++k)
+                lat.push_back(vt - input[k].time);
+        }
+        res.outputs += out;
+        idx = avail;
+    }
+    if (catchingUp) res.maxCatchUpUs = std::max(res.maxCatchUpUs, vt - stallEnd);
+    res.latency = ComputePercentiles(lat);
+    return res;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        auto value = [&](const char* key) -> const char* {
+            size_t len = strlen(key);
+            return strncmp(a, key, len) == 0 ? a + len : nullptr;
+        };
+        if (const char* v = value("--rate="))                opt.rateHz       = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--seconds="))        opt.seconds      = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--stall-ms="))       opt.stallMs      = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--stall-every-ms=")) opt.stallEveryMs = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--emit-us="))        opt.emitUs       = strtoull(v, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return false;
+        }
+    }
+    if (!opt.rateHz || opt.rateHz > 1000000 || !opt.stallEveryMs || opt.stallMs >= opt.stallEveryMs) {
+        fprintf(stderr, "need 0 < rate <= 1000000 and stall-ms < stall-every-ms\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseOptions(argc, argv, opt)) return 2;
+    auto input = MakeInput(opt);
+
+    Chain<SubPixelStage, EdgeRemapStage> plain;
+    plain.Get<SubPixelStage>().Reset({1280, 720});
+    plain.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+
+    Chain<SubPixelStage, CoalesceStage, EdgeRemapStage> coalesced;
+    coalesced.Get<SubPixelStage>().Reset({1280, 720});
+    coalesced.Get<CoalesceStage>().SetMonitors(kMonitors);
+    coalesced.Get<CoalesceStage>().maxAge = 16000;
+    coalesced.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+
+    uint64_t t0 = NowNs();
+    ReplayResult a = Replay(plain, input, opt, [](uint64_t) {});
+    uint64_t t1 = NowNs();
+    ReplayResult b = Replay(coalesced, input, opt, [&](uint64_t vt) {
+        coalesced.Get<CoalesceStage>().now = static_cast<uint32_t>(vt);
+    });
+    uint64_t t2 = NowNs();
+    b.coalescedEvents   = coalesced.Get<CoalesceStage>().coalescedEvents;
+    b.coalescedSegments = coalesced.Get<CoalesceStage>().coalescedSegments;
+
+    printf("coalesce: %zu samples at %llu Hz, %llu ms stall every %llu ms, %llu us per output\n",
+           input.size(), static_cast<unsigned long long>(opt.rateHz),
+           static_cast<unsigned long long>(opt.stallMs),
+           static_cast<unsigned long long>(opt.stallEveryMs),
+           static_cast<unsigned long long>(opt.emitUs));
+    printf("  %-10s %10s %8s %8s %8s %8s %12s %12s\n", "mode", "outputs", "remaps",
+           "p50 ms", "p99 ms", "max ms", "catch-up ms", "wall ns/ev");
+    auto row = [&](const char* name, const ReplayResult& r, uint64_t ns) {
+        printf("  %-10s %10llu %8zu %8.2f %8.2f %8.2f %12.2f %12.2f\n", name,
+               static_cast<unsigned long long>(r.outputs), r.remaps.size(),
+               r.latency.p50 / 1e3, r.latency.p99 / 1e3, r.latency.max / 1e3,
+               static_cast<double>(r.maxCatchUpUs) / 1e3,
+               static_cast<double>(ns) / static_cast<double>(input.size()));
+    };
+    row("one-by-one", a, t1 - t0);
+    row("coalesced", b, t2 - t1);
+    printf("  coalesced events %llu into %llu segments\n",
+           static_cast<unsigned long long>(b.coalescedEvents),
+           static_cast<unsigned long long>(b.coalescedSegments));
+
+    bool same = a.remaps.size() == b.remaps.size() &&
+                std::equal(a.remaps.begin(), a.remaps.end(), b.remaps.begin());
+    printf("  crossings identical: %s\n", same ? "yes" : "NO");
+
+    // The stall itself delays everything queued behind it in both modes; what
+    // coalescing bounds is how long the applied state stays stale after it.
+    bool bounded = b.maxCatchUpUs <= CAUGHT_UP_US;
+    bool hurts   = !opt.stallMs || a.maxCatchUpUs > CAUGHT_UP_US;
+    printf("  coalesced catch-up within %.2f ms: %s\n", static_cast<double>(CAUGHT_UP_US) / 1e3,
+           bounded ? "yes" : "NO");
+    printf("  one-by-one catch-up beyond it: %s\n", hurts ? "yes" : "NO");
+    return same && bounded && hurts ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+// Minimal timing helpers shared by the benchmark executables.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+inline uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Keep the optimiser from discarding a computed value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    const volatile void* sink = &value;
+    (void)sink;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+// --- Hardware counters (Linux perf_event_open, user space only) ---
+// One group read atomically around each measured run. Anything that cannot
+// be opened (no PMU in a VM, perf_event_paranoid, seccomp in a container)
+// leaves that counter missing; if the leader fails the group is simply
+// unavailable and benches fall back to wall clock.
+
+enum PerfCounter { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_BRANCHES, PERF_BRANCH_MISSES, PERF_L1D_MISSES,
+                   PERF_COUNTER_COUNT };
+
+struct PerfCounts {
+    bool   valid = false;
+    double perEvent[PERF_COUNTER_COUNT] = {NAN, NAN, NAN, NAN, NAN};  // NaN when missing
+};
+
+class PerfGroup {
+public:
+    PerfGroup() = default;
+    PerfGroup(const PerfGroup&) = delete;
+    PerfGroup& operator=(const PerfGroup&) = delete;
+    ~PerfGroup() { Close(); }
+
+    bool Open() {
+#if defined(__linux__)
+        static const struct { uint32_t type; uint64_t config; } kEvents[PERF_COUNTER_COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        };
+        Close();
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = kEvents[i].type;
+            attr.config         = kEvents[i].config;
+            attr.disabled       = fds_[PERF_CYCLES] < 0;  // only the leader starts disabled
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                  PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, fds_[PERF_CYCLES], 0));
+            if (fd < 0) {
+                if (i == PERF_CYCLES) {
+                    snprintf(error_, sizeof(error_), "perf_event_open: %s", strerror(errno));
+                    return false;
+                }
+                continue;
+            }
+            fds_[i]  = fd;
+            slot_[i] = members_++;
+        }
+        return true;
+#else
+        snprintf(error_, sizeof(error_), "hardware counters need Linux perf_event_open");
+        return false;
+#endif
+    }
+
+    bool Available() const { return fds_[PERF_CYCLES] >= 0; }
+    const char* Error() const { return error_; }
+
+    void Start() {
+#if defined(__linux__)
+        if (!Available()) return;
+        ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Per-event counts since Start(); invalid if the group never got a PMU slot.
+    PerfCounts Stop(uint64_t events) {
+        PerfCounts out;
+#if defined(__linux__)
+        if (!Available()) return out;
+        ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t buf[3 + PERF_COUNTER_COUNT] = {};  // nr, time_enabled, time_running, values
+        if (read(fds_[PERF_CYCLES], buf, sizeof(buf)) <= 0 || buf[2] == 0) return out;
+        double scale = static_cast<double>(buf[1]) / static_cast<double>(buf[2]);  // multiplexed
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i)
+            if (fds_[i] >= 0)
+                out.perEvent[i] = static_cast<double>(buf[3 + slot_[i]]) * scale / static_cast<double>(events);
+        out.valid = true;
+#else
+        (void)events;
+#endif
+        return out;
+    }
+
+    void Close() {
+#if defined(__linux__)
+        for (int i = PERF_COUNTER_COUNT - 1; i >= 0; --i) {
+            if (fds_[i] >= 0) close(fds_[i]);
+            fds_[i] = -1;
+        }
+        members_ = 0;
+#endif
+    }
+
+private:
+    int  fds_[PERF_COUNTER_COUNT]  = {-1, -1, -1, -1, -1};
+    int  slot_[PERF_COUNTER_COUNT] = {};
+    int  members_ = 0;
+    char error_[128] = "";
+};
+
+// Process-wide group, opened by benches that take --perf.
+inline PerfGroup& BenchPerf() {
+    static PerfGroup group;
+    return group;
+}
+
+// Opens BenchPerf() and says why not when it cannot.
+inline bool EnableBenchPerf() {
+    if (BenchPerf().Open()) return true;
+    printf("hardware counters unavailable (%s); wall clock only\n", BenchPerf().Error());
+    return false;
+}
+
+struct BenchResult {
+    double     ns = 0.0;  // per event, best of reps
+    PerfCounts perf;      // from the best rep, when BenchPerf() is open
+};
+
+// Best-of-reps; fn() must process `events` events.
+template <typename Fn>
+inline BenchResult Measure(uint64_t events, int reps, Fn&& fn) {
+    BenchResult best;
+    best.ns = 1e300;
+    PerfGroup& perf = BenchPerf();
+    for (int r = 0; r < reps; ++r) {
+        perf.Start();
+        uint64_t t0 = NowNs();
+        fn();
+        uint64_t t1 = NowNs();
+        PerfCounts counts = perf.Stop(events);
+        double ns = static_cast<double>(t1 - t0) / static_cast<double>(events);
+        if (ns < best.ns) best = {ns, counts};
+    }
+    return best;
+}
+
+// Best-of-reps nanoseconds per event; fn() must process `events` events.
+template <typename Fn>
+inline double MeasureNsPerEvent(uint64_t events, int reps, Fn&& fn) {
+    return Measure(events, reps, std::forward<Fn>(fn)).ns;
+}
+
+inline void PrintRow(const char* name, double nsPerEvent) {
+    printf("  %-40s %8.2f ns/event\n", name, nsPerEvent);
+}
+
+// Wall clock plus, when counted: cycles, IPC, branch misses per event and
+// as a share of branches, L1D read misses per event. "-" marks a counter
+// the PMU did not provide.
+inline void PrintRow(const char* name, const BenchResult& r) {
+    printf("  %-40s %8.2f ns/event", name, r.ns);
+    if (r.perf.valid) {
+        const double* c = r.perf.perEvent;
+        auto field = [](const char* label, double v, const char* fmt) {
+            printf("  %s ", label);
+            if (std::isnan(v)) printf("-");
+            else printf(fmt, v);
+        };
+        field("cyc", c[PERF_CYCLES], "%.1f");
+        field("IPC", c[PERF_INSTRUCTIONS] / c[PERF_CYCLES], "%.2f");
+        field("br-miss", c[PERF_BRANCH_MISSES], "%.3f");
+        field("br-miss%", c[PERF_BRANCH_MISSES] / c[PERF_BRANCHES] * 100.0, "%.2f");
+        field("L1D-miss", c[PERF_L1D_MISSES], "%.3f");
+    }
+    printf("\n");
+}
+
+// Pin the calling thread to one CPU; returns false when the OS refuses
+// (e.g. the CPU is outside the container's cpuset).
+inline bool PinCurrentThread(unsigned cpu) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// --- Latency percentiles ---
+
+struct Percentiles {
+    double p50, p99, p999, max;
+};
+
+// Sorts samples in place.
+inline Percentiles ComputePercentiles(std::vector<uint64_t>& samples) {
+    if (samples.empty()) return {0, 0, 0, 0};
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t i = static_cast<size_t>(q * static_cast<double>(samples.size() - 1));
+        return static_cast<double>(samples[i]);
+    };
+    return {at(0.50), at(0.99), at(0.999), static_cast<double>(samples.back())};
+}
@@ -0,0 +1,171 @@
+// Crossing bus (crossing_bus.h) with many subscribers: one writer thread
+// publishes events flat out into a shm ring while reader threads, each with
+// its own read-only mapping, follow it. Event fields are derived from the
+// sequence number, so every reader checks order and content of what it got.
+// The last reader is deliberately slow (a short read, then a 1 ms nap) and
+// must be lapped. Every reader must account for the whole stream: received
+// + lost == published, with each gap it saw counted as lost. Reports the
+// writer's cost per event alone and with readers, reader throughput and
+// publish-to-read latency. Exit code 1 when a check fails.
+//
+//   bench_crossing_bus [--readers=N] [--events=N]
+
+#include "bench_common.h"
+#include "crossing_bus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Event `seq` as the writer publishes it; timeNs is stamped at publish.
+static CrossingEvent MakeEvent(uint64_t seq) {
+    CrossingEvent e{};
+    e.time   = static_cast<uint32_t>(seq);
+    e.src    = static_cast<int16_t>(seq % 3);
+    e.dst    = static_cast<int16_t>((seq + 1) % 3);
+    e.edge   = static_cast<uint8_t>(1 + seq % 4);
+    e.flags  = seq & 1 ? CROSSING_REMAPPED : 0;
+    e.exitX  = static_cast<int32_t>(seq * 7);
+    e.exitY  = -static_cast<int32_t>(seq);
+    e.rawX   = e.exitX + 1;
+    e.rawY   = e.exitY - 1;
+    e.entryX = e.exitX + 2;
+    e.entryY = static_cast<int32_t>(seq >> 3);
+    return e;
+}
+
+static bool Intact(const CrossingEvent& e) {
+    CrossingEvent want = MakeEvent(e.time);
+    want.timeNs = e.timeNs;
+    return memcmp(&want, &e, sizeof(e)) == 0;
+}
+
+struct ReaderResult {
+    bool     opened   = false;
+    uint64_t received = 0;
+    uint64_t gaps     = 0;  // events skipped between consecutive reads
+    uint64_t lost     = 0;  // CrossingBusReader::Lost()
+    uint64_t end      = 0;  // Next() after the final drain
+    uint64_t bad      = 0;  // out of order or torn
+    uint64_t busyNs   = 0;
+    std::vector<uint64_t> latencyNs;
+};
+
+static void Follow(const std::string& name, bool slow, const std::atomic<bool>* done, ReaderResult* res) {
+    CrossingBusReader reader;
+    if (!reader.Open(name, true)) return;
+    res->opened = true;
+    res->latencyNs.reserve(1 << 20);
+    CrossingEvent events[256];
+    uint64_t expect = reader.Next();
+    for (bool last = false;;) {
+        // Writer finished: one more pass picks up the tail
+        if (!last && done->load(std::memory_order_acquire)) last = true;
+        uint64_t t0 = NowNs();
+        size_t n = reader.Read(events, slow ? 16 : 256);
+        uint64_t now = NowNs();
+        for (size_t i = 0; i < n; ++i) {
+            const CrossingEvent& e = events[i];
+            if (e.time < static_cast<uint32_t>(expect) || !Intact(e)) {
+                ++res->bad;
+                continue;
+            }
+            res->gaps += e.time - static_cast<uint32_t>(expect);
+            expect = static_cast<uint64_t>(e.time) + 1;
+            if (res->latencyNs.size() < res->latencyNs.capacity()) res->latencyNs.push_back(now - e.timeNs);
+        }
+        res->received += n;
+        if (n) res->busyNs += now - t0;
+        if (last && n == 0) break;
+        if (slow) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        else if (n == 0) std::this_thread::yield();
+    }
+    res->lost = reader.Lost();
+    res->end  = reader.Next();
+}
+
+static double Publish(CrossingBus& bus, uint64_t events) {
+    uint64_t first = bus.Published(), t0 = NowNs();
+    for (uint64_t i = 0; i < events; ++i) {
+        CrossingEvent e = MakeEvent(first + i);
+        e.timeNs = NowNs();
+        bus.Publish(e);
+    }
+    return static_cast<double>(NowNs() - t0) / static_cast<double>(events);
+}
+
+int main(int argc, char** argv) {
+    unsigned readers = 8;
+    uint64_t events = 4000000;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--readers=", 10) == 0) readers = std::max(1u, static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10)));
+        else if (strncmp(argv[i], "--events=", 9) == 0) events = std::max<uint64_t>(4 * BUS_CAPACITY, strtoull(argv[i] + 9, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::string name = "/cursor_mapper_bench_bus." + std::to_string(getpid());
+    CrossingBus bus;
+    if (!bus.Create(name)) {
+        fprintf(stderr, "cannot create %s: %s\n", name.c_str(), bus.Error());
+        return 1;
+    }
+    printf("crossing bus: %s, %u slots of %zu bytes, %u reader(s) (last one slow), %llu events, %u cpu(s)\n",
+           name.c_str(), BUS_CAPACITY, sizeof(BusSlot), readers, static_cast<unsigned long long>(events),
+           std::thread::hardware_concurrency());
+
+    // Warm the ring, then time the writer with nobody reading; readers
+    // opened below with fromOldest start at these events' tail
+    double alone = Publish(bus, events / 4);
+
+    std::atomic<bool> done{false};
+    std::vector<ReaderResult> results(readers);
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < readers; ++r)
+        threads.emplace_back(Follow, name, r + 1 == readers && readers > 1, &done, &results[r]);
+    // Let the readers map the ring and start polling
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t t0 = NowNs();
+    double contended = Publish(bus, events);
+    double secs = static_cast<double>(NowNs() - t0) / 1e9;
+    done.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+
+    PrintRow("writer, no readers", alone);
+    PrintRow("writer, readers following", contended);
+
+    bool ok = true;
+    uint64_t published = bus.Published();
+    std::vector<uint64_t> latency;
+    for (unsigned r = 0; r < readers; ++r) {
+        ReaderResult& res = results[r];
+        bool slow = r + 1 == readers && readers > 1;
+        // Accounting: each reader starts BUS_CAPACITY behind and ends at the
+        // head; what it did not receive it must have been told was lost
+        uint64_t start = res.end - res.received - res.lost;
+        bool accounted = res.opened && res.end == published && res.gaps == res.lost &&
+                         start == published - events - BUS_CAPACITY;
+        bool lapped = !slow || res.lost > 0;
+        printf("  reader %u%s: %llu received (%.1f M/s while busy), %llu lost, %llu bad%s%s\n", r,
+               slow ? " (slow)" : "", static_cast<unsigned long long>(res.received),
+               res.busyNs ? static_cast<double>(res.received) * 1e3 / static_cast<double>(res.busyNs) : 0.0,
+               static_cast<unsigned long long>(res.lost), static_cast<unsigned long long>(res.bad),
+               accounted ? "" : ", ACCOUNTING WRONG", lapped ? "" : ", NEVER LAPPED");
+        ok = ok && accounted && lapped && res.bad == 0;
+        if (!slow) latency.insert(latency.end(), res.latencyNs.begin(), res.latencyNs.end());
+    }
+    if (!latency.empty()) {
+        Percentiles p = ComputePercentiles(latency);
+        printf("  publish -> read: p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns (%.1f M events/s published)\n", p.p50,
+               p.p99, p.p999, static_cast<double>(events) / secs / 1e6);
+    }
+    return ok ? 0 : 1;
+}
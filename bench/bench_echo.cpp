@@ -0,0 +1,163 @@
+// Echo table under simulated X11-style delivery: warps carry no "injected"
+// flag, echoes arrive after a random delay (so they reorder relative to
+// each other and to real motion), and a share arrives after the expiry.
+// Reports classification counts and the per-event lookup cost.
+//
+// Three phases, each on a fresh table:
+//   dense      warps every 10 ms; late echoes pass because their slot has
+//              long been overwritten (eviction)
+//   sparse     warps every 500 ms, every echo late; the slot is still
+//              present when the echo arrives, so only the expiry lets it pass
+//   collision  real motion lands on a pending target before its echo; the
+//              table swallows that real event and lets the echo through,
+//              one event per collision as documented in echo_filter.h
+//
+//   bench_echo [--warps=N] [--late-pct=N]
+
+#include "bench_common.h"
+#include "echo_filter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+enum class Kind { Record, User, Echo, LateEcho, Collide, CollidedEcho, Count };
+
+struct SimEvent {
+    uint32_t time;
+    uint32_t order;  // tie-break: a warp is recorded before its echo
+    Kind     kind;
+    Point    p;
+};
+
+struct Phase {
+    uint32_t warpEveryMs  = 10;
+    unsigned latePct      = 0;
+    unsigned collideEvery = 0;  // every Nth warp collides with real motion (0: none)
+};
+
+struct PhaseResult {
+    static constexpr size_t KINDS = static_cast<size_t>(Kind::Count);
+    uint64_t hit[KINDS] = {}, miss[KINDS] = {};
+    uint64_t lookups = 0, ns = 0;
+    uint64_t expired = 0, evicted = 0;
+
+    uint64_t Hit(Kind k) const { return hit[static_cast<int>(k)]; }
+    uint64_t Miss(Kind k) const { return miss[static_cast<int>(k)]; }
+};
+
+static PhaseResult RunPhase(const Phase& ph, size_t warps, uint32_t seed) {
+    EchoTable table;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<long> px(0, 4479), py(0, 1439);
+    std::uniform_int_distribution<uint32_t> delay(0, 40), afterCollide(2, 40), lateDelay(table.expiry + 1, table.expiry + 200);
+    std::uniform_int_distribution<unsigned> pct(0, 99);
+
+    std::vector<SimEvent> events;
+    uint32_t order = 0;
+    Point last{0, 0};
+    for (size_t i = 0; i < warps; ++i) {
+        uint32_t t = static_cast<uint32_t>(i * ph.warpEveryMs);
+        bool collide = ph.collideEvery && i % ph.collideEvery == 0;
+        // Every fourth warp reuses the previous target to exercise pairing.
+        // Targets sit on even x, real motion on odd x, so any suppressed
+        // real event outside a collision is a table bug rather than a
+        // coincidence.
+        Point target = (i % 4 == 3 && !collide) ? last : Point{px(rng) & ~1L, py(rng)};
+        last = target;
+        events.push_back({t, order++, Kind::Record, target});
+        if (collide) {
+            // Real motion reaches the target first, its echo follows
+            events.push_back({t + 1, order++, Kind::Collide, target});
+            events.push_back({t + afterCollide(rng), order++, Kind::CollidedEcho, target});
+        } else {
+            bool late = pct(rng) < ph.latePct;
+            events.push_back({t + (late ? lateDelay(rng) : delay(rng)), order++,
+                              late ? Kind::LateEcho : Kind::Echo, target});
+        }
+        // Real motion at 1 kHz for the first 10 ms after each warp.
+        for (uint32_t k = 0; k < 10; ++k) {
+            Point p{px(rng) | 1L, py(rng)};
+            events.push_back({t + k, order++, Kind::User, p});
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const SimEvent& a, const SimEvent& b) {
+        return a.time != b.time ? a.time < b.time : a.order < b.order;
+    });
+
+    PhaseResult r;
+    uint64_t t0 = NowNs();
+    for (const auto& ev : events) {
+        if (ev.kind == Kind::Record) {
+            table.Record(ev.p, ev.time);
+            continue;
+        }
+        bool echo = table.Consume(ev.p, ev.time);
+        ++r.lookups;
+        (echo ? r.hit : r.miss)[static_cast<int>(ev.kind)]++;
+    }
+    r.ns      = NowNs() - t0;
+    r.expired = table.expired;
+    r.evicted = table.evicted;
+    return r;
+}
+
+static void PrintCounts(const char* name, uint64_t hit, uint64_t miss) {
+    printf("    %-26s %10llu suppressed %10llu passed\n", name, static_cast<unsigned long long>(hit),
+           static_cast<unsigned long long>(miss));
+}
+
+int main(int argc, char** argv) {
+    size_t warps = 200000;
+    unsigned latePct = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--warps=", 8) == 0) warps = strtoull(argv[i] + 8, nullptr, 10);
+        else if (strncmp(argv[i], "--late-pct=", 11) == 0) latePct = static_cast<unsigned>(atoi(argv[i] + 11));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("echo table: %zu warps per phase, %u ms expiry, %zu slots\n", warps, EchoTable{}.expiry,
+           EchoTable::ECHO_SLOTS);
+    bool ok = true;
+
+    // Dense: every on-time echo must be caught and no real motion swallowed.
+    PhaseResult dense = RunPhase({10, latePct, 0}, warps, 99);
+    printf("  dense (warp every 10 ms, %u%% late)\n", latePct);
+    PrintCounts("on-time echoes", dense.Hit(Kind::Echo), dense.Miss(Kind::Echo));
+    PrintCounts("late echoes", dense.Hit(Kind::LateEcho), dense.Miss(Kind::LateEcho));
+    PrintCounts("real motion", dense.Hit(Kind::User), dense.Miss(Kind::User));
+    printf("    expired %llu, evicted %llu\n", static_cast<unsigned long long>(dense.expired),
+           static_cast<unsigned long long>(dense.evicted));
+    PrintRow("Consume", static_cast<double>(dense.ns) / static_cast<double>(dense.lookups));
+    ok = ok && dense.Miss(Kind::Echo) == 0 && dense.Hit(Kind::User) == 0;
+
+    // Sparse: slots outlive the expiry, so the expiry alone must let late
+    // echoes through.
+    size_t sparseWarps = std::max<size_t>(1, warps / 50);
+    PhaseResult sparse = RunPhase({500, 100, 0}, sparseWarps, 7);
+    printf("  sparse (%zu warps every 500 ms, all late)\n", sparseWarps);
+    PrintCounts("late echoes", sparse.Hit(Kind::LateEcho), sparse.Miss(Kind::LateEcho));
+    PrintCounts("real motion", sparse.Hit(Kind::User), sparse.Miss(Kind::User));
+    printf("    expired %llu, evicted %llu\n", static_cast<unsigned long long>(sparse.expired),
+           static_cast<unsigned long long>(sparse.evicted));
+    ok = ok && sparse.expired > 0 && sparse.Hit(Kind::LateEcho) == 0 && sparse.Hit(Kind::User) == 0;
+
+    // Collision: each collision costs exactly the real event, never the
+    // echo too, and never anything else.
+    PhaseResult coll = RunPhase({10, 0, 16}, warps, 31);
+    uint64_t collisions = coll.Hit(Kind::Collide) + coll.Miss(Kind::Collide);
+    printf("  collision (%llu real events on a pending target)\n", static_cast<unsigned long long>(collisions));
+    PrintCounts("colliding real motion", coll.Hit(Kind::Collide), coll.Miss(Kind::Collide));
+    PrintCounts("their echoes", coll.Hit(Kind::CollidedEcho), coll.Miss(Kind::CollidedEcho));
+    PrintCounts("on-time echoes", coll.Hit(Kind::Echo), coll.Miss(Kind::Echo));
+    PrintCounts("other real motion", coll.Hit(Kind::User), coll.Miss(Kind::User));
+    ok = ok && collisions > 0 && coll.Hit(Kind::Collide) == collisions && coll.Hit(Kind::CollidedEcho) == 0 &&
+         coll.Miss(Kind::Echo) == 0 && coll.Hit(Kind::User) == 0;
+
+    return ok ? 0 : 1;
+}
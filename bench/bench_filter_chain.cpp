@@ -0,0 +1,153 @@
+// Per-stage cost of the filter chain: compile-time Chain<...> vs RuntimeChain
+// over the same stage types, batches processed in place.
+//
+//   bench_filter_chain [--perf]
+//
+// --perf adds hardware counters for each compile-time run (not baseline
+// subtracted) after the table.
+
+#include "bench_common.h"
+#include "filter_chain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr size_t BATCH  = 256;
+static constexpr size_t EVENTS = size_t{1} << 20;
+static constexpr int    REPS   = 7;
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+};
+
+// Cursor wanders between random targets across both monitors, with jitter,
+// so the remap stage sees a realistic share of crossings.
+static std::vector<MotionSample> MakeInput(size_t n) {
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> tx(0.0, 4480.0), ty(0.0, 1440.0), jitter(-1.5, 1.5);
+
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        double dx = (targetX - x) * 0.08 + jitter(rng);
+        double dy = (targetY - y) * 0.08 + jitter(rng);
+        x = std::clamp(x + dx, 0.0, 4479.0);
+        y = std::clamp(y + dy, 0.0, 1439.0);
+        out[i] = {{static_cast<long>(x), static_cast<long>(y)}, dx, dy,
+                  static_cast<uint32_t>(i), 0};
+    }
+    return out;
+}
+
+struct CountedRow {
+    const char* name;
+    BenchResult result;
+};
+static std::vector<CountedRow> g_counted;
+
+template <typename ChainT>
+static BenchResult Run(ChainT& chain, const std::vector<MotionSample>& input,
+                       std::vector<MotionSample>& work)
+{
+    return Measure(input.size(), REPS, [&] {
+        for (size_t off = 0; off < input.size(); off += BATCH) {
+            size_t n = std::min(BATCH, input.size() - off);
+            std::copy_n(input.data() + off, n, work.data());
+            n = chain.Process(work.data(), n);
+            DoNotOptimize(work[n ? n - 1 : 0]);
+        }
+    });
+}
+
+// Measures Stage alone both ways; configure() sets up a freshly built stage.
+template <typename Stage, typename Configure>
+static void BenchStage(const char* name, const std::vector<MotionSample>& input,
+                       std::vector<MotionSample>& work, double baseline,
+                       Configure configure)
+{
+    Chain<Stage> fixed;
+    configure(fixed.template Get<Stage>());
+    BenchResult counted = Run(fixed, input, work);
+    double ct = counted.ns - baseline;
+    g_counted.push_back({name, counted});
+
+    Stage stage;
+    configure(stage);
+    RuntimeChain dyn;
+    dyn.Add(stage);
+    double rt = Run(dyn, input, work).ns - baseline;
+
+    printf("  %-20s %12.2f %12.2f\n", name, ct, rt);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--perf") == 0) {
+            EnableBenchPerf();
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto input = MakeInput(EVENTS);
+    std::vector<MotionSample> work(BATCH);
+
+    Chain<> empty;
+    BenchResult copy = Run(empty, input, work);
+    double baseline = copy.ns;
+    g_counted.push_back({"copy baseline", copy});
+
+    auto deadZone = [](DeadZoneStage& s) { s.radius = 0.5; };
+    auto accel    = [](AccelCurveStage&) {};
+    auto subPixel = [](SubPixelStage& s) { s.Reset({1280, 720}); };
+    auto remap    = [](EdgeRemapStage& s) { s.SetMonitors(kMonitors); };
+
+    printf("filter chain: %zu events, batch %zu, copy baseline %.2f ns/event\n",
+           EVENTS, BATCH, baseline);
+    printf("  %-20s %12s %12s   (ns/event, baseline subtracted)\n",
+           "stage", "compile-time", "runtime");
+
+    BenchStage<DeadZoneStage>("DeadZoneStage", input, work, baseline, deadZone);
+    BenchStage<AccelCurveStage>("AccelCurveStage", input, work, baseline, accel);
+    BenchStage<SubPixelStage>("SubPixelStage", input, work, baseline, subPixel);
+    BenchStage<EdgeRemapStage>("EdgeRemapStage", input, work, baseline, remap);
+
+    Chain<DeadZoneStage, AccelCurveStage, SubPixelStage, EdgeRemapStage> fixed;
+    deadZone(fixed.Get<DeadZoneStage>());
+    subPixel(fixed.Get<SubPixelStage>());
+    remap(fixed.Get<EdgeRemapStage>());
+    BenchResult full = Run(fixed, input, work);
+    double ct = full.ns - baseline;
+    g_counted.push_back({"full chain", full});
+
+    DeadZoneStage dz;
+    AccelCurveStage ac;
+    SubPixelStage sp;
+    EdgeRemapStage er;
+    deadZone(dz);
+    subPixel(sp);
+    remap(er);
+    RuntimeChain dyn;
+    dyn.Add(dz);
+    dyn.Add(ac);
+    dyn.Add(sp);
+    dyn.Add(er);
+    double rt = Run(dyn, input, work).ns - baseline;
+
+    printf("  %-20s %12.2f %12.2f\n", "full chain", ct, rt);
+
+    if (BenchPerf().Available()) {
+        printf("compile-time runs with hardware counters (per event, copy included):\n");
+        for (const auto& row : g_counted) PrintRow(row.name, row.result);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Topology wakeups on a fake clock: the old fixed 30 s poll against the
+// event-driven VerifyBackoff schedule, over a simulated day.
+//
+// Scenarios: an idle machine that never changes layout, and a laptop that
+// docks / undocks a few times a day where only the first of several staged
+// layout changes raises a notification (the rest must be caught by the
+// verification poll). Exits non-zero if the idle machine wakes at all or a
+// staged change is never picked up.
+//
+//   bench_idle [--hours=N]
+
+#include "bench_common.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static constexpr uint64_t OLD_POLL_MS = 30000;
+
+struct Scenario {
+    const char*           name;
+    std::vector<uint64_t> notifications;  // times an OS notification fires
+    std::vector<uint64_t> changes;        // times the layout actually changes
+};
+
+struct SimResult {
+    WakeupCounter wakeups;
+    uint64_t      maxDetectMs = 0;  // layout change -> seen by a refresh
+    bool          allSeen     = true;
+};
+
+// Fake-clock event loop; a refresh "sees" every change made before it.
+static SimResult SimulateBackoff(const Scenario& sc, uint64_t endMs) {
+    VerifyBackoff verify;
+    SimResult r;
+    size_t nextNote = 0, seen = 0;
+    auto refresh = [&](uint64_t now) {
+        bool changed = false;
+        while (seen < sc.changes.size() && sc.changes[seen] <= now) {
+            r.maxDetectMs = std::max(r.maxDetectMs, now - sc.changes[seen]);
+            ++seen;
+            changed = true;
+        }
+        return changed;
+    };
+    for (;;) {
+        uint64_t noteAt = nextNote < sc.notifications.size() ? sc.notifications[nextNote] : NO_DEADLINE;
+        uint64_t now = std::min(noteAt, verify.dueMs);
+        if (now == NO_DEADLINE || now > endMs) break;
+        if (now == noteAt) {
+            ++r.wakeups.notifications;
+            refresh(now);
+            verify.OnChangeNotification(now);
+            ++nextNote;
+        } else {
+            ++r.wakeups.timerWakeups;
+            verify.OnChecked(now, refresh(now));
+        }
+    }
+    r.allSeen = seen == sc.changes.size();
+    return r;
+}
+
+static SimResult SimulateFixedPoll(const Scenario& sc, uint64_t endMs) {
+    SimResult r;
+    size_t seen = 0;
+    std::vector<uint64_t> events = sc.notifications;
+    for (uint64_t t = OLD_POLL_MS; t <= endMs; t += OLD_POLL_MS) events.push_back(t);
+    std::sort(events.begin(), events.end());
+    for (uint64_t now : events) {
+        ++r.wakeups.timerWakeups;
+        while (seen < sc.changes.size() && sc.changes[seen] <= now) {
+            r.maxDetectMs = std::max(r.maxDetectMs, now - sc.changes[seen]);
+            ++seen;
+        }
+    }
+    r.allSeen = seen == sc.changes.size();
+    return r;
+}
+
+int main(int argc, char** argv) {
+    uint64_t hours = 24;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--hours=", 8) == 0) hours = strtoull(argv[i] + 8, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    uint64_t endMs = hours * 3600000;
+
+    Scenario idle{"idle", {}, {}};
+    Scenario docking{"dock 4x/day", {}, {}};
+    for (uint64_t h = 1; h < hours; h += 6) {
+        uint64_t t = h * 3600000;
+        // Dock: notification for the first change only, two more monitors
+        // come up 400 ms and 1.7 s later.
+        docking.notifications.push_back(t);
+        docking.changes.insert(docking.changes.end(), {t, t + 400, t + 1700});
+    }
+
+    printf("topology wakeups over %llu simulated hours\n", static_cast<unsigned long long>(hours));
+    printf("  %-14s %-14s %10s %10s %14s %8s\n", "scenario", "policy", "wakeups", "per hour",
+           "max detect ms", "all seen");
+    bool ok = true;
+    for (const Scenario* sc : {&idle, &docking}) {
+        SimResult fixed = SimulateFixedPoll(*sc, endMs);
+        SimResult event = SimulateBackoff(*sc, endMs);
+        auto row = [&](const char* policy, const SimResult& r) {
+            printf("  %-14s %-14s %10llu %10.2f %14llu %8s\n", sc->name, policy,
+                   static_cast<unsigned long long>(r.wakeups.Total()), r.wakeups.PerHour(endMs),
+                   static_cast<unsigned long long>(r.maxDetectMs), r.allSeen ? "yes" : "NO");
+        };
+        row("30 s poll", fixed);
+        row("event+backoff", event);
+        ok = ok && event.allSeen;
+        if (sc == &idle) ok = ok && event.wakeups.Total() == 0;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// Cost of the mapping primitives on their own: MonitorIndexFromPoint,
+// FindExitEdge and RemapCursor over precomputed crossing segments (with the
+// staged variants from mapping_variants.h next to the originals), then the
+// whole EdgeRemapStage. With --perf each row adds cycles, IPC, branch
+// misses and L1D misses per call, which is what decides whether branchless
+// or table-driven variants of these functions are worth writing.
+//
+//   bench_mapping [--perf] [--calls=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "mapping.h"
+#include "mapping_variants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr int REPS = 7;
+
+// Primary with a taller monitor to the right, a smaller one to the left
+// and one above, so all four edges and uneven overlaps are exercised.
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+struct Segment {
+    Point from, to;
+    int   src, dst;
+};
+
+// Random segments that start inside one monitor and end inside another,
+// one short step across the shared edge like a real crossing.
+static std::vector<Segment> MakeCrossings(size_t n) {
+    std::mt19937 rng(161803);
+    std::vector<Segment> out;
+    out.reserve(n);
+    while (out.size() < n) {
+        const Rect& a = kMonitors[rng() % kMonitors.size()];
+        Point from{a.left + static_cast<long>(rng() % static_cast<unsigned>(a.right - a.left)),
+                   a.top + static_cast<long>(rng() % static_cast<unsigned>(a.bottom - a.top))};
+        // Push toward the nearest edge and a little past it
+        long dl = from.x - a.left, dr = a.right - 1 - from.x, dt = from.y - a.top, db = a.bottom - 1 - from.y;
+        long step = 1 + static_cast<long>(rng() % 24);
+        Point to = from;
+        long m = std::min(std::min(dl, dr), std::min(dt, db));
+        if (m == dl) to.x = a.left - step;
+        else if (m == dr) to.x = a.right - 1 + step;
+        else if (m == dt) to.y = a.top - step;
+        else to.y = a.bottom - 1 + step;
+        to.x += static_cast<long>(rng() % 9) - 4;
+        to.y += static_cast<long>(rng() % 9) - 4;
+        int src = MonitorIndexFromPoint(kMonitors.data(), kMonitors.size(), from);
+        int dst = MonitorIndexFromPoint(kMonitors.data(), kMonitors.size(), to);
+        if (src < 0 || dst < 0 || src == dst) continue;
+        out.push_back({from, to, src, dst});
+    }
+    return out;
+}
+
+// Wandering cursor for the whole-stage row, mostly on-monitor motion.
+static std::vector<MotionSample> MakeMotion(size_t n) {
+    std::mt19937 rng(271828);
+    std::uniform_real_distribution<double> tx(-1920.0, 3640.0), ty(-1080.0, 1680.0), jitter(-1.0, 1.0);
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        double dx = (targetX - x) * 0.08 + jitter(rng);
+        double dy = (targetY - y) * 0.08 + jitter(rng);
+        x += dx;
+        y += dy;
+        out[i] = {{static_cast<long>(x), static_cast<long>(y)}, dx, dy, static_cast<uint32_t>(i), 0};
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    size_t calls = size_t{1} << 20;
+    bool perf = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--perf") == 0) perf = true;
+        else if (strncmp(argv[i], "--calls=", 8) == 0) calls = strtoull(argv[i] + 8, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (perf) EnableBenchPerf();
+
+    auto segs = MakeCrossings(calls);
+    std::vector<HitResult> hits(segs.size());
+    for (size_t i = 0; i < segs.size(); ++i)
+        hits[i] = FindExitEdge(segs[i].from, segs[i].to, kMonitors[segs[i].src]);
+    auto motion = MakeMotion(calls);
+
+    printf("mapping primitives: %zu calls, %zu monitors\n", segs.size(), kMonitors.size());
+
+    auto lookup = Measure(segs.size(), REPS, [&] {
+        int sum = 0;
+        for (const auto& s : segs) sum += MonitorIndexFromPoint(kMonitors.data(), kMonitors.size(), s.to);
+        DoNotOptimize(sum);
+    });
+    PrintRow("MonitorIndexFromPoint", lookup);
+
+    auto lookupMask = Measure(segs.size(), REPS, [&] {
+        int sum = 0;
+        for (const auto& s : segs) sum += MonitorIndexFromPointMask(kMonitors.data(), kMonitors.size(), s.to);
+        DoNotOptimize(sum);
+    });
+    PrintRow("MonitorIndexFromPointMask (staged)", lookupMask);
+
+    auto exitEdge = Measure(segs.size(), REPS, [&] {
+        double sum = 0.0;
+        for (const auto& s : segs) sum += FindExitEdge(s.from, s.to, kMonitors[s.src]).t;
+        DoNotOptimize(sum);
+    });
+    PrintRow("FindExitEdge", exitEdge);
+
+    auto exitDirectional = Measure(segs.size(), REPS, [&] {
+        double sum = 0.0;
+        for (const auto& s : segs) sum += FindExitEdgeDirectional(s.from, s.to, kMonitors[s.src]).t;
+        DoNotOptimize(sum);
+    });
+    PrintRow("FindExitEdgeDirectional (staged)", exitDirectional);
+
+    auto remap = Measure(segs.size(), REPS, [&] {
+        long sum = 0;
+        for (size_t i = 0; i < segs.size(); ++i) {
+            const Segment& s = segs[i];
+            double coord = (hits[i].edge == Edge::Left || hits[i].edge == Edge::Right)
+                ? static_cast<double>(s.from.y) : static_cast<double>(s.from.x);
+            Point out{0, 0};
+            if (RemapCursor(kMonitors[s.src], kMonitors[s.dst], hits[i].edge, coord, out)) sum += out.x + out.y;
+        }
+        DoNotOptimize(sum);
+    });
+    PrintRow("RemapCursor", remap);
+
+    Chain<EdgeRemapStage> chain;
+    chain.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+    std::vector<MotionSample> work(motion.size());
+    auto stage = Measure(motion.size(), REPS, [&] {
+        std::copy(motion.begin(), motion.end(), work.begin());
+        chain.Process(work.data(), work.size());
+        DoNotOptimize(work.back());
+    });
+    PrintRow("EdgeRemapStage (wandering motion)", stage);
+    return 0;
+}
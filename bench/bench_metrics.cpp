@@ -0,0 +1,167 @@
+// Metrics under load: a mapping thread replays motion through the chain
+// with the same instrumentation as the hook, while this thread scrapes the
+// exporter socket in a loop. Checks every scrape parses and that counters
+// never go backwards, and reports the hot-path cost of instrumentation.
+//
+//   bench_metrics [--scrapes=N] [--socket=PATH]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "metrics.h"
+#include "metrics_server.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+    {-1920, 0, 0, 1080},
+};
+
+static std::vector<MotionSample> MakeInput(size_t n) {
+    std::mt19937 rng(31337);
+    std::uniform_real_distribution<double> tx(-1920.0, 4480.0), ty(0.0, 1440.0), jitter(-1.0, 1.0);
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        double dx = (targetX - x) * 0.08 + jitter(rng);
+        double dy = (targetY - y) * 0.08 + jitter(rng);
+        x += dx;
+        y += dy;
+        out[i] = {{static_cast<long>(x), static_cast<long>(y)}, dx, dy, static_cast<uint32_t>(i), 0};
+    }
+    return out;
+}
+
+static void OnCrossing(void* ctx, const CrossingInfo& c) {
+    static_cast<ThreadMetrics*>(ctx)->CountPortal(c.src, c.dst);
+}
+
+// One pass over input, one event at a time like the hook.
+static void MapAll(const std::vector<MotionSample>& input, ThreadMetrics* m) {
+    Chain<EdgeRemapStage> chain;
+    auto& remap = chain.Get<EdgeRemapStage>();
+    remap.SetMonitors(kMonitors);
+    if (m) {
+        remap.onCrossing  = OnCrossing;
+        remap.crossingCtx = m;
+    }
+    for (const auto& in : input) {
+        MetricsUpdate update(m);
+        LatencyScope timing(m ? &m->mapLatency : nullptr);
+        MotionSample s = in;
+        chain.Process(&s, 1);
+        if (m) {
+            m->CountSample(s);
+            if (s.flags & MOTION_REMAPPED) m->remaps.Add();
+        }
+        DoNotOptimize(s);
+    }
+}
+
+static bool Scrape(const std::string& path, std::string& body) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+    body.clear();
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) body.append(buf, static_cast<size_t>(n));
+    close(fd);
+    return true;
+}
+
+static uint64_t Value(const std::string& body, const char* name) {
+    std::string key = std::string("\n") + name + " ";
+    size_t pos = body.find(key);
+    if (pos == std::string::npos) return UINT64_MAX;
+    return strtoull(body.c_str() + pos + key.size(), nullptr, 10);
+}
+
+int main(int argc, char** argv) {
+    size_t scrapes = 2000;
+    std::string path = "/tmp/cursor_mapper_bench." + std::to_string(getpid()) + ".metrics";
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--scrapes=", 10) == 0) scrapes = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--socket=", 9) == 0) path = argv[i] + 9;
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto input = MakeInput(1 << 18);
+
+    // Instrumentation cost, no scraper running.
+    double plain = MeasureNsPerEvent(input.size(), 5, [&] { MapAll(input, nullptr); });
+    MetricsRegistry scratch;
+    ThreadMetrics* scratchBlock = scratch.Register();
+    double counted = MeasureNsPerEvent(input.size(), 5, [&] { MapAll(input, scratchBlock); });
+
+    MetricsRegistry registry;
+    ThreadMetrics* mapper = registry.Register();
+    MetricsServer server;
+    if (!server.Start(path, [&] { return registry.RenderPrometheus(); })) {
+        fprintf(stderr, "cannot listen on %s\n", path.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread load([&] {
+        while (!stop.load(std::memory_order_relaxed)) MapAll(input, mapper);
+    });
+
+    std::vector<uint64_t> scrapeNs;
+    uint64_t lastEvents = 0;
+    bool ok = true;
+    std::string body;
+    for (size_t i = 0; i < scrapes && ok; ++i) {
+        uint64_t t0 = NowNs();
+        if (!Scrape(path, body)) {
+            fprintf(stderr, "scrape %zu failed\n", i);
+            ok = false;
+            break;
+        }
+        scrapeNs.push_back(NowNs() - t0);
+        uint64_t events = Value(body, "cursor_mapper_events_total");
+        uint64_t count  = Value(body, "cursor_mapper_map_latency_seconds_count");
+        if (events == UINT64_MAX || count == UINT64_MAX || events < lastEvents ||
+            body.find("cursor_mapper_map_latency_seconds_bucket{le=\"+Inf\"}") == std::string::npos) {
+            fprintf(stderr, "scrape %zu malformed or went backwards\n", i);
+            ok = false;
+        }
+        lastEvents = events;
+    }
+    stop = true;
+    load.join();
+    server.Stop();
+
+    auto sp = ComputePercentiles(scrapeNs);
+    printf("metrics: %zu scrapes over %s while replaying\n", scrapeNs.size(), path.c_str());
+    PrintRow("map, no metrics", plain);
+    PrintRow("map, counters + histogram", counted);
+    printf("  scrape latency p50 %.1f us, p99 %.1f us, max %.1f us; %llu events seen\n",
+           sp.p50 / 1e3, sp.p99 / 1e3, sp.max / 1e3, static_cast<unsigned long long>(lastEvents));
+    if (ok) printf("--- last scrape ---\n%s", body.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,349 @@
+// Read -> decode -> map -> emit over the portable core, either run to
+// completion on one thread (the model inherited from the hook loop) or split
+// across pinned threads connected by SPSC queues.
+//
+//   bench_pipeline [--topology=rtc|pipelined|both] [--rate=EV_PER_SEC]
+//                  [--events=N] [--duration-ms=N] [--emit-ns=N] [--no-pin]
+//
+// Without --rate a sweep from unthrottled down to 8 kHz is run. Latency is
+// measured from the scheduled read time to emit, so a stage that falls
+// behind shows up as queueing delay rather than being hidden.
+//
+// The map stage includes CoalesceStage. Run to completion maps one report
+// at a time, so it never sees a backlog; the pipelined mapper pops up to a
+// batch at once and merges it when the decoder has run ahead. A merged
+// output is charged to every report it absorbed, from the oldest one's read.
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "spsc_queue.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- evdev-like raw stream ---
+
+static constexpr size_t BATCH = 64;  // queue pops, and reports mapped at once
+
+static constexpr uint16_t EV_SYN = 0, EV_REL = 2;
+static constexpr uint16_t REL_X = 0, REL_Y = 1, SYN_REPORT = 0;
+
+struct RawEvent {
+    uint64_t tsNs;
+    uint16_t type;
+    uint16_t code;
+    int32_t  value;
+};
+
+struct Stamped {
+    MotionSample s;
+    uint64_t     readNs;      // oldest report merged into s
+    uint32_t     covers = 1;  // reports merged into s
+};
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+};
+
+// Three raw events (REL_X, REL_Y, SYN_REPORT) per motion report.
+static std::vector<RawEvent> MakeRawStream(size_t motions) {
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<double> tx(0.0, 4480.0), ty(0.0, 1440.0);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+
+    std::vector<RawEvent> raw;
+    raw.reserve(motions * 3);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < motions; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        int dx = static_cast<int>(std::lround((targetX - x) * 0.08)) + jitter(rng);
+        int dy = static_cast<int>(std::lround((targetY - y) * 0.08)) + jitter(rng);
+        x += dx;
+        y += dy;
+        raw.push_back({0, EV_REL, REL_X, dx});
+        raw.push_back({0, EV_REL, REL_Y, dy});
+        raw.push_back({0, EV_SYN, SYN_REPORT, 0});
+    }
+    return raw;
+}
+
+// Sample time is the report's sequence number here rather than ms: reports
+// arrive far faster than 1 ms apart, and CoalesceStage only needs the sample
+// time and `now` in the same units. The time of a merged output is that of
+// the last report it absorbed, which is how the mapper finds what it covers.
+struct Decoder {
+    int32_t  accX = 0, accY = 0;
+    uint32_t seq  = 0;
+
+    // Returns true when a SYN_REPORT completes a motion report.
+    bool Feed(const RawEvent& ev, Stamped& out) {
+        if (ev.type == EV_REL) {
+            if (ev.code == REL_X) accX += ev.value;
+            else if (ev.code == REL_Y) accY += ev.value;
+            return false;
+        }
+        if (ev.type != EV_SYN || ev.code != SYN_REPORT) return false;
+        out.s      = {{0, 0}, static_cast<double>(accX), static_cast<double>(accY), seq++, 0};
+        out.readNs = ev.tsNs;
+        out.covers = 1;
+        accX = accY = 0;
+        return true;
+    }
+};
+
+using MapChain = Chain<SubPixelStage, CoalesceStage, EdgeRemapStage>;
+
+static constexpr uint32_t COALESCE_MAX_AGE = 64;  // reports
+
+static void InitMapper(MapChain& chain) {
+    chain.Get<SubPixelStage>().Reset({1280, 720});
+    chain.Get<CoalesceStage>().SetMonitors(kMonitors);
+    chain.Get<CoalesceStage>().maxAge = COALESCE_MAX_AGE;
+    chain.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+}
+
+// Maps s[0..n) (consecutive reports from the decoder) and rewrites it to the
+// outputs; returns their number.
+static size_t MapBatch(MapChain& chain, Stamped* s, size_t n) {
+    MotionSample samples[BATCH];
+    for (size_t i = 0; i < n; ++i) samples[i] = s[i].s;
+    chain.Get<CoalesceStage>().now = s[n - 1].s.time;
+    size_t out = chain.Process(samples, n);
+    uint32_t first = s[0].s.time;
+    size_t next = 0;  // first report not yet covered
+    for (size_t j = 0; j < out; ++j) {
+        size_t last = samples[j].time - first;
+        s[j].readNs = s[next].readNs;
+        s[j].covers = static_cast<uint32_t>(last + 1 - next);
+        s[j].s      = samples[j];
+        next        = last + 1;
+    }
+    return out;
+}
+
+struct Options {
+    std::string topology   = "both";
+    uint64_t    rate       = 0;   // 0 = sweep
+    size_t      events     = size_t{1} << 20;
+    uint64_t    durationMs = 300;
+    uint64_t    emitNs     = 0;   // simulated cost of issuing a warp
+    bool        pin        = true;
+};
+
+struct RunResult {
+    double      seconds;
+    Percentiles latency;
+};
+
+// Paces the reader: waits for motion i's slot and returns its timestamp.
+struct Pacer {
+    uint64_t start;
+    double   periodNs;  // 0 = unthrottled
+
+    uint64_t Wait(size_t i) const {
+        if (periodNs <= 0.0) return NowNs();
+        uint64_t due = start + static_cast<uint64_t>(periodNs * static_cast<double>(i));
+        while (NowNs() < due) CpuRelax();
+        return due;
+    }
+};
+
+static void Emit(const Stamped& st, uint64_t emitNs, std::vector<uint64_t>& lat) {
+    if (emitNs && (st.s.flags & MOTION_REMAPPED)) {
+        uint64_t until = NowNs() + emitNs;
+        while (NowNs() < until) CpuRelax();
+    }
+    lat.insert(lat.end(), st.covers, NowNs() - st.readNs);
+}
+
+// --- Run to completion: every stage inline on one thread ---
+
+static RunResult RunToCompletion(const std::vector<RawEvent>& raw, size_t motions,
+                                 uint64_t rate, const Options& opt)
+{
+    if (opt.pin) PinCurrentThread(0);
+    MapChain chain;
+    InitMapper(chain);
+    Decoder dec;
+    std::vector<uint64_t> lat;
+    lat.reserve(motions);
+
+    Pacer pacer{NowNs(), rate ? 1e9 / static_cast<double>(rate) : 0.0};
+    uint64_t t0 = NowNs();
+    for (size_t i = 0; i < motions; ++i) {
+        uint64_t ts = pacer.Wait(i);
+        for (size_t k = 0; k < 3; ++k) {
+            RawEvent ev = raw[i * 3 + k];
+            ev.tsNs = ts;
+            Stamped st;
+            if (dec.Feed(ev, st)) {
+                MapBatch(chain, &st, 1);
+                Emit(st, opt.emitNs, lat);
+            }
+        }
+    }
+    uint64_t t1 = NowNs();
+    return {static_cast<double>(t1 - t0) / 1e9, ComputePercentiles(lat)};
+}
+
+// --- Pipelined: read | decode | map | emit on four pinned threads ---
+
+template <typename T>
+static void PushBlocking(SpscQueue<T>& q, const T& v) {
+    SpinWait wait;
+    while (!q.TryPush(v)) wait();
+}
+
+static RunResult RunPipelined(const std::vector<RawEvent>& raw, size_t motions,
+                              uint64_t rate, const Options& opt)
+{
+    static constexpr size_t QUEUE_CAP = 4096;
+    SpscQueue<RawEvent> readQ(QUEUE_CAP);
+    SpscQueue<Stamped>  decodeQ(QUEUE_CAP);
+    SpscQueue<Stamped>  mapQ(QUEUE_CAP);
+
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    auto pin = [&](unsigned stage) { if (opt.pin) PinCurrentThread(stage % cpus); };
+
+    std::vector<uint64_t> lat;
+    lat.reserve(motions);
+    uint64_t t0 = NowNs();
+
+    std::thread reader([&] {
+        pin(0);
+        Pacer pacer{NowNs(), rate ? 1e9 / static_cast<double>(rate) : 0.0};
+        for (size_t i = 0; i < motions; ++i) {
+            uint64_t ts = pacer.Wait(i);
+            for (size_t k = 0; k < 3; ++k) {
+                RawEvent ev = raw[i * 3 + k];
+                ev.tsNs = ts;
+                PushBlocking(readQ, ev);
+            }
+        }
+    });
+
+    std::thread decoder([&] {
+        pin(1);
+        Decoder dec;
+        RawEvent buf[BATCH];
+        SpinWait wait;
+        for (size_t done = 0; done < motions;) {
+            size_t n = readQ.PopBatch(buf, BATCH);
+            if (!n) { wait(); continue; }
+            wait.Reset();
+            for (size_t i = 0; i < n; ++i) {
+                Stamped st;
+                if (dec.Feed(buf[i], st)) {
+                    PushBlocking(decodeQ, st);
+                    ++done;
+                }
+            }
+        }
+    });
+
+    std::thread mapper([&] {
+        pin(2);
+        MapChain chain;
+        InitMapper(chain);
+        Stamped buf[BATCH];
+        SpinWait wait;
+        for (size_t done = 0; done < motions;) {
+            size_t n = decodeQ.PopBatch(buf, BATCH);
+            if (!n) { wait(); continue; }
+            wait.Reset();
+            size_t out = MapBatch(chain, buf, n);
+            for (size_t i = 0; i < out; ++i) PushBlocking(mapQ, buf[i]);
+            done += n;
+        }
+    });
+
+    // Emitter runs on the calling thread.
+    pin(3);
+    Stamped buf[BATCH];
+    SpinWait wait;
+    for (size_t done = 0; done < motions;) {
+        size_t n = mapQ.PopBatch(buf, BATCH);
+        if (!n) { wait(); continue; }
+        wait.Reset();
+        for (size_t i = 0; i < n; ++i) {
+            Emit(buf[i], opt.emitNs, lat);
+            done += buf[i].covers;
+        }
+    }
+    uint64_t t1 = NowNs();
+
+    reader.join();
+    decoder.join();
+    mapper.join();
+    return {static_cast<double>(t1 - t0) / 1e9, ComputePercentiles(lat)};
+}
+
+static bool ParseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        auto value = [&](const char* key) -> const char* {
+            size_t len = strlen(key);
+            return strncmp(a, key, len) == 0 ? a + len : nullptr;
+        };
+        if (const char* v = value("--topology="))         opt.topology   = v;
+        else if (const char* v = value("--rate="))        opt.rate       = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--events="))      opt.events     = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--duration-ms=")) opt.durationMs = strtoull(v, nullptr, 10);
+        else if (const char* v = value("--emit-ns="))     opt.emitNs     = strtoull(v, nullptr, 10);
+        else if (strcmp(a, "--no-pin") == 0)              opt.pin        = false;
+        else {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return false;
+        }
+    }
+    if (opt.topology != "rtc" && opt.topology != "pipelined" && opt.topology != "both") {
+        fprintf(stderr, "--topology must be rtc, pipelined or both\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseOptions(argc, argv, opt)) return 2;
+
+    std::vector<uint64_t> rates;
+    if (opt.rate) rates.push_back(opt.rate);
+    else rates = {0, 1000000, 125000, 8000};
+
+    auto raw = MakeRawStream(opt.events);
+
+    printf("pipeline: %u cpus, emit cost %llu ns, pinning %s\n",
+           std::max(1u, std::thread::hardware_concurrency()),
+           static_cast<unsigned long long>(opt.emitNs), opt.pin ? "on" : "off");
+    printf("  %-10s %10s %10s %12s %10s %10s %10s %10s\n", "topology", "rate",
+           "events", "Mev/s", "p50 us", "p99 us", "p99.9 us", "max us");
+
+    for (uint64_t rate : rates) {
+        size_t motions = opt.events;
+        if (rate) motions = std::min<size_t>(motions, rate * opt.durationMs / 1000);
+        if (!motions) continue;
+
+        auto report = [&](const char* name, const RunResult& r) {
+            char rateStr[32];
+            if (rate) snprintf(rateStr, sizeof(rateStr), "%llu", static_cast<unsigned long long>(rate));
+            else snprintf(rateStr, sizeof(rateStr), "max");
+            printf("  %-10s %10s %10zu %12.2f %10.2f %10.2f %10.2f %10.2f\n", name, rateStr,
+                   motions, static_cast<double>(motions) / r.seconds / 1e6,
+                   r.latency.p50 / 1e3, r.latency.p99 / 1e3, r.latency.p999 / 1e3,
+                   r.latency.max / 1e3);
+        };
+        if (opt.topology != "pipelined") report("rtc", RunToCompletion(raw, motions, rate, opt));
+        if (opt.topology != "rtc") report("pipelined", RunPipelined(raw, motions, rate, opt));
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Many pointers on one layout: each of --pointers cursors follows its own
+// synthetic trajectory (trajectory.h), and their events are interleaved
+// into one stream in bursts, as an X server delivers motion from several
+// MPX master pointers. MultiPointerRemap maps the stream; every pointer's
+// output must equal mapping its trajectory alone (exit code 1 otherwise).
+// Also shows what one shared EdgeRemapStage would get wrong on the same
+// stream, and the cost per event against a single pointer.
+//
+//   bench_pointers [--pointers=N] [--samples=N] [--batch=N]
+
+#include "bench_common.h"
+#include "pointer_table.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr int REPS = 5;
+
+// A wall of displays with uneven neighbours, as in bench_mapping
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+struct Stream {
+    std::vector<MotionSample> samples;
+    std::vector<uint16_t>     devices;
+    std::vector<uint32_t>     index;  // position in the pointer's own trajectory
+};
+
+// Interleaves the trajectories in bursts of 1..maxBurst events per pointer.
+static Stream Interleave(const std::vector<std::vector<MotionSample>>& tracks, size_t maxBurst, uint32_t seed) {
+    Stream out;
+    std::vector<size_t> next(tracks.size(), 0);
+    size_t total = 0;
+    for (const auto& t : tracks) total += t.size();
+    out.samples.reserve(total);
+    out.devices.reserve(total);
+    out.index.reserve(total);
+    std::mt19937 rng(seed);
+    while (out.samples.size() < total) {
+        size_t p = rng() % tracks.size();
+        size_t burst = 1 + rng() % maxBurst;
+        for (size_t k = 0; k < burst && next[p] < tracks[p].size(); ++k, ++next[p]) {
+            out.samples.push_back(tracks[p][next[p]]);
+            out.devices.push_back(static_cast<uint16_t>(p + 2));  // XI2 ids 0 / 1 are reserved
+            out.index.push_back(static_cast<uint32_t>(next[p]));
+        }
+    }
+    return out;
+}
+
+static bool SameSample(const MotionSample& a, const MotionSample& b) {
+    return a.pos == b.pos && a.flags == b.flags;
+}
+
+int main(int argc, char** argv) {
+    size_t pointers = 16, samples = size_t{1} << 22, batch = 64;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--pointers=", 11) == 0) pointers = strtoull(argv[i] + 11, nullptr, 10);
+        else if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--batch=", 8) == 0) batch = std::max<size_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    pointers = std::clamp<size_t>(pointers, 1, PointerTable::MAX_POINTERS);
+
+    // One trajectory per pointer, and its output when mapped alone
+    const size_t chunk = size_t{1} << 14;
+    size_t chunks = std::max<size_t>(1, samples / pointers / chunk);
+    std::vector<std::vector<MotionSample>> tracks(pointers), alone(pointers);
+    for (size_t p = 0; p < pointers; ++p) {
+        TrajectoryConfig cfg;
+        cfg.monitors = kMonitors;
+        cfg.seed     = 43 + p;
+        tracks[p].resize(chunks * chunk);
+        uint32_t endMs = 0;
+        GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, tracks[p].data(), 1, endMs);
+        alone[p] = tracks[p];
+        EdgeRemapStage stage;
+        stage.SetMonitors(kMonitors);
+        stage.Process(alone[p].data(), alone[p].size());
+    }
+    size_t total = pointers * chunks * chunk;
+    printf("%zu pointers, %zu samples, batches of %zu events\n", pointers, total, batch);
+
+    // Single pointer, same total volume: the baseline per-event cost
+    {
+        std::vector<MotionSample> work(tracks[0].size());
+        double ns = MeasureNsPerEvent(work.size(), REPS, [&] {
+            EdgeRemapStage stage;
+            stage.SetMonitors(kMonitors);
+            std::copy(tracks[0].begin(), tracks[0].end(), work.begin());
+            for (size_t i = 0; i < work.size(); i += batch)
+                stage.Process(work.data() + i, std::min(batch, work.size() - i));
+        });
+        PrintRow("1 pointer, EdgeRemapStage", ns);
+    }
+
+    bool ok = true;
+    for (size_t burst : {size_t{1}, size_t{8}, size_t{64}}) {
+        Stream stream = Interleave(tracks, burst, static_cast<uint32_t>(burst));
+        std::vector<MotionSample> work(stream.samples.size());
+        MultiPointerRemap multi;
+        double ns = MeasureNsPerEvent(work.size(), REPS, [&] {
+            multi = MultiPointerRemap();
+            multi.SetMonitors(kMonitors);
+            std::copy(stream.samples.begin(), stream.samples.end(), work.begin());
+            for (size_t i = 0; i < work.size(); i += batch)
+                multi.Process(work.data() + i, stream.devices.data() + i, std::min(batch, work.size() - i));
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "%zu pointers, bursts <= %zu, per-pointer", pointers, burst);
+        PrintRow(name, ns);
+
+        size_t crossTalk = 0;
+        for (size_t i = 0; i < work.size(); ++i)
+            crossTalk += !SameSample(work[i], alone[stream.devices[i] - 2][stream.index[i]]);
+        if (crossTalk || multi.untracked) {
+            printf("    %zu samples differ from their pointer mapped alone, %llu untracked\n", crossTalk,
+                   static_cast<unsigned long long>(multi.untracked));
+            ok = false;
+        }
+
+        // What a single shared state makes of the same stream
+        std::copy(stream.samples.begin(), stream.samples.end(), work.begin());
+        EdgeRemapStage shared;
+        shared.SetMonitors(kMonitors);
+        shared.Process(work.data(), work.size());
+        size_t wrong = 0;
+        for (size_t i = 0; i < work.size(); ++i)
+            wrong += !SameSample(work[i], alone[stream.devices[i] - 2][stream.index[i]]);
+        printf("    one shared state instead: %zu of %zu samples mapped differently (%.2f%%)\n", wrong, work.size(),
+               100.0 * static_cast<double>(wrong) / static_cast<double>(work.size()));
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+// Per-portal remap strategies (remap_policy.h): for each strategy applied to
+// every portal, the cost of a crossing decision over segments across random
+// portals and of a synthetic replay (trajectory.h) through EdgeRemapStage,
+// next to the plain rect list, plus a layout mixing all strategies portal by
+// portal. Also reports how often each strategy moves the cursor and by how
+// much. Checks: "percent" through the policy table agrees with the rect
+// list on every call and sample, "pass-through" never remaps, "offset"
+// keeps the overlap in place, "clamped" stays within --max-jump, and every
+// entry point lies on the destination monitor; the same strategy promises
+// hold for crossings no portal covers (a step over a narrow monitor, a
+// diagonal corner) (exit code 1 otherwise).
+//
+//   bench_policies [--samples=N] [--calls=N] [--max-jump=PX]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "topology.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+static constexpr int REPS = 5;
+
+// Uneven sizes, offsets and a monitor stacked above, as in bench_shadow
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+// 27" 1440p, 24" 1080p portrait, 21.5" 1080p, 24" 1080p (mm per px)
+static const std::vector<double> kPitch = {0.2331, 0.2767, 0.2480, 0.2767};
+
+static const RemapStrategy kStrategies[] = {RemapStrategy::Percent, RemapStrategy::PassThrough,
+                                            RemapStrategy::Physical, RemapStrategy::Offset,
+                                            RemapStrategy::Clamped};
+
+struct Segment {
+    Point from, to;
+    int   src, dst;
+    long  coord;  // along-edge coordinate of from
+    int   portal;
+};
+
+// One short step across a random portal, from just inside src to just
+// inside dst
+static std::vector<Segment> MakeCrossings(const std::vector<TopologyPortal>& portals, size_t n) {
+    std::mt19937 rng(42);
+    std::vector<Segment> out(n);
+    for (auto& seg : out) {
+        seg.portal = static_cast<int>(rng() % portals.size());
+        const TopologyPortal& p = portals[seg.portal];
+        const Rect& a = kMonitors[p.src];
+        long along = p.overlapStart + static_cast<long>(rng() % static_cast<unsigned>(p.overlapEnd - p.overlapStart));
+        long in = 1 + static_cast<long>(rng() % 8), out2 = 1 + static_cast<long>(rng() % 8);
+        switch (p.edge) {
+        case Edge::Left:  seg.from = {a.left + in - 1, along};   seg.to = {a.left - out2, along};   break;
+        case Edge::Right: seg.from = {a.right - in, along};      seg.to = {a.right + out2 - 1, along}; break;
+        case Edge::Top:   seg.from = {along, a.top + in - 1};    seg.to = {along, a.top - out2};    break;
+        default:          seg.from = {along, a.bottom - in};     seg.to = {along, a.bottom + out2 - 1}; break;
+        }
+        seg.src   = p.src;
+        seg.dst   = p.dst;
+        seg.coord = along;
+    }
+    return out;
+}
+
+static bool SameDecision(const CrossingDecision& a, const CrossingDecision& b) {
+    return a.hit.edge == b.hit.edge && a.hit.t == b.hit.t && a.remapped == b.remapped && a.mapped == b.mapped;
+}
+
+static void Replay(const std::vector<MotionSample>& input, const PortalPolicyTable* table,
+                   std::vector<MotionSample>& out) {
+    std::copy(input.begin(), input.end(), out.begin());
+    EdgeRemapStage stage;
+    stage.SetMonitors(kMonitors);
+    if (table) stage.ProcessWith(PolicyTopology<>{kMonitors.data(), kMonitors.size(), table}, out.data(), out.size());
+    else stage.Process(out.data(), out.size());
+}
+
+// Strategy-specific promises over the crossing segments.
+static bool CheckDecisions(RemapStrategy strategy, const std::vector<Segment>& segs,
+                           const std::vector<CrossingDecision>& dec, const std::vector<CrossingDecision>& generic,
+                           const PortalPolicyTable& table) {
+    for (size_t i = 0; i < segs.size(); ++i) {
+        const Segment& s = segs[i];
+        const CrossingDecision& d = dec[i];
+        const PortalTransform& t = table.transforms[s.portal];
+        const char* why = nullptr;
+        long along = t.edge == Edge::Left || t.edge == Edge::Right ? d.mapped.y : d.mapped.x;
+        if (!Contains(kMonitors[s.dst], d.mapped)) why = "entry off the destination monitor";
+        else if (strategy == RemapStrategy::Percent && !SameDecision(d, generic[i])) why = "differs from the rect list";
+        else if (strategy == RemapStrategy::PassThrough && d.remapped) why = "pass-through remapped";
+        else if (strategy == RemapStrategy::Offset && along != std::clamp(s.coord, t.dstStart + 1, t.dstStart + t.dstLen - 2))
+            why = "offset moved a point inside the overlap";
+        else if (strategy == RemapStrategy::Clamped && std::abs(along - s.coord) > t.maxJump + 2)
+            why = "clamped jumped too far";
+        if (why) {
+            printf("    %s: %s at %zu (%ld,%ld)->(%ld,%ld) mapped (%ld,%ld)\n", RemapStrategyName(strategy), why, i,
+                   s.from.x, s.from.y, s.to.x, s.to.y, d.mapped.x, d.mapped.y);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Crossings without a portal: a step over a narrow middle monitor (src and
+// dst only line up in projection) and a diagonal one past a corner (no
+// overlap at all). Each strategy applies to them as to its portals.
+static bool CheckNonPortal(RemapStrategy strategy, long maxJump) {
+    static const std::vector<Rect> row = {{0, 0, 1920, 1080}, {1920, 0, 2560, 1080}, {2560, 100, 4480, 1180},
+                                          {1920, 1080, 2560, 1800}};
+    struct Case {
+        Point from, to;
+        int   src, dst;
+        bool  overlap;
+    };
+    static const Case cases[] = {
+        {{1900, 500}, {2600, 500}, 0, 2, true},   // skips monitor 1
+        {{1900, 50}, {2600, 150}, 0, 2, true},    // leaves above dst's top
+        {{3000, 600}, {1800, 600}, 2, 0, true},
+        {{1915, 1075}, {1925, 1085}, 0, 3, false},  // corner
+    };
+    PortalStrategyConfig config;
+    config.fallback = strategy;
+    config.maxJump  = maxJump;
+    PortalPolicyTable table = BuildPortalPolicies(row, BuildPortals(row), config, {0.2331, 0.1, 0.2767, 0.1});
+    const PolicyTopology<> topo{row.data(), row.size(), &table};
+    const RectListTopology generic{row.data(), row.size()};
+    for (const Case& c : cases) {
+        CrossingDecision d = topo.Cross(c.src, c.dst, c.from, c.to);
+        const char* why = nullptr;
+        if (!Contains(row[c.dst], d.mapped)) why = "entry off the destination monitor";
+        else if (!c.overlap && d.remapped) why = "remapped a corner";
+        else if (strategy == RemapStrategy::Percent && !SameDecision(d, generic.Cross(c.src, c.dst, c.from, c.to)))
+            why = "differs from the rect list";
+        else if (strategy == RemapStrategy::PassThrough && d.remapped) why = "pass-through remapped";
+        else if (strategy == RemapStrategy::Clamped && std::abs(d.mapped.y - c.from.y) > maxJump + 2)
+            why = "clamped jumped too far";
+        if (why) {
+            printf("    %s, no portal: %s (%ld,%ld)->(%ld,%ld) mapped (%ld,%ld)\n", RemapStrategyName(strategy), why,
+                   c.from.x, c.from.y, c.to.x, c.to.y, d.mapped.x, d.mapped.y);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Share of crossings remapped and their mean distance from the OS position.
+static void PrintMoves(const std::vector<Segment>& segs, const std::vector<CrossingDecision>& dec) {
+    size_t moved = 0;
+    double dist = 0.0;
+    for (size_t i = 0; i < segs.size(); ++i) {
+        if (!dec[i].remapped) continue;
+        ++moved;
+        dist += std::hypot(static_cast<double>(dec[i].mapped.x - segs[i].to.x),
+                           static_cast<double>(dec[i].mapped.y - segs[i].to.y));
+    }
+    printf("      %5.1f%% of crossings moved, by %.0f px on average\n",
+           100.0 * static_cast<double>(moved) / static_cast<double>(segs.size()),
+           moved ? dist / static_cast<double>(moved) : 0.0);
+}
+
+int main(int argc, char** argv) {
+    size_t samples = size_t{1} << 22, calls = size_t{1} << 20;
+    long maxJump = 240;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--calls=", 8) == 0) calls = std::max<size_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        else if (strncmp(argv[i], "--max-jump=", 11) == 0) maxJump = std::max(0L, strtol(argv[i] + 11, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<TopologyPortal> portals = BuildPortals(kMonitors);
+    std::vector<Segment> segs = MakeCrossings(portals, calls);
+    TrajectoryConfig cfg;
+    cfg.monitors = kMonitors;
+    cfg.seed     = 42;
+    const size_t chunk = size_t{1} << 16;
+    size_t chunks = std::max<size_t>(1, samples / chunk);
+    std::vector<MotionSample> input(chunks * chunk);
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, input.data(), 1, endMs);
+    printf("%zu monitors, %zu portals, %zu crossing calls, %zu replay samples\n", kMonitors.size(), portals.size(),
+           calls, input.size());
+
+    const RectListTopology generic{kMonitors.data(), kMonitors.size()};
+    std::vector<CrossingDecision> decGeneric(calls), dec(calls);
+    PrintRow("crossing, rect list", MeasureNsPerEvent(calls, REPS, [&] {
+        for (size_t i = 0; i < calls; ++i) decGeneric[i] = generic.Cross(segs[i].src, segs[i].dst, segs[i].from, segs[i].to);
+        DoNotOptimize(decGeneric.data());
+    }));
+    std::vector<MotionSample> outGeneric(input.size()), out(input.size());
+    PrintRow("replay, rect list", MeasureNsPerEvent(input.size(), REPS, [&] { Replay(input, nullptr, outGeneric); }));
+
+    bool ok = true;
+    auto run = [&](const char* name, const PortalStrategyConfig& config, RemapStrategy check) {
+        PortalPolicyTable table = BuildPortalPolicies(kMonitors, portals, config, kPitch);
+        const PolicyTopology<> topo{kMonitors.data(), kMonitors.size(), &table};
+        printf("  %s\n", name);
+        PrintRow("    crossing", MeasureNsPerEvent(calls, REPS, [&] {
+            for (size_t i = 0; i < calls; ++i) dec[i] = topo.Cross(segs[i].src, segs[i].dst, segs[i].from, segs[i].to);
+            DoNotOptimize(dec.data());
+        }));
+        PrintRow("    replay", MeasureNsPerEvent(input.size(), REPS, [&] { Replay(input, &table, out); }));
+        PrintMoves(segs, dec);
+        if (config.overrides.empty()) ok = CheckDecisions(check, segs, dec, decGeneric, table) && ok;
+        if (check == RemapStrategy::Percent && config.overrides.empty()) {
+            for (size_t i = 0; i < out.size(); ++i) {
+                if (out[i].pos != outGeneric[i].pos || out[i].flags != outGeneric[i].flags) {
+                    printf("    percent replay differs from the rect list at sample %zu\n", i);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        for (const MotionSample& s : out) {
+            if ((s.flags & MOTION_REMAPPED) && MonitorIndexFromPoint(kMonitors.data(), kMonitors.size(), s.pos) < 0) {
+                printf("    replay remapped off the desktop\n");
+                ok = false;
+                break;
+            }
+        }
+    };
+
+    for (RemapStrategy s : kStrategies) {
+        PortalStrategyConfig config;
+        config.fallback = s;
+        config.maxJump  = maxJump;
+        run(RemapStrategyName(s), config, s);
+        ok = CheckNonPortal(s, maxJump) && ok;
+    }
+    // Every strategy somewhere: the dispatch sees them all interleaved
+    PortalStrategyConfig mixed;
+    mixed.maxJump = maxJump;
+    for (size_t i = 0; i < portals.size(); ++i)
+        mixed.overrides.push_back({portals[i].src, portals[i].dst, kStrategies[i % std::size(kStrategies)]});
+    run("mixed, per portal", mixed, RemapStrategy::Percent);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+// Remote portals (remote_portal.h): protocol checks over an in-memory link
+// that duplicates, drops and reorders packets, then two sessions on UDP
+// loopback, each on its own thread as two daemons would be. Reports Ping
+// and hand-off (Enter -> Ack) round trips, and motion packets/s and
+// deltas/s by batch size with loss. Exit code 1 when a check fails or a
+// round trip never completes.
+//
+//   bench_portal [--pings=N] [--deltas=N] [--port=N]
+
+#include "bench_common.h"
+#include "remote_portal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static constexpr uint64_t WINDOW = 256;  // motion packets in flight
+
+static const std::vector<Rect> kLocal = {
+    {0, 0, 1920, 1080},
+    {1920, -200, 3840, 880},
+};
+static const std::vector<Rect> kRemote = {
+    {0, 0, 1920, 1080},
+    {0, 1080, 1920, 2160},
+};
+
+// --- In-memory link ---
+
+struct Link {
+    std::vector<std::vector<uint8_t>> packets;
+};
+
+static bool SendToLink(void* ctx, const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    static_cast<Link*>(ctx)->packets.emplace_back(p, p + size);
+    return true;
+}
+
+static bool CheckProtocol() {
+    bool ok = true;
+    auto check = [&](bool cond, const char* what) {
+        if (!cond) {
+            printf("    check failed: %s\n", what);
+            ok = false;
+        }
+    };
+
+    // Entry mapping: the outermost monitors on the entry side form the edge
+    Point p;
+    check(MapRemoteEntry(kLocal, Edge::Right, 0.5, p) && p == Point{3838, 340}, "right entry lands mid second monitor");
+    check(MapRemoteEntry(kRemote, Edge::Left, 0.75, p) && p == Point{1, 1620}, "left entry spans stacked monitors");
+    check(MapRemoteEntry(kRemote, Edge::Left, 0.0, p) && p == Point{1, 1}, "entry at 0 is inset");
+    check(OuterExitEdge(kLocal, 1, {3839, 100}, 5, 1) == Edge::Right, "push out of the right edge");
+    check(OuterExitEdge(kLocal, 0, {1919, 100}, 5, 0) == Edge::None, "local neighbour is not an exit");
+    check(OuterExitEdge(kLocal, 1, {3838, 100}, 5, 0) == Edge::None, "not on the edge pixel yet");
+    check(MapRemoteEntry(kRemote, Edge::Left, OuterEdgeFraction(kRemote, Edge::Left, {0, 1500}), p) &&
+              p == Point{1, 1500}, "fraction round trip");
+
+    Link aToB, bToA;
+    PortalSession a(Edge::Right, 1, SendToLink, &aToB, 4);
+    PortalSession b(Edge::Left, 2, SendToLink, &bToA, 4);
+    a.SetCursorHere(true);
+
+    // Hand-off, delivered twice: applied once, acked twice
+    a.HandOff(0.25, 1000);
+    aToB.packets.push_back(aToB.packets.back());
+    int entered = 0;
+    for (auto& pkt : aToB.packets) {
+        PortalSession::Event ev = b.OnPacket(pkt.data(), pkt.size(), kRemote, 2000);
+        entered += ev.kind == PortalSession::Event::Entered;
+        if (ev.kind == PortalSession::Event::Entered) check(ev.entry == Point{1, 540}, "entry at 25% of the left edge");
+    }
+    aToB.packets.clear();
+    check(entered == 1 && b.CursorHere() && !a.CursorHere(), "duplicate Enter applied once");
+    for (auto& pkt : bToA.packets) a.OnPacket(pkt.data(), pkt.size(), kLocal, 3000);
+    bToA.packets.clear();
+    check(a.Stats().rttSamples == 2, "both Enter copies acked");
+    a.Poll(1000 + PORTAL_RESEND_NS, 1000);
+    check(aToB.packets.empty(), "acked Enter is not resent");
+
+    // 5 motion packets of 4 deltas; drop #1, swap #3 and #4
+    for (int i = 0; i < 20; ++i) a.QueueMotion(1, -1, 4000);
+    check(aToB.packets.size() == 5, "batches of 4");
+    std::swap(aToB.packets[3], aToB.packets[4]);
+    aToB.packets.erase(aToB.packets.begin() + 1);
+    long sumX = 0;
+    for (auto& pkt : aToB.packets) {
+        PortalSession::Event ev = b.OnPacket(pkt.data(), pkt.size(), kRemote, 5000);
+        if (ev.kind == PortalSession::Event::Moved) sumX += ev.dx;
+    }
+    aToB.packets.clear();
+    const PortalStats& bs = b.Stats();
+    check(bs.motionLost == 2 && bs.motionLate == 1 && sumX == 12, "gap and late packet accounted");
+
+    // Oversized delta is split; partial batch flushed by age
+    a.QueueMotion(40000, 0, 6000);
+    a.Poll(6000 + 999, 1000);
+    check(aToB.packets.empty(), "young partial batch held");
+    a.Poll(6000 + 1000, 1000);
+    check(aToB.packets.size() == 1, "old partial batch flushed");
+
+    // Garbage
+    uint8_t junk[32] = {};
+    b.OnPacket(junk, sizeof(junk), kRemote, 7000);
+    check(b.Stats().rejected == 1, "bad magic rejected");
+    return ok;
+}
+
+// --- Loopback ---
+
+static bool SendToSocket(void* ctx, const void* data, size_t size) {
+    return static_cast<PortalSocket*>(ctx)->Send(data, size);
+}
+
+// The far daemon, on its own thread; publishes what it has applied so the
+// sender can rate each stream.
+struct Remote {
+    PortalSocket          sock;
+    std::atomic<bool>     stop{false};
+    std::atomic<uint64_t> packets{0}, deltas{0};
+    PortalStats           stats;  // final, after stop
+};
+
+static void RunRemote(Remote* r, uint16_t peerPort) {
+    r->sock.SetPeer("127.0.0.1", peerPort);
+    PortalSession session(Edge::Left, 2, SendToSocket, &r->sock);
+    session.SetCursorHere(true);
+    uint8_t buf[PORTAL_MAX_PACKET + 64];
+    while (!r->stop.load(std::memory_order_relaxed)) {
+        int n = r->sock.Recv(buf, sizeof(buf), 5);
+        if (n <= 0) continue;
+        session.OnPacket(buf, static_cast<size_t>(n), kRemote, NowNs());
+        r->packets.store(session.Stats().motionPackets, std::memory_order_relaxed);
+        r->deltas.store(session.Stats().motionDeltas, std::memory_order_relaxed);
+    }
+    r->stats = session.Stats();
+}
+
+// Waits for the next Pong / Ack; false after a second without one.
+static bool AwaitReply(PortalSocket& sock, PortalSession& session) {
+    uint8_t buf[PORTAL_MAX_PACKET + 64];
+    uint64_t before = session.Stats().rttSamples, deadline = NowNs() + 1000000000;
+    while (session.Stats().rttSamples == before) {
+        uint64_t now = NowNs();
+        if (now >= deadline) return false;
+        int n = sock.Recv(buf, sizeof(buf), static_cast<int>((deadline - now) / 1000000) + 1);
+        if (n > 0) session.OnPacket(buf, static_cast<size_t>(n), kLocal, NowNs());
+    }
+    return true;
+}
+
+static void PrintLatency(const char* name, std::vector<uint64_t>& ns) {
+    Percentiles p = ComputePercentiles(ns);
+    printf("  %-40s p50 %7.1f  p99 %7.1f  p99.9 %7.1f  max %8.1f us\n", name, p.p50 / 1000.0, p.p99 / 1000.0,
+           p.p999 / 1000.0, p.max / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    size_t pings = 20000, deltas = size_t{1} << 21;
+    unsigned long port = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--pings=", 8) == 0) pings = std::max<size_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        else if (strncmp(argv[i], "--deltas=", 9) == 0) deltas = std::max<size_t>(64, strtoull(argv[i] + 9, nullptr, 10));
+        else if (strncmp(argv[i], "--port=", 7) == 0) port = strtoul(argv[i] + 7, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    bool ok = CheckProtocol();
+    printf("protocol checks %s\n", ok ? "passed" : "FAILED");
+
+    PortalSocket local;
+    Remote remote;
+    if (!local.Open("127.0.0.1", static_cast<uint16_t>(port)) || !remote.sock.Open("127.0.0.1", 0)) {
+        printf("loopback socket unavailable: %s%s\n", local.Error(), remote.sock.Error());
+        return ok ? 0 : 1;
+    }
+    local.SetPeer("127.0.0.1", remote.sock.LocalPort());
+    printf("loopback %u <-> %u, %zu pings, %zu deltas per batch size\n", local.LocalPort(), remote.sock.LocalPort(),
+           pings, deltas);
+    std::thread far(RunRemote, &remote, local.LocalPort());
+
+    uint32_t sessionId = 1;
+    {
+        PortalSession session(Edge::Right, sessionId++, SendToSocket, &local);
+        std::vector<uint64_t> rtt, handoff;
+        rtt.reserve(pings);
+        for (size_t i = 0; i < pings && ok; ++i) {
+            session.Ping(NowNs());
+            if (!AwaitReply(local, session)) {
+                printf("    ping %zu timed out\n", i);
+                ok = false;
+            }
+            rtt.push_back(session.LastRttNs());
+        }
+        for (size_t i = 0; i < pings / 10 && ok; ++i) {
+            session.HandOff(static_cast<double>(i % 100) / 100.0, NowNs());
+            if (!AwaitReply(local, session)) {
+                printf("    hand-off %zu never acked\n", i);
+                ok = false;
+            }
+            handoff.push_back(session.LastRttNs());
+        }
+        if (ok) {
+            PrintLatency("Ping -> Pong", rtt);
+            PrintLatency("hand-off Enter -> Ack", handoff);
+        }
+    }
+
+    // Sustained rate: the sender stays at most WINDOW packets ahead of what
+    // the far side has applied (flat out, a sender on the same cores mostly
+    // measures receive-buffer drops)
+    for (size_t batch : {size_t{1}, size_t{16}, size_t{64}}) {
+        if (!ok) break;
+        PortalSession session(Edge::Right, sessionId++, SendToSocket, &local, batch);
+        uint64_t packets0 = remote.packets.load(), deltas0 = remote.deltas.load();
+        uint64_t t0 = NowNs();
+        for (size_t i = 0; i < deltas; ++i) {
+            session.QueueMotion(static_cast<long>(i & 7) - 3, 1, t0);
+            if (i % batch) continue;
+            // A lost packet never gets applied; give up waiting after 100 ms
+            for (uint64_t since = NowNs(); session.Stats().packetsSent - (remote.packets.load() - packets0) > WINDOW &&
+                                           NowNs() - since < 100000000;)
+                std::this_thread::yield();
+        }
+        session.Flush(t0);
+        uint64_t sent = session.Stats().packetsSent;
+        // Pong after the stream: everything before it has been handled (the
+        // Ping itself may be dropped, so retry)
+        bool synced = false;
+        for (int attempt = 0; attempt < 5 && !synced; ++attempt) {
+            session.Ping(NowNs());
+            synced = AwaitReply(local, session);
+        }
+        if (!synced) {
+            printf("    stream with batch %zu: no Pong\n", batch);
+            ok = false;
+            break;
+        }
+        double secs = static_cast<double>(NowNs() - t0) / 1e9;
+        uint64_t gotPackets = remote.packets.load() - packets0, gotDeltas = remote.deltas.load() - deltas0;
+        char name[64];
+        snprintf(name, sizeof(name), "motion, batch %zu", batch);
+        printf("  %-40s %10.0f packets/s %12.0f deltas/s delivered, %.2f%% lost\n", name,
+               static_cast<double>(gotPackets) / secs, static_cast<double>(gotDeltas) / secs,
+               100.0 * static_cast<double>(sent - gotPackets) / static_cast<double>(sent));
+    }
+
+    remote.stop.store(true);
+    far.join();
+    if (ok && remote.stats.motionLate) {
+        // Loopback keeps order
+        printf("    %llu motion packets arrived out of order on loopback\n",
+               static_cast<unsigned long long>(remote.stats.motionLate));
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
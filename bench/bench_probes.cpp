@@ -0,0 +1,196 @@
+// Cost of the USDT probes while no tracer is attached. Replays motion
+// through edge remapping, the echo table and periodic topology publishes,
+// so every probe site in the portal core sits on the measured path.
+//
+// CMake builds this file twice: bench_probes with probes compiled in (when
+// <sys/sdt.h> is available) and bench_probes_off with
+// CURSOR_MAPPER_NO_PROBES. bench_probes runs the _off twin next to it,
+// alternating rounds, and prints the difference. It also lists the probe
+// notes found in its own binary and fails if probes were expected but none
+// were emitted.
+//
+//   bench_probes [--baseline=PATH] [--rounds=N] [--raw]
+
+#include "bench_common.h"
+#include "echo_filter.h"
+#include "filter_chain.h"
+#include "topology.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <elf.h>
+#include <unistd.h>
+#endif
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+    {-1920, 0, 0, 1080},
+};
+
+static std::vector<MotionSample> MakeInput(size_t n) {
+    std::mt19937 rng(2718);
+    std::uniform_real_distribution<double> tx(-1920.0, 4480.0), ty(0.0, 1440.0), jitter(-1.0, 1.0);
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        double dx = (targetX - x) * 0.08 + jitter(rng);
+        double dy = (targetY - y) * 0.08 + jitter(rng);
+        x += dx;
+        y += dy;
+        out[i] = {{static_cast<long>(x), static_cast<long>(y)}, dx, dy, static_cast<uint32_t>(i), 0};
+    }
+    return out;
+}
+
+// One event at a time, shaped like HandleMove: echo check, topology
+// pickup, remap, then a recorded "warp" whose echo is consumed next event.
+static void Replay(const std::vector<MotionSample>& input, SnapshotPublisher& publisher) {
+    Chain<EdgeRemapStage> chain;
+    auto& remap = chain.Get<EdgeRemapStage>();
+    EchoTable echoes;
+    uint64_t version = 0;
+    bool pendingEcho = false;
+    Point echoAt{0, 0};
+    for (size_t i = 0; i < input.size(); ++i) {
+        if ((i & 0xffff) == 0) {
+            auto snap = std::make_unique<TopologySnapshot>();
+            snap->monitors = kMonitors;
+            publisher.Publish(std::move(snap));
+        }
+        uint32_t now = input[i].time;
+        if (pendingEcho) {
+            echoes.Consume(echoAt, now);
+            pendingEcho = false;
+        }
+        const TopologySnapshot* topo = publisher.Acquire();
+        if (topo && topo->version != version) {
+            remap.SetMonitors(topo->monitors);
+            version = topo->version;
+        }
+        MotionSample s = input[i];
+        chain.Process(&s, 1);
+        if (s.flags & MOTION_REMAPPED) {
+            echoes.Record(s.pos, now);
+            echoAt      = s.pos;
+            pendingEcho = true;
+        }
+        DoNotOptimize(s);
+    }
+}
+
+// Names of the stapsdt notes in this executable.
+static std::set<std::string> ProbeNotes() {
+    std::set<std::string> names;
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/exe", "rb");
+    if (!f) return names;
+    std::vector<char> image;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) image.insert(image.end(), buf, buf + n);
+    fclose(f);
+    if (image.size() < sizeof(Elf64_Ehdr)) return names;
+    const auto* eh = reinterpret_cast<const Elf64_Ehdr*>(image.data());
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shoff + static_cast<size_t>(eh->e_shnum) * sizeof(Elf64_Shdr) > image.size())
+        return names;
+    const auto* sh = reinterpret_cast<const Elf64_Shdr*>(image.data() + eh->e_shoff);
+    const char* shstr = image.data() + sh[eh->e_shstrndx].sh_offset;
+    for (unsigned i = 0; i < eh->e_shnum; ++i) {
+        if (strcmp(shstr + sh[i].sh_name, ".note.stapsdt") != 0) continue;
+        size_t off = sh[i].sh_offset, end = off + sh[i].sh_size;
+        while (off + sizeof(Elf64_Nhdr) <= end) {
+            const auto* nh = reinterpret_cast<const Elf64_Nhdr*>(image.data() + off);
+            size_t nameOff = off + sizeof(Elf64_Nhdr);
+            size_t descOff = nameOff + ((nh->n_namesz + 3) & ~3u);
+            // desc: pc, base, semaphore, then "provider\0name\0args\0"
+            if (nh->n_descsz > 3 * sizeof(uint64_t)) {
+                const char* provider = image.data() + descOff + 3 * sizeof(uint64_t);
+                names.insert(std::string(provider) + ":" + (provider + strlen(provider) + 1));
+            }
+            off = descOff + ((nh->n_descsz + 3) & ~3u);
+        }
+    }
+#endif
+    return names;
+}
+
+static double Measure(const std::vector<MotionSample>& input) {
+    SnapshotPublisher publisher;
+    return MeasureNsPerEvent(input.size(), 5, [&] { Replay(input, publisher); });
+}
+
+// Runs the baseline binary in --raw mode; negative on failure.
+static double RunBaseline(const std::string& path) {
+    std::string cmd = "\"" + path + "\" --raw";
+    FILE* p = popen(cmd.c_str(), "r");
+    if (!p) return -1.0;
+    double ns = -1.0;
+    if (fscanf(p, "%lf", &ns) != 1) ns = -1.0;
+    if (pclose(p) != 0) ns = -1.0;
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    std::string baseline = std::string(argv[0]) + "_off";
+    int rounds = 3;
+    bool raw = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--baseline=", 11) == 0) baseline = argv[i] + 11;
+        else if (strncmp(argv[i], "--rounds=", 9) == 0) rounds = atoi(argv[i] + 9);
+        else if (strcmp(argv[i], "--raw") == 0) raw = true;
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto input = MakeInput(1 << 18);
+    if (raw) {
+        printf("%.4f\n", Measure(input));
+        return 0;
+    }
+
+    auto notes = ProbeNotes();
+#if defined(CURSOR_MAPPER_HAVE_PROBES)
+    const bool expected = true;
+#else
+    const bool expected = false;
+#endif
+    printf("probes: %s, %zu site(s) in this binary\n",
+           expected ? "compiled in" : "compiled out (no <sys/sdt.h> or CURSOR_MAPPER_NO_PROBES)",
+           notes.size());
+    for (const auto& name : notes) printf("  %s\n", name.c_str());
+
+    // Alternate rounds so drift (thermal, neighbours) hits both sides alike
+    bool haveBaseline = false;
+    double self = 1e300, base = 1e300;
+    for (int r = 0; r < rounds; ++r) {
+        double ns = Measure(input);
+        if (ns < self) self = ns;
+        double b = RunBaseline(baseline);
+        if (b >= 0.0) {
+            haveBaseline = true;
+            if (b < base) base = b;
+        }
+    }
+    PrintRow("replay, this build", self);
+    if (haveBaseline) {
+        PrintRow("replay, probes compiled out", base);
+        printf("  difference %+.2f%%\n", (self - base) / base * 100.0);
+    } else {
+        printf("  no baseline at %s\n", baseline.c_str());
+    }
+    return expected && notes.empty() ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+// Recorded traces (trace_format.h) through the hook path, event by event as
+// HandleMove runs it: echo table, snapshot acquire, EdgeRemapStage over the
+// trace's own layout (through the portal policy table when --strategy is
+// not percent), metrics block and latency histogram. Every warp is looped
+// back as the echo the OS would deliver. Without FILEs a synthetic trace
+// (trajectory.h) is replayed.
+//
+// This is the workload the PGO training run (cursor_mapper_pgo_train)
+// profiles, so it is also where a PGO / LTO build shows what it bought:
+// --baseline=PATH runs another build's bench_replay in --raw mode on the
+// same traces, alternating rounds, and prints the difference. Checks: each
+// warp's echo is consumed, and the baseline remaps exactly as many events
+// as this build (exit code 1 otherwise).
+//
+//   bench_replay [--baseline=PATH] [--rounds=N] [--strategy=NAME] [--perf]
+//                [--raw] [FILE...]
+
+#include "bench_common.h"
+#include "echo_filter.h"
+#include "filter_chain.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "topology.h"
+#include "trace_format.h"
+#include "trajectory.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define popen  _popen
+#define pclose _pclose
+#endif
+
+// Set by CMake from CURSOR_MAPPER_PGO / CURSOR_MAPPER_LTO
+#if !defined(CURSOR_MAPPER_BUILD_LABEL)
+#define CURSOR_MAPPER_BUILD_LABEL "plain"
+#endif
+
+static constexpr size_t SYNTHETIC_CHUNKS = 32;
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+struct Trace {
+    std::string              name;
+    MappedFile               map;
+    std::vector<TraceRecord> owned;  // synthetic trace
+    std::vector<Rect>        monitors;
+    const TraceRecord*       records = nullptr;
+    size_t                   count   = 0;
+};
+
+static std::unique_ptr<Trace> LoadTrace(const std::string& path) {
+    auto t = std::make_unique<Trace>();
+    const char* why = "cannot open";
+    if (!t->map.Open(path) || t->map.Size() < sizeof(TraceHeader) ||
+        !ValidateTraceHeader(*reinterpret_cast<const TraceHeader*>(t->map.Data()), t->map.Size(), &why)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), why);
+        return nullptr;
+    }
+    t->name     = path;
+    t->monitors = TraceMonitors(*reinterpret_cast<const TraceHeader*>(t->map.Data()));
+    t->records  = reinterpret_cast<const TraceRecord*>(t->map.Data() + sizeof(TraceHeader));
+    t->count    = static_cast<size_t>(TraceRecordCount(t->map.Size()));
+    return t;
+}
+
+static std::unique_ptr<Trace> SyntheticTrace() {
+    auto t = std::make_unique<Trace>();
+    TrajectoryConfig cfg;
+    cfg.monitors = kMonitors;
+    cfg.seed     = 42;
+    const size_t chunk = size_t{1} << 16;
+    t->owned.resize(SYNTHETIC_CHUNKS * chunk);
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, SYNTHETIC_CHUNKS, chunk, t->owned.data(), 1, endMs);
+    t->name     = "synthetic";
+    t->monitors = kMonitors;
+    t->records  = t->owned.data();
+    t->count    = t->owned.size();
+    return t;
+}
+
+struct ReplayResult {
+    uint64_t remaps = 0;
+    uint64_t echoes = 0;
+};
+
+// One pass over a trace as the hook sees it.
+static void Replay(const Trace& t, const PortalStrategyConfig& strategies, ReplayResult& res) {
+    SnapshotPublisher publisher;
+    auto snap = std::make_unique<TopologySnapshot>();
+    snap->monitors = t.monitors;
+    snap->portals  = BuildPortals(snap->monitors);
+    snap->policies = BuildPortalPolicies(snap->monitors, snap->portals, strategies);
+    publisher.Publish(std::move(snap));
+
+    EdgeRemapStage remap;
+    EchoTable echoes;
+    ThreadMetrics hook;
+    uint64_t seenVersion = 0;
+    const TopologySnapshot* policyTopo = nullptr;
+
+    // HandleMove, minus the OS; true when the event was replaced by a warp
+    auto handle = [&](Point pt, uint32_t now) {
+        MetricsUpdate update(&hook);
+        LatencyScope timing(&hook.mapLatency);
+        if (echoes.Consume(pt, now)) {
+            hook.echoes.Add();
+            return false;
+        }
+        const TopologySnapshot* topo = publisher.Acquire();
+        if (topo && topo->version != seenVersion) {
+            remap.SetMonitors(topo->monitors);
+            seenVersion = topo->version;
+            policyTopo  = topo->policies.Custom() ? topo : nullptr;
+        }
+        MotionSample sample{pt, static_cast<double>(pt.x - remap.lastPos.x),
+                            static_cast<double>(pt.y - remap.lastPos.y), now, 0};
+        if (policyTopo) {
+            const auto& mons = policyTopo->monitors;
+            remap.ProcessWith(PolicyTopology<>{mons.data(), mons.size(), &policyTopo->policies}, &sample, 1);
+        } else {
+            remap.Process(&sample, 1);
+        }
+        hook.CountSample(sample);
+        if (!(sample.flags & MOTION_REMAPPED)) return false;
+        echoes.Record(sample.pos, now);
+        hook.remaps.Add();
+        return true;
+    };
+
+    for (size_t i = 0; i < t.count; ++i) {
+        const TraceRecord& r = t.records[i];
+        // The warp's echo arrives next
+        if (handle({r.x, r.y}, r.time)) handle(remap.lastPos, r.time);
+    }
+    res.remaps += hook.remaps.Load();
+    res.echoes += hook.echoes.Load();
+}
+
+static BenchResult MeasureReplay(const std::vector<std::unique_ptr<Trace>>& traces,
+                                 const PortalStrategyConfig& strategies, uint64_t events, int rounds,
+                                 ReplayResult& res) {
+    return Measure(events, rounds, [&] {
+        res = {};
+        for (const auto& t : traces) Replay(*t, strategies, res);
+    });
+}
+
+// Runs the baseline binary in --raw mode on the same input; false on failure.
+static bool RunBaseline(const std::string& path, const std::string& args, double& ns, uint64_t& remaps,
+                        std::string& label) {
+    std::string cmd = "\"" + path + "\" --raw --rounds=2" + args;
+    FILE* p = popen(cmd.c_str(), "r");
+    if (!p) return false;
+    unsigned long long r = 0;
+    char buf[128] = {};
+    bool ok = fscanf(p, "%lf %llu %127[^\n]", &ns, &r, buf) == 3;
+    if (pclose(p) != 0) ok = false;
+    remaps = r;
+    label  = buf;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::string baseline, args;
+    int rounds = 3;
+    bool raw = false, perf = false;
+    PortalStrategyConfig strategies;
+    std::vector<std::unique_ptr<Trace>> traces;
+    // Input options and files are passed on to the baseline
+    auto passOn = [&](const char* a) { args += std::string(" \"") + a + "\""; };
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline = argv[i] + 11;
+        } else if (strncmp(argv[i], "--rounds=", 9) == 0) {
+            rounds = std::max(1, atoi(argv[i] + 9));
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            raw = true;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;
+        } else if (strncmp(argv[i], "--strategy=", 11) == 0) {
+            if (!ParseRemapStrategy(argv[i] + 11, strategies.fallback)) {
+                fprintf(stderr, "unknown strategy: %s\n", argv[i] + 11);
+                return 2;
+            }
+            passOn(argv[i]);
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        } else {
+            auto t = LoadTrace(argv[i]);
+            if (!t) return 2;
+            traces.push_back(std::move(t));
+            passOn(argv[i]);
+        }
+    }
+    if (perf && !raw) EnableBenchPerf();
+    if (traces.empty()) traces.push_back(SyntheticTrace());
+    uint64_t events = 0;
+    for (const auto& t : traces) events += t->count;
+
+    ReplayResult res;
+    if (raw) {
+        BenchResult r = MeasureReplay(traces, strategies, events, rounds, res);
+        printf("%.4f %llu %s\n", r.ns, static_cast<unsigned long long>(res.remaps), CURSOR_MAPPER_BUILD_LABEL);
+        return res.echoes == res.remaps ? 0 : 1;
+    }
+
+    printf("replay: %zu trace(s), %llu events, strategy %s, build %s\n", traces.size(),
+           static_cast<unsigned long long>(events), RemapStrategyName(strategies.fallback), CURSOR_MAPPER_BUILD_LABEL);
+    for (const auto& t : traces)
+        printf("  %s: %zu monitors, %zu events\n", t->name.c_str(), t->monitors.size(), t->count);
+
+    // Alternate rounds so drift (thermal, neighbours) hits both sides alike
+    BenchResult self;
+    self.ns = 1e300;
+    double base = 1e300;
+    uint64_t baseRemaps = 0;
+    std::string baseLabel;
+    bool haveBaseline = false, ok = true;
+    for (int r = 0; r < rounds; ++r) {
+        BenchResult m = MeasureReplay(traces, strategies, events, 2, res);
+        if (m.ns < self.ns) self = m;
+        double ns = 0.0;
+        if (!baseline.empty() && RunBaseline(baseline, args, ns, baseRemaps, baseLabel)) {
+            haveBaseline = true;
+            if (ns < base) base = ns;
+        }
+    }
+    printf("  %llu remaps, %llu echoes consumed\n", static_cast<unsigned long long>(res.remaps),
+           static_cast<unsigned long long>(res.echoes));
+    if (res.echoes != res.remaps) {
+        printf("  ECHOES NOT CONSUMED\n");
+        ok = false;
+    }
+    std::string selfRow = std::string("replay, this build (") + CURSOR_MAPPER_BUILD_LABEL + ")";
+    PrintRow(selfRow.c_str(), self);
+    if (haveBaseline) {
+        std::string baseRow = "replay, baseline (" + baseLabel + ")";
+        PrintRow(baseRow.c_str(), base);
+        printf("  difference %+.2f%% (%.2fx)\n", (self.ns - base) / base * 100.0, base / self.ns);
+        if (baseRemaps != res.remaps) {
+            printf("  baseline remapped %llu events, this build %llu\n",
+                   static_cast<unsigned long long>(baseRemaps), static_cast<unsigned long long>(res.remaps));
+            ok = false;
+        }
+    } else if (!baseline.empty()) {
+        printf("  no baseline at %s\n", baseline.c_str());
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Shadow evaluation under replay: synthetic motion (trajectory.h) runs
+// through EdgeRemapStage while every crossing is handed to a
+// ShadowEvaluator, once per built-in candidate. Reports how often each
+// candidate diverges and how, its cost next to the live implementation,
+// the first divergences, and what submitting costs the mapping thread.
+// The "live" control must never diverge (exit code 1 if it does).
+//
+//   bench_shadow [--samples=N] [--rate=HZ] [--queue=N] [--show=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "shadow.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static constexpr int REPS = 3;
+
+// Uneven sizes, offsets and a monitor stacked above, as in bench_mapping
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, -240, 3640, 1680},
+    {-1920, 180, 0, 1260},
+    {640, -1080, 2560, 0},
+};
+
+struct Replay {
+    ShadowEvaluator* shadow = nullptr;
+    const std::vector<Rect>* monitors = nullptr;
+    ThreadMetrics hook;  // mapping-thread counters (dropped)
+};
+
+static void OnCrossing(void* ctx, const CrossingInfo& c) {
+    auto& r = *static_cast<Replay*>(ctx);
+    if (!r.shadow) return;
+    const auto& mons = *r.monitors;
+    CrossingDecision live{{c.edge, c.t, 0.0}, c.remapped, c.mapped};
+    if (!r.shadow->Submit({mons[c.src], mons[c.dst], c.from, c.to, c.src, c.dst, live, c.time}))
+        r.hook.shadowDropped.Add();
+}
+
+struct DivergenceLog {
+    size_t show = 3;
+    std::vector<ShadowDivergence> first;
+};
+
+static void OnDivergence(void* ctx, const ShadowDivergence& d) {
+    auto& log = *static_cast<DivergenceLog*>(ctx);
+    if (log.first.size() < log.show) log.first.push_back(d);
+}
+
+int main(int argc, char** argv) {
+    size_t samples = size_t{1} << 23, queue = 1024, show = 3;
+    double rate = 1000.0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--rate=", 7) == 0) rate = atof(argv[i] + 7);
+        else if (strncmp(argv[i], "--queue=", 8) == 0) queue = strtoull(argv[i] + 8, nullptr, 10);
+        else if (strncmp(argv[i], "--show=", 7) == 0) show = strtoull(argv[i] + 7, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    TrajectoryConfig cfg;
+    cfg.monitors = kMonitors;
+    cfg.pollHz   = rate;
+    cfg.seed     = 38;
+    const size_t chunk = size_t{1} << 16;
+    size_t chunks = std::max<size_t>(1, samples / chunk);
+    std::vector<MotionSample> input(chunks * chunk), work(input.size());
+    uint32_t endMs = 0;
+    GenerateTrajectory(TrajectoryGenerator(cfg), 0, chunks, chunk, input.data(), 1, endMs);
+
+    printf("shadow replay: %zu samples at %.0f Hz (%.0f s of motion), %zu monitors, queue %zu\n",
+           input.size(), rate, endMs / 1000.0, kMonitors.size(), queue);
+
+    auto replay = [&](Replay& r) {
+        Chain<EdgeRemapStage> chain;
+        auto& stage = chain.Get<EdgeRemapStage>();
+        stage.SetMonitors(kMonitors);
+        stage.onCrossing  = OnCrossing;
+        stage.crossingCtx = &r;
+        std::copy(input.begin(), input.end(), work.begin());
+        chain.Process(work.data(), work.size());
+    };
+
+    Replay off;
+    off.monitors = &kMonitors;
+    double offNs = MeasureNsPerEvent(input.size(), REPS, [&] { replay(off); });
+    PrintRow("replay, shadow off", offNs);
+
+    bool controlClean = true;
+    for (const auto& cand : SHADOW_CANDIDATES) {
+        ThreadMetrics shadowMetrics;
+        DivergenceLog log;
+        log.show = show;
+        ShadowEvaluator shadow(queue);
+        shadow.Start(cand.fn, &shadowMetrics, OnDivergence, &log);
+        Replay on;
+        on.shadow   = &shadow;
+        on.monitors = &kMonitors;
+
+        uint64_t t0 = NowNs();
+        replay(on);
+        double onNs = static_cast<double>(NowNs() - t0) / static_cast<double>(input.size());
+        shadow.Drain();
+        shadow.Stop();
+
+        char name[64];
+        snprintf(name, sizeof(name), "replay, shadow %s", cand.name);
+        PrintRow(name, onNs);
+
+        const ThreadMetrics& m = shadowMetrics;
+        uint64_t diverged = m.shadowEdgeDiffs.Load() + m.shadowRemapDiffs.Load() + m.shadowPositionDiffs.Load();
+        uint64_t calls = std::max<uint64_t>(1, m.shadowTimedCalls.Load());
+        printf("    %llu evaluated, %llu dropped, %llu diverged (edge %llu, remap %llu, position %llu); "
+               "live %.1f ns, candidate %.1f ns per call\n",
+               static_cast<unsigned long long>(m.shadowEvaluated.Load()),
+               static_cast<unsigned long long>(on.hook.shadowDropped.Load()),
+               static_cast<unsigned long long>(diverged),
+               static_cast<unsigned long long>(m.shadowEdgeDiffs.Load()),
+               static_cast<unsigned long long>(m.shadowRemapDiffs.Load()),
+               static_cast<unsigned long long>(m.shadowPositionDiffs.Load()),
+               static_cast<double>(m.shadowLiveNs.Load()) / calls,
+               static_cast<double>(m.shadowCandidateNs.Load()) / calls);
+        for (const auto& d : log.first) {
+            const ShadowCrossing& c = d.crossing;
+            printf("    %-8s %d->%d (%ld,%ld)->(%ld,%ld): live %s (%ld,%ld), candidate %s (%ld,%ld)\n",
+                   ShadowDiffName(d.kind), c.srcIndex, c.dstIndex, c.from.x, c.from.y, c.to.x, c.to.y,
+                   EdgeName(c.live.hit.edge), c.live.mapped.x, c.live.mapped.y,
+                   EdgeName(d.candidate.hit.edge), d.candidate.mapped.x, d.candidate.mapped.y);
+        }
+        if (cand.fn == MapCrossing && diverged) controlClean = false;
+    }
+    if (!controlClean) printf("live control diverged from the applied decisions\n");
+    return controlClean ? 0 : 1;
+}
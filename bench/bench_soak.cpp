@@ -0,0 +1,357 @@
+// Soak run of the daemon's portable core over compressed simulated time.
+// The mapping thread replays synthetic motion (trajectory.h) event by event
+// as HandleMove does: snapshot acquire, EdgeRemapStage over the rect list
+// or the portal policy table, echo table, metrics block and latency
+// histogram. A topology thread publishes a new layout every --change-s
+// simulated seconds, cycling through layouts with and without custom portal
+// strategies, as refreshes would. The input is paced only by the simulated
+// clock, so hours of 1 kHz motion take seconds.
+//
+// Every --interval-min simulated minutes it samples RSS, live and new heap
+// allocations, mean and p99 hook latency of the interval and the largest
+// snapshot reclamation backlog. After a warm-up share of the intervals, a
+// least-squares trend over each series must not grow by more than its
+// allowance across the run (exit code 1 otherwise). Options leaving fewer
+// than three intervals after the warm-up are rejected (exit code 2).
+//
+//   bench_soak [--hours=H] [--rate=HZ] [--change-s=S] [--interval-min=M]
+//              [--max-growth=PCT] [--latency-growth=PCT] [--max-backlog=N]
+
+#include "bench_common.h"
+#include "echo_filter.h"
+#include "filter_chain.h"
+#include "metrics.h"
+#include "topology.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+static std::atomic<uint64_t> g_allocs{0}, g_frees{0};
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept {
+    if (p) g_frees.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+static constexpr size_t CHUNK         = size_t{1} << 16;
+static constexpr size_t CHUNKS        = 4;     // input per layout, replayed in a loop
+static constexpr double WARMUP_SHARE  = 0.2;   // intervals ignored by the trend checks
+
+// Layouts the topology thread cycles through: docking, a monitor dropping
+// out, a resolution change, the stacked monitor moving
+static const std::vector<std::vector<Rect>> kLayouts = {
+    {{0, 0, 2560, 1440}, {2560, -240, 3640, 1680}, {-1920, 180, 0, 1260}, {640, -1080, 2560, 0}},
+    {{0, 0, 2560, 1440}, {2560, -240, 3640, 1680}},
+    {{0, 0, 1920, 1080}, {1920, 0, 3840, 1080}, {-1920, 0, 0, 1080}},
+    {{0, 0, 2560, 1440}, {2560, 0, 4480, 1080}, {-1920, 180, 0, 1260}, {0, -1080, 1920, 0}},
+    {{0, 0, 3840, 2160}},
+};
+
+static uint64_t RssBytes() {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long long pages = 0, resident = 0;
+    int n = fscanf(f, "%llu %llu", &pages, &resident);
+    fclose(f);
+    return n == 2 ? resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+// Plain copy of a histogram, to difference against the next one.
+struct HistogramCounts {
+    uint64_t buckets[LATENCY_BUCKETS + 1] = {};
+    uint64_t sumNs = 0, count = 0;
+
+    explicit HistogramCounts(const LatencyHistogram& h) {
+        for (size_t i = 0; i <= LATENCY_BUCKETS; ++i) buckets[i] = h.buckets[i].Load();
+        sumNs = h.sumNs.Load();
+        count = h.count.Load();
+    }
+};
+
+// Upper bound of the bucket holding quantile q of what b recorded since a
+// (0 when empty; the +Inf bucket reports twice the last bound).
+static uint64_t QuantileBoundNs(const HistogramCounts& a, const HistogramCounts& b, double q) {
+    uint64_t count = b.count - a.count;
+    if (!count) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count));
+    uint64_t seen = 0, bound = LATENCY_FIRST_NS;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i, bound <<= 1) {
+        seen += b.buckets[i] - a.buckets[i];
+        if (seen > rank) return bound;
+    }
+    return bound;
+}
+
+struct Interval {
+    double   simHours;
+    uint64_t events;
+    double   eventsPerSec;  // wall clock
+    double   rssMb;
+    double   liveAllocs;    // allocations not yet freed
+    double   newAllocs;     // in this interval
+    double   meanNs, p99Ns;
+    double   backlog;       // largest retired-snapshot count after a publish
+};
+
+// Relative growth of the least-squares line through v[from..] across its
+// span, against the series' mean (or `floor`, whichever is larger).
+static double TrendGrowth(const std::vector<Interval>& rows, size_t from, double Interval::*field, double floor) {
+    size_t n = rows.size() - from;
+    if (n < 3) return 0.0;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double x = static_cast<double>(i), y = rows[from + i].*field;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return slope * static_cast<double>(n - 1) / std::max(sy / static_cast<double>(n), floor);
+}
+
+struct Topology {
+    SnapshotPublisher      publisher;
+    std::atomic<uint64_t>  simMs{0};       // mapping thread's clock
+    std::atomic<uint64_t>  maxBacklog{0};  // since the last interval sample
+    std::atomic<uint64_t>  changes{0};
+    std::atomic<bool>      stop{false};
+    uint64_t               changeMs = 10000;
+    PortalStrategyConfig   strategies;     // used on every other layout
+    ThreadMetrics          metrics;
+
+    size_t LayoutAt(uint64_t ms) const { return (ms / changeMs) % kLayouts.size(); }
+
+    std::unique_ptr<TopologySnapshot> MakeSnapshot(uint64_t change) {
+        MetricsUpdate update(&metrics);
+        metrics.refreshes.Add();
+        metrics.publishes.Add();
+        auto snap = std::make_unique<TopologySnapshot>();
+        snap->monitors = kLayouts[change % kLayouts.size()];
+        snap->portals  = BuildPortals(snap->monitors);
+        snap->policies = BuildPortalPolicies(snap->monitors, snap->portals,
+                                             change % 2 ? strategies : PortalStrategyConfig{});
+        return snap;
+    }
+
+    void RecordBacklog() {
+        uint64_t backlog = publisher.RetiredCount();
+        uint64_t seen = maxBacklog.load(std::memory_order_relaxed);
+        while (backlog > seen && !maxBacklog.compare_exchange_weak(seen, backlog, std::memory_order_relaxed)) {}
+    }
+
+    // Topology thread: one publish per change period of simulated time, and
+    // never two without the mapping thread acquiring in between. A thread
+    // scheduled late publishes the latest due change once instead of the
+    // whole burst it missed, so the backlog reflects reclamation, not the
+    // scheduler.
+    void Run(uint64_t published) {
+        for (uint64_t change = 1; !stop.load(std::memory_order_relaxed);) {
+            uint64_t due = simMs.load(std::memory_order_acquire) / changeMs;
+            if (due < change || publisher.ReaderVersion() < published) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                continue;
+            }
+            published = publisher.Publish(MakeSnapshot(due));
+            RecordBacklog();
+            change = due + 1;
+            changes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    double hours = 24.0, rate = 1000.0, changeS = 10.0, intervalMin = 30.0;
+    double maxGrowth = 10.0, latencyGrowth = 50.0;
+    uint64_t maxBacklog = 4;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--hours=", 8) == 0) hours = atof(argv[i] + 8);
+        else if (strncmp(argv[i], "--rate=", 7) == 0) rate = std::clamp(atof(argv[i] + 7), 125.0, 8000.0);
+        else if (strncmp(argv[i], "--change-s=", 11) == 0) changeS = std::max(0.01, atof(argv[i] + 11));
+        else if (strncmp(argv[i], "--interval-min=", 15) == 0) intervalMin = std::max(0.1, atof(argv[i] + 15));
+        else if (strncmp(argv[i], "--max-growth=", 13) == 0) maxGrowth = atof(argv[i] + 13);
+        else if (strncmp(argv[i], "--latency-growth=", 17) == 0) latencyGrowth = atof(argv[i] + 17);
+        else if (strncmp(argv[i], "--max-backlog=", 14) == 0) maxBacklog = strtoull(argv[i] + 14, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    const uint64_t totalEvents    = static_cast<uint64_t>(hours * 3600.0 * rate);
+    const uint64_t intervalEvents = std::max<uint64_t>(1, static_cast<uint64_t>(intervalMin * 60.0 * rate));
+    // A run too short for the trend checks would pass with nothing checked
+    const size_t intervals = static_cast<size_t>(totalEvents / intervalEvents);
+    const size_t trended   = intervals - static_cast<size_t>(static_cast<double>(intervals) * WARMUP_SHARE);
+    if (trended < 3) {
+        fprintf(stderr, "%zu intervals after warm-up, trends need 3; lengthen --hours or shorten --interval-min\n",
+                trended);
+        return 2;
+    }
+
+    // Input per layout, generated up front so the soak measures mapping only
+    std::vector<std::vector<MotionSample>> inputs(kLayouts.size());
+    for (size_t l = 0; l < kLayouts.size(); ++l) {
+        TrajectoryConfig cfg;
+        cfg.monitors = kLayouts[l];
+        cfg.pollHz   = rate;
+        cfg.seed     = 100 + l;
+        inputs[l].resize(CHUNKS * CHUNK);
+        uint32_t endMs = 0;
+        GenerateTrajectory(TrajectoryGenerator(cfg), 0, CHUNKS, CHUNK, inputs[l].data(), 1, endMs);
+    }
+
+    Topology topo;
+    topo.changeMs            = static_cast<uint64_t>(changeS * 1000.0);
+    topo.strategies.fallback = RemapStrategy::Offset;
+    topo.strategies.overrides.push_back({0, 1, RemapStrategy::Clamped});
+    uint64_t first = topo.publisher.Publish(topo.MakeSnapshot(0));
+    std::thread topoThread([&] { topo.Run(first); });
+
+    printf("soak: %.1f simulated hours at %.0f Hz (%llu events), layout change every %.1f s, sample every %.1f min\n",
+           hours, rate, static_cast<unsigned long long>(totalEvents), changeS, intervalMin);
+    printf("  %8s %12s %10s %8s %8s %9s %8s %8s %7s\n", "sim h", "events", "M ev/s", "RSS MB", "live", "allocs",
+           "mean ns", "p99 <=", "backlog");
+
+    EdgeRemapStage remap;
+    EchoTable echoes;
+    ThreadMetrics hook;
+    uint64_t seenVersion = 0;
+    const TopologySnapshot* policyTopo = nullptr;
+    std::vector<Interval> rows;
+    HistogramCounts last(hook.mapLatency);  // at the previous sample
+    uint64_t lastAllocs = g_allocs.load(), lastEvents = 0, wall0 = NowNs();
+    size_t cursor = 0, layout = 0;
+
+    for (uint64_t ev = 0; ev < totalEvents; ++ev) {
+        uint64_t simMs = ev * 1000 / static_cast<uint64_t>(rate);
+        if ((ev & 1023) == 0) {
+            topo.simMs.store(simMs, std::memory_order_release);
+            // Hand movement follows the layout the schedule says is live
+            size_t want = topo.LayoutAt(simMs);
+            if (want != layout) {
+                layout = want;
+                cursor = 0;
+            }
+        }
+        MotionSample in = inputs[layout][cursor];
+        cursor = cursor + 1 == inputs[layout].size() ? 0 : cursor + 1;
+        in.time  = static_cast<uint32_t>(simMs);
+        in.flags = 0;
+
+        // HandleMove, minus the OS
+        {
+            MetricsUpdate update(&hook);
+            LatencyScope timing(&hook.mapLatency);
+            if (!echoes.Consume(in.pos, in.time)) {
+                const TopologySnapshot* snap = topo.publisher.Acquire();
+                if (snap && snap->version != seenVersion) {
+                    remap.SetMonitors(snap->monitors);
+                    seenVersion = snap->version;
+                    policyTopo  = snap->policies.Custom() ? snap : nullptr;
+                }
+                if (policyTopo) {
+                    const auto& mons = policyTopo->monitors;
+                    remap.ProcessWith(PolicyTopology<>{mons.data(), mons.size(), &policyTopo->policies}, &in, 1);
+                } else {
+                    remap.Process(&in, 1);
+                }
+                hook.CountSample(in);
+                if (in.flags & MOTION_REMAPPED) {
+                    echoes.Record(in.pos, in.time);
+                    hook.remaps.Add();
+                }
+            } else {
+                hook.echoes.Add();
+            }
+        }
+        // The warp's echo arrives next
+        if (in.flags & MOTION_REMAPPED) echoes.Consume(in.pos, in.time);
+
+        if ((ev + 1) % intervalEvents == 0) {
+            HistogramCounts h(hook.mapLatency);
+            uint64_t count = h.count - last.count;
+            uint64_t allocs = g_allocs.load(std::memory_order_relaxed);
+            uint64_t now = NowNs();
+            Interval row;
+            row.simHours     = static_cast<double>(ev + 1) / rate / 3600.0;
+            row.events       = ev + 1 - lastEvents;
+            row.eventsPerSec = static_cast<double>(row.events) * 1e9 / static_cast<double>(now - wall0);
+            row.rssMb        = static_cast<double>(RssBytes()) / (1 << 20);
+            row.liveAllocs   = static_cast<double>(allocs - g_frees.load(std::memory_order_relaxed));
+            row.newAllocs    = static_cast<double>(allocs - lastAllocs);
+            row.meanNs       = count ? static_cast<double>(h.sumNs - last.sumNs) / count : 0.0;
+            row.p99Ns        = static_cast<double>(QuantileBoundNs(last, h, 0.99));
+            row.backlog      = static_cast<double>(topo.maxBacklog.exchange(0, std::memory_order_relaxed));
+            rows.push_back(row);
+            printf("  %8.2f %12llu %10.2f %8.1f %8.0f %9.0f %8.1f %8.0f %7.0f\n", row.simHours,
+                   static_cast<unsigned long long>(row.events), row.eventsPerSec / 1e6, row.rssMb, row.liveAllocs,
+                   row.newAllocs, row.meanNs, row.p99Ns, row.backlog);
+            fflush(stdout);
+            last       = h;
+            lastAllocs = allocs;
+            lastEvents = ev + 1;
+            wall0      = now;
+        }
+    }
+    topo.stop = true;
+    topoThread.join();
+
+    printf("  %llu events, %llu crossings, %llu remaps, %llu topology changes\n",
+           static_cast<unsigned long long>(hook.events.Load()), static_cast<unsigned long long>(hook.crossings.Load()),
+           static_cast<unsigned long long>(hook.remaps.Load()),
+           static_cast<unsigned long long>(topo.changes.load()));
+
+    // Trends after the warm-up
+    bool ok = true;
+    size_t from = static_cast<size_t>(static_cast<double>(rows.size()) * WARMUP_SHARE);
+    struct Check {
+        const char* name;
+        double Interval::*field;
+        double floor;   // smallest mean the growth is measured against
+        double limit;   // %
+    };
+    const Check checks[] = {
+        {"RSS", &Interval::rssMb, 1.0, maxGrowth},
+        {"live allocations", &Interval::liveAllocs, 64.0, maxGrowth},
+        {"allocations per interval", &Interval::newAllocs, 64.0, maxGrowth},
+        {"mean latency", &Interval::meanNs, 1.0, latencyGrowth},
+        {"p99 latency", &Interval::p99Ns, 1.0, latencyGrowth},
+        {"reclamation backlog", &Interval::backlog, 1.0, 100.0},  // about one snapshot
+    };
+    for (const Check& c : checks) {
+        double growth = 100.0 * TrendGrowth(rows, from, c.field, c.floor);
+        bool pass = growth <= c.limit;
+        printf("  trend %-26s %+8.2f%% (limit %+.0f%%)%s\n", c.name, growth, c.limit, pass ? "" : "  FAILED");
+        ok = ok && pass;
+    }
+    double worstBacklog = 0.0;
+    for (const Interval& r : rows) worstBacklog = std::max(worstBacklog, r.backlog);
+    if (worstBacklog > static_cast<double>(maxBacklog)) {
+        printf("  reclamation backlog reached %.0f snapshots (limit %llu)\n", worstBacklog,
+               static_cast<unsigned long long>(maxBacklog));
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+// Refresh-to-ready time of one in-process refresh, with and without the
+// persisted topology cache (topology_cache.h). Process launch is not
+// included. Each run starts from the enumerated rects and the signature
+// string, as RefreshMonitors has them, and ends when the first crossing is
+// mapped on the published snapshot:
+//   derive: build rects + portal graph, publish, map
+//   cache:  map the file for the signature hash, validate, copy, publish, map
+// The cache file is written once per layout beforehand (that write happens
+// after publishing in cursor_mapper, so it is reported but not counted).
+// The file stays in the page cache between runs, as it does across a quick
+// restart.
+//
+//   bench_startup [--runs=N] [--dir=DIR]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "topology_cache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Rows of four 1920x1080 monitors, alternate rows shifted by half a screen
+// so every monitor has several portals
+static std::vector<Rect> MakeLayout(size_t count) {
+    std::vector<Rect> mons;
+    for (size_t i = 0; i < count; ++i) {
+        long row = static_cast<long>(i / 4), col = static_cast<long>(i % 4);
+        long x = col * 1920 + (row & 1) * 960, y = row * 1080;
+        mons.push_back({x, y, x + 1920, y + 1080});
+    }
+    return mons;
+}
+
+// Same shape as BuildTopoSignature in main.cpp
+static std::string MakeSignature(const std::vector<Rect>& mons) {
+    std::string sig;
+    for (size_t i = 0; i < mons.size(); ++i) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%ld,%ld,%ld,%ld,%d,\\\\.\\DISPLAY%zu;", mons[i].left, mons[i].top,
+                 mons[i].right, mons[i].bottom, i == 0, i + 1);
+        sig += buf;
+    }
+    return sig;
+}
+
+// Publishes snap and maps one sample across the first portal; returns
+// whether the crossing was applied (the run is only valid if it was).
+static bool PublishAndMap(SnapshotPublisher& pub, std::unique_ptr<TopologySnapshot> snap) {
+    pub.Publish(std::move(snap));
+    const TopologySnapshot* topo = pub.Acquire();
+    Chain<EdgeRemapStage> chain;
+    auto& remap = chain.Get<EdgeRemapStage>();
+    remap.SetMonitors(topo->monitors);
+    const TopologyPortal& p = topo->portals.front();
+    const Rect& src = topo->monitors[p.src];
+    long along = (p.overlapStart + p.overlapEnd) / 2;
+    Point from, to;
+    switch (p.edge) {
+    case Edge::Left:  from = {src.left, along};       to = {src.left - 1, along};   break;
+    case Edge::Right: from = {src.right - 1, along};  to = {src.right, along};      break;
+    case Edge::Top:   from = {along, src.top};        to = {along, src.top - 1};    break;
+    default:          from = {along, src.bottom - 1}; to = {along, src.bottom};     break;
+    }
+    MotionSample s[2] = {{from, 0, 0, 0, 0}, {to, 0, 0, 1, 0}};
+    chain.Process(s, 2);
+    DoNotOptimize(s);
+    return (s[1].flags & MOTION_CROSSING) != 0;
+}
+
+int main(int argc, char** argv) {
+    size_t runs = 2000;
+    std::string dir = ".";
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--runs=", 7) == 0) runs = std::max<size_t>(1, strtoull(argv[i] + 7, nullptr, 10));
+        else if (strncmp(argv[i], "--dir=", 6) == 0) dir = argv[i] + 6;
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("startup, refresh to first mapped crossing: %zu runs per row, cache in %s\n", runs, dir.c_str());
+    bool ok = true;
+    for (size_t count : {2, 4, 8, 16, 32, 64}) {
+        std::vector<Rect> rects = MakeLayout(count);
+        std::string sig = MakeSignature(rects);
+        uint64_t hash = TopologySignatureHash(sig);
+        std::string path = TopologyCachePath(dir, hash);
+
+        TopologySnapshot seed;
+        seed.monitors = rects;
+        seed.portals  = BuildPortals(rects);
+        uint64_t w0 = NowNs();
+        if (!WriteTopologyCache(path, hash, seed)) {
+            printf("cannot write %s\n", path.c_str());
+            return 1;
+        }
+        uint64_t writeNs = NowNs() - w0;
+
+        std::vector<uint64_t> derive, cache;
+        derive.reserve(runs);
+        cache.reserve(runs);
+        for (size_t r = 0; r < runs; ++r) {
+            SnapshotPublisher pub;
+            uint64_t t0 = NowNs();
+            auto snap = std::make_unique<TopologySnapshot>();
+            snap->monitors = rects;
+            snap->portals  = BuildPortals(snap->monitors);
+            ok &= PublishAndMap(pub, std::move(snap));
+            derive.push_back(NowNs() - t0);
+
+            SnapshotPublisher pub2;
+            t0 = NowNs();
+            const char* why = nullptr;
+            uint64_t h = TopologySignatureHash(sig);
+            auto loaded = LoadTopologyCache(dir, h, &why);
+            if (!loaded) {
+                printf("cache rejected: %s\n", why);
+                return 1;
+            }
+            ok &= PublishAndMap(pub2, std::move(loaded));
+            cache.push_back(NowNs() - t0);
+        }
+
+        Percentiles d = ComputePercentiles(derive), c = ComputePercentiles(cache);
+        printf("  %2zu monitors, %3zu portals: derive p50 %7.2f us p99 %7.2f us | cache p50 %7.2f us p99 %7.2f us"
+               " | write %.1f us\n",
+               count, seed.portals.size(), d.p50 / 1e3, d.p99 / 1e3, c.p50 / 1e3, c.p99 / 1e3, writeNs / 1e3);
+        remove(path.c_str());
+    }
+    if (!ok) printf("a run did not map its crossing\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Shared stats region under load: a mapping thread replays motion with the
+// hook's instrumentation into blocks that live in a shm region, while
+// reader threads map the same region read-only and snapshot it as fast as
+// they can. Every snapshot must be internally consistent (per-event
+// counters agree with each other) and never go backwards; the writer's
+// per-event cost is compared with and without readers.
+//
+//   bench_stats_shm [--readers=N] [--duration-ms=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "stats_shm.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+    {-1920, 0, 0, 1080},
+};
+
+static std::vector<MotionSample> MakeInput(size_t n) {
+    std::mt19937 rng(4242);
+    std::uniform_real_distribution<double> tx(-1920.0, 4480.0), ty(0.0, 1440.0), jitter(-1.0, 1.0);
+    std::vector<MotionSample> out(n);
+    double x = 1280.0, y = 720.0, targetX = x, targetY = y;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::abs(targetX - x) < 4.0 && std::abs(targetY - y) < 4.0) {
+            targetX = tx(rng);
+            targetY = ty(rng);
+        }
+        double dx = (targetX - x) * 0.08 + jitter(rng);
+        double dy = (targetY - y) * 0.08 + jitter(rng);
+        x += dx;
+        y += dy;
+        out[i] = {{static_cast<long>(x), static_cast<long>(y)}, dx, dy, static_cast<uint32_t>(i), 0};
+    }
+    return out;
+}
+
+static void OnCrossing(void* ctx, const CrossingInfo& c) {
+    static_cast<ThreadMetrics*>(ctx)->CountPortal(c.src, c.dst);
+}
+
+// Replays input once, instrumented exactly like HandleMove. Returns events.
+static size_t MapAll(const std::vector<MotionSample>& input, ThreadMetrics* m) {
+    Chain<EdgeRemapStage> chain;
+    auto& remap = chain.Get<EdgeRemapStage>();
+    remap.SetMonitors(kMonitors);
+    remap.onCrossing  = OnCrossing;
+    remap.crossingCtx = m;
+    size_t done = 0;
+    for (const auto& in : input) {
+        MetricsUpdate update(m);
+        LatencyScope timing(&m->mapLatency);
+        MotionSample s = in;
+        chain.Process(&s, 1);
+        m->CountSample(s);
+        if (s.flags & MOTION_REMAPPED) m->remaps.Add();
+        DoNotOptimize(s);
+        ++done;
+    }
+    return done;
+}
+
+// Invariants that only hold if no update was observed half-applied.
+static bool Consistent(const ThreadMetrics& t) {
+    uint64_t events = t.events.Load();
+    if (t.fastPath.Load() + t.offscreen.Load() + t.crossings.Load() != events) return false;
+    if (t.mapLatency.count.Load() != events) return false;
+    uint64_t buckets = 0;
+    for (size_t i = 0; i <= LATENCY_BUCKETS; ++i) buckets += t.mapLatency.buckets[i].Load();
+    return buckets == events;
+}
+
+struct ReaderResult {
+    uint64_t snapshots = 0;
+    uint64_t torn      = 0;  // gave up after retries
+    uint64_t bad       = 0;  // inconsistent or went backwards
+    std::vector<uint64_t> ns;
+};
+
+static double WriterNsPerEvent(const std::vector<MotionSample>& input, ThreadMetrics* m,
+                               unsigned durationMs) {
+    uint64_t t0 = NowNs(), events = 0;
+    while (NowNs() - t0 < durationMs * 1000000ull) events += MapAll(input, m);
+    return static_cast<double>(NowNs() - t0) / static_cast<double>(events);
+}
+
+int main(int argc, char** argv) {
+    unsigned readers = 2, durationMs = 1000;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--readers=", 10) == 0) readers = static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10));
+        else if (strncmp(argv[i], "--duration-ms=", 14) == 0) durationMs = static_cast<unsigned>(strtoul(argv[i] + 14, nullptr, 10));
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::string name = "/cursor_mapper_bench." + std::to_string(getpid());
+    StatsRegion writer;
+    if (!writer.Create(name)) {
+        fprintf(stderr, "cannot create %s: %s\n", name.c_str(), writer.Error());
+        return 1;
+    }
+    MetricsRegistry registry;
+    registry.UseStorage(writer.Blocks(), STATS_SLOTS);
+    ThreadMetrics* quiet = registry.Register();
+    ThreadMetrics* mapper = registry.Register();
+
+    auto input = MakeInput(1 << 16);
+    double alone = WriterNsPerEvent(input, quiet, durationMs / 2);
+
+    std::atomic<bool> stop{false};
+    std::vector<ReaderResult> results(readers);
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            StatsRegion region;
+            if (!region.Open(name)) {
+                results[r].bad = 1;
+                return;
+            }
+            ReaderResult& res = results[r];
+            uint64_t lastEvents = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint64_t t0 = NowNs();
+                ThreadMetrics snap;
+                bool ok = region.Header().magic.load(std::memory_order_acquire) == STATS_MAGIC &&
+                          region.Blocks()[1].SnapshotInto(snap);
+                if (res.ns.size() < 1000000) res.ns.push_back(NowNs() - t0);
+                ++res.snapshots;
+                if (!ok) {
+                    ++res.torn;
+                    continue;
+                }
+                if (!Consistent(snap) || snap.events.Load() < lastEvents) ++res.bad;
+                lastEvents = snap.events.Load();
+            }
+        });
+    }
+
+    double contended = WriterNsPerEvent(input, mapper, durationMs);
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    // One more read through the CLI path: totals across every slot
+    StatsRegion cli;
+    ThreadMetrics total;
+    bool cliOk = cli.Open(name) && cli.Total(total) == 0 && Consistent(total);
+
+    printf("stats shm: %s, %u reader(s), %u ms\n", name.c_str(), readers, durationMs);
+    PrintRow("writer, no readers", alone);
+    PrintRow("writer, readers snapshotting", contended);
+    bool ok = cliOk;
+    std::vector<uint64_t> all;
+    uint64_t snapshots = 0, torn = 0, bad = 0;
+    for (auto& r : results) {
+        snapshots += r.snapshots;
+        torn += r.torn;
+        bad += r.bad;
+        all.insert(all.end(), r.ns.begin(), r.ns.end());
+    }
+    auto p = ComputePercentiles(all);
+    printf("  %llu snapshots (%.0f/s per reader), snapshot p50 %.0f ns, p99 %.0f ns\n",
+           static_cast<unsigned long long>(snapshots),
+           readers ? static_cast<double>(snapshots) / readers / (durationMs / 1e3) : 0.0, p.p50, p.p99);
+    printf("  gave up (writer mid-update): %llu, inconsistent: %llu, final totals %s\n",
+           static_cast<unsigned long long>(torn), static_cast<unsigned long long>(bad),
+           cliOk ? "consistent" : "WRONG");
+    ok = ok && bad == 0;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// Topology snapshot hand-off: a writer thread publishes alternating layouts
+// while the mapping thread keeps mapping events and picks snapshots up with
+// SnapshotPublisher::Acquire. Reports time from publish to the first event
+// mapped on the new layout, mapping-thread per-event cost with and without
+// concurrent publishes, and the reclamation backlog.
+//
+//   bench_topology [--publishes=N] [--interval-us=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "topology.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const std::vector<Rect> kLayoutA = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+};
+static const std::vector<Rect> kLayoutB = {
+    {0, 0, 1920, 1080},
+    {-2560, -360, 0, 1080},
+    {1920, 0, 3840, 2160},
+};
+
+static std::vector<Point> MakePoints(size_t n) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<long> px(-2560, 4479), py(-360, 2159);
+    std::vector<Point> pts(n);
+    for (auto& p : pts) p = {px(rng), py(rng)};
+    return pts;
+}
+
+int main(int argc, char** argv) {
+    size_t publishes = 2000;
+    uint64_t intervalUs = 500;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--publishes=", 12) == 0) publishes = strtoull(argv[i] + 12, nullptr, 10);
+        else if (strncmp(argv[i], "--interval-us=", 14) == 0) intervalUs = strtoull(argv[i] + 14, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    SnapshotPublisher pub;
+    auto first = std::make_unique<TopologySnapshot>();
+    first->monitors = kLayoutA;
+    pub.Publish(std::move(first));
+
+    // publishNs[v] = when version v went live; versions start at 1.
+    std::vector<std::atomic<uint64_t>> publishNs(publishes + 2);
+    std::vector<uint64_t> pickup;
+    pickup.reserve(publishes);
+    std::vector<uint64_t> quietCost, busyCost;
+    std::atomic<bool> writerRunning{false}, stop{false};
+    size_t maxBacklog = 0;
+
+    auto points = MakePoints(1 << 16);
+    std::thread reader([&] {
+        Chain<EdgeRemapStage> chain;
+        auto& remap = chain.Get<EdgeRemapStage>();
+        uint64_t seen = 0;
+        size_t i = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint64_t t0 = NowNs();
+            const TopologySnapshot* topo = pub.Acquire();
+            if (topo->version != seen) {
+                remap.SetMonitors(topo->monitors);
+                seen = topo->version;
+                if (seen > 1) pickup.push_back(NowNs() - publishNs[seen].load(std::memory_order_acquire));
+            }
+            MotionSample s{points[i++ & 0xFFFF], 0, 0, 0, 0};
+            chain.Process(&s, 1);
+            uint64_t t1 = NowNs();
+            DoNotOptimize(s);
+            auto& costs = writerRunning.load(std::memory_order_relaxed) ? busyCost : quietCost;
+            if (costs.size() < 4000000) costs.push_back(t1 - t0);
+        }
+    });
+
+    // Quiet phase, then publishes every intervalUs.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    writerRunning = true;
+    for (size_t k = 0; k < publishes; ++k) {
+        auto snap = std::make_unique<TopologySnapshot>();
+        snap->monitors = (k & 1) ? kLayoutA : kLayoutB;
+        // Stamp before the swap so the reader never sees an unset time.
+        publishNs[k + 2].store(NowNs(), std::memory_order_release);
+        pub.Publish(std::move(snap));
+        maxBacklog = std::max(maxBacklog, pub.RetiredCount());
+        std::this_thread::sleep_for(std::chrono::microseconds(intervalUs));
+    }
+    writerRunning = false;
+    stop = true;
+    reader.join();
+    size_t finalBacklog = pub.Reclaim();
+
+    auto pick  = ComputePercentiles(pickup);
+    auto quiet = ComputePercentiles(quietCost);
+    auto busy  = ComputePercentiles(busyCost);
+    printf("topology hand-off: %zu publishes every %llu us, %zu picked up\n", publishes,
+           static_cast<unsigned long long>(intervalUs), pickup.size());
+    printf("  %-28s %10s %10s %10s %10s\n", "", "p50 us", "p99 us", "p99.9 us", "max us");
+    auto row = [](const char* name, const Percentiles& p) {
+        printf("  %-28s %10.3f %10.3f %10.3f %10.3f\n", name, p.p50 / 1e3, p.p99 / 1e3,
+               p.p999 / 1e3, p.max / 1e3);
+    };
+    row("publish -> new mapping", pick);
+    row("event cost, no publishes", quiet);
+    row("event cost, publishing", busy);
+    printf("  retired backlog: max %zu, after final reclaim %zu\n", maxBacklog, finalBacklog);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Synthetic trajectory generator (trajectory.h): samples per second into
+// replay buffers at each polling rate and thread count, a check that the
+// output is the same for every thread count, and a profile of what the
+// generated motion looks like to the mapper (crossings, samples pinned to
+// an edge, the largest step between samples including chunk joins).
+//
+//   bench_trajectory [--samples=N] [--threads=N] [--seed=N]
+
+#include "bench_common.h"
+#include "filter_chain.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static constexpr int    REPS  = 3;
+static constexpr size_t CHUNK = size_t{1} << 16;
+
+static const std::vector<Rect> kMonitors = {
+    {0, 0, 2560, 1440},
+    {2560, 200, 4480, 1280},
+    {-1920, 0, 0, 1080},
+};
+
+static bool OnEdge(const std::vector<Rect>& mons, Point p) {
+    for (const auto& m : mons) {
+        if (!Contains(m, p)) continue;
+        return p.x == m.left || p.x == m.right - 1 || p.y == m.top || p.y == m.bottom - 1;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = size_t{1} << 24;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--samples=", 10) == 0) samples = strtoull(argv[i] + 10, nullptr, 10);
+        else if (strncmp(argv[i], "--threads=", 10) == 0) maxThreads = std::max(1u, static_cast<unsigned>(atoi(argv[i] + 10)));
+        else if (strncmp(argv[i], "--seed=", 7) == 0) seed = strtoull(argv[i] + 7, nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    size_t chunks = std::max<size_t>(1, samples / CHUNK);
+    samples = chunks * CHUNK;
+
+    std::vector<MotionSample> reference(samples), out(samples);
+    printf("trajectory generator: %zu samples, chunk %zu, %zu monitors\n", samples, CHUNK, kMonitors.size());
+    bool identical = true;
+    for (double hz : {125.0, 1000.0, 8000.0}) {
+        TrajectoryConfig cfg;
+        cfg.monitors = kMonitors;
+        cfg.pollHz   = hz;
+        cfg.seed     = seed;
+        TrajectoryGenerator gen(cfg);
+        uint32_t endMs = 0;
+        GenerateTrajectory(gen, 0, chunks, CHUNK, reference.data(), 1, endMs);
+
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            double ns = MeasureNsPerEvent(samples, REPS, [&] {
+                uint32_t t = 0;
+                GenerateTrajectory(gen, 0, chunks, CHUNK, out.data(), threads, t);
+                DoNotOptimize(out.back());
+            });
+            bool same = memcmp(out.data(), reference.data(), samples * sizeof(MotionSample)) == 0;
+            identical = identical && same;
+            char name[48];
+            snprintf(name, sizeof(name), "%5.0f Hz, %u thread(s)%s", hz, threads, same ? "" : " MISMATCH");
+            printf("  %-40s %8.2f ns/sample  %8.1f M samples/s\n", name, ns, 1e3 / ns);
+        }
+
+        Chain<EdgeRemapStage> chain;
+        chain.Get<EdgeRemapStage>().SetMonitors(kMonitors);
+        std::copy(reference.begin(), reference.end(), out.begin());
+        chain.Process(out.data(), out.size());
+        uint64_t crossings = 0, edge = 0;
+        double maxStep = 0.0, maxJoin = 0.0;
+        for (size_t i = 0; i < samples; ++i) {
+            crossings += (out[i].flags & MOTION_CROSSING) != 0;
+            edge += OnEdge(kMonitors, reference[i].pos);
+            if (!i) continue;
+            double step = std::hypot(double(reference[i].pos.x - reference[i - 1].pos.x),
+                                     double(reference[i].pos.y - reference[i - 1].pos.y));
+            maxStep = std::max(maxStep, step);
+            if (i % CHUNK == 0) maxJoin = std::max(maxJoin, step);
+        }
+        printf("  %.1f s of motion; %.1f crossings/s, %.2f%% of samples on an edge, "
+               "max step %.0f px (chunk joins %.0f px)\n",
+               endMs / 1000.0, crossings * 1000.0 / endMs, 100.0 * edge / samples, maxStep, maxJoin);
+    }
+    printf("output %s across thread counts\n", identical ? "identical" : "DIFFERS");
+    return identical ? 0 : 1;
+}
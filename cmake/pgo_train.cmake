@@ -0,0 +1,68 @@
+# Training run of a CURSOR_MAPPER_PGO=GENERATE build (target
+# cursor_mapper_pgo_train): replays a trace corpus through the instrumented
+# binaries, then merges the raw profiles where the toolchain needs it.
+# Invoked as `cmake -D... -P pgo_train.cmake` with:
+#
+#   PGO_DIR    profile directory (CURSOR_MAPPER_PGO_DIR)
+#   CORPUS     directory of recorded *.trace files; empty: a synthetic corpus
+#   GEN        cursor_mapper_gen
+#   REPLAY     bench_replay (hook path)
+#   ANALYZE    cursor_mapper_analyze
+#   CAPI       bench_c_api (cursor_mapper_c)
+#   APP        cursor_mapper (Windows only; --replay)
+#   PROFDATA   llvm-profdata (clang only)
+
+cmake_minimum_required(VERSION 3.20)
+
+# Counts from an earlier training run or an older build would be mixed in
+file(GLOB_RECURSE stale ${PGO_DIR}/*.gcda ${PGO_DIR}/*.profraw ${PGO_DIR}/*.pgc)
+if(stale)
+    file(REMOVE ${stale})
+endif()
+# MSVC writes NAME!N.pgc here, beside the .pgd the USE link reads
+set(ENV{VCPROFILE_PATH} ${PGO_DIR})
+
+function(run)
+    string(JOIN " " cmd ${ARGN})
+    message(STATUS "pgo: ${cmd}")
+    execute_process(COMMAND ${ARGN} OUTPUT_QUIET COMMAND_ERROR_IS_FATAL ANY)
+endfunction()
+
+if(CORPUS)
+    file(GLOB traces ${CORPUS}/*.trace)
+    if(NOT traces)
+        message(FATAL_ERROR "no *.trace files in ${CORPUS}")
+    endif()
+else()
+    # Three desktops at the polling rates seen in the field: the gen
+    # default, a stacked four-monitor desk, a 1080p pair at 8 kHz
+    set(dir ${PGO_DIR}/corpus)
+    file(MAKE_DIRECTORY ${dir})
+    run(${GEN} --out=${dir}/default.trace --samples=2000000 --rate=1000 --seed=1)
+    run(${GEN} --out=${dir}/stacked.trace --samples=2000000 --rate=500 --seed=2
+        --monitor=0,0,2560,1440 --monitor=2560,-240,3640,1680 --monitor=-1920,180,0,1260
+        --monitor=640,-1080,2560,0)
+    run(${GEN} --out=${dir}/pair.trace --samples=4000000 --rate=8000 --seed=3
+        --monitor=0,0,1920,1080 --monitor=1920,0,3840,1080)
+    set(traces ${dir}/default.trace ${dir}/stacked.trace ${dir}/pair.trace)
+endif()
+
+# Percentage mapping is what nearly every seat runs, so it gets the most
+# passes; each other strategy runs once so its Map body is not cold
+foreach(strategy percent percent percent pass-through physical offset clamped)
+    run(${REPLAY} --raw --rounds=1 --strategy=${strategy} ${traces})
+endforeach()
+if(APP)
+    foreach(trace ${traces})
+        run(${APP} --replay=${trace})
+    endforeach()
+endif()
+run(${ANALYZE} ${traces})
+run(${CAPI} --samples=1000000)
+
+if(PROFDATA)
+    file(GLOB raw ${PGO_DIR}/*.profraw)
+    run(${PROFDATA} merge --output=${PGO_DIR}/cursor_mapper.profdata ${raw})
+endif()
+message(STATUS "pgo: profile in ${PGO_DIR}; configure the optimised build with "
+               "-DCURSOR_MAPPER_PGO=USE -DCURSOR_MAPPER_PGO_DIR=${PGO_DIR}")
@@ -0,0 +1,30 @@
+// libFuzzer entry for the differential harness: the fuzz input is decoded
+// into a topology and a segment (DecodeDiffInput) and every implementation
+// of the decoded target is checked against the frozen reference. A
+// divergence prints the shrunk input and aborts, so the crash file and the
+// minimal form are both available.
+//
+//   cmake -S . -B build-fuzz -DCMAKE_CXX_COMPILER=clang++ -DCURSOR_MAPPER_FUZZ=ON
+//   cmake --build build-fuzz --target fuzz_mapping
+//   ./build-fuzz/fuzz_mapping -jobs=$(nproc) corpus/
+
+#include "differential.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    DiffInput in;
+    if (!DecodeDiffInput(data, size, in)) return 0;
+    for (const auto& v : DIFF_VARIANTS) {
+        if (v.target != in.target || v.same(in, nullptr)) continue;
+        DiffInput minimal = ShrinkDiffInput(in, v.same);
+        std::string detail;
+        v.same(minimal, &detail);
+        fprintf(stderr, "%s diverges from the reference\n  minimal:  %s\n            %s\n  original: %s\n",
+                v.name, DiffInputText(minimal).c_str(), detail.c_str(), DiffInputText(in).c_str());
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef CURSOR_MAPPER_H
+#define CURSOR_MAPPER_H
+
+/*
+ * C ABI over the portable mapping core, for hosts that see absolute cursor
+ * positions but cannot run the Windows hook (KVM / Synergy-style tools,
+ * remote-desktop clients). Same percentage mapping on monitor crossings as
+ * the cursor_mapper process.
+ *
+ * Threading: a cm_mapper is driven by one mapping thread at a time
+ * (cm_map_motion / cm_map_motions / cm_mapper_reset). cm_mapper_set_topology
+ * may be called from any thread while that thread keeps mapping; the swap is
+ * a single atomic pointer store and the mapping thread never waits on it.
+ *
+ * Allocation: topologies are allocated by cm_topology_create. Mapping calls
+ * never allocate, lock or block.
+ *
+ * Crossing events: cm_bus_* subscribe to the running cursor_mapper's
+ * crossing bus (shared memory) without involving the process. A reader
+ * never slows the writer; events it falls too far behind on are counted as
+ * lost instead.
+ *
+ * All structs have fixed-width fields and no implicit padding; their layout
+ * only changes together with CM_ABI_VERSION.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(CM_BUILDING_LIBRARY)
+#    define CM_API __declspec(dllexport)
+#  else
+#    define CM_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define CM_API __attribute__((visibility("default")))
+#else
+#  define CM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CM_ABI_VERSION 1
+
+/* Status codes */
+#define CM_OK             0
+#define CM_E_INVALID     -1  /* null pointer, no monitors or an empty rect */
+#define CM_E_NO_MEMORY   -2
+#define CM_E_NO_TOPOLOGY -3  /* mapped before the first cm_mapper_set_topology */
+#define CM_E_NO_BUS      -4  /* no crossing bus of that name, or another layout */
+
+/* cm_result.flags (same bits as the mapper's MotionFlags) */
+#define CM_REMAPPED  (1u << 0)  /* position was rewritten by the mapping */
+#define CM_CROSSING  (1u << 1)  /* sample moved onto a different monitor */
+#define CM_OFFSCREEN (1u << 2)  /* sample lies outside every monitor */
+
+/* Virtual-desktop rect, half-open [left, right) x [top, bottom) like RECT */
+typedef struct cm_rect {
+    int32_t left, top, right, bottom;
+} cm_rect;
+
+/* Absolute cursor position after the host applied the motion */
+typedef struct cm_sample {
+    int32_t  x, y;
+    uint32_t time;  /* host clock, passed through */
+    uint32_t reserved;
+} cm_sample;
+
+/* Where the cursor should be */
+typedef struct cm_result {
+    int32_t  x, y;
+    uint32_t flags;  /* CM_REMAPPED | CM_CROSSING | CM_OFFSCREEN */
+    uint32_t reserved;
+} cm_result;
+
+/* cm_crossing_event.edge: side of the source monitor the cursor left by */
+#define CM_EDGE_LEFT   1
+#define CM_EDGE_RIGHT  2
+#define CM_EDGE_TOP    3
+#define CM_EDGE_BOTTOM 4
+
+/* cm_crossing_event.flags */
+#define CM_CROSSING_REMAPPED (1u << 0)  /* entry point differs from the raw landing point */
+
+/* One monitor crossing of the cursor_mapper process */
+typedef struct cm_crossing_event {
+    uint64_t time_ns;            /* monotonic clock (CLOCK_MONOTONIC / QueryPerformanceCounter) */
+    uint32_t time;               /* hook event time, ms */
+    int16_t  src, dst;           /* monitor indices */
+    uint8_t  edge;               /* CM_EDGE_* */
+    uint8_t  flags;              /* CM_CROSSING_REMAPPED */
+    uint16_t reserved;
+    int32_t  exit_x, exit_y;     /* last position on src */
+    int32_t  raw_x, raw_y;       /* where the OS put the cursor on dst */
+    int32_t  entry_x, entry_y;   /* where the mapper put it */
+    uint32_t reserved2;
+} cm_crossing_event;
+
+typedef struct cm_bus      cm_bus;       /* read-only subscription to the crossing bus */
+typedef struct cm_topology cm_topology;  /* immutable monitor layout */
+typedef struct cm_mapper   cm_mapper;    /* per-pointer state + current topology */
+
+/* CM_ABI_VERSION the library was built with */
+CM_API uint32_t cm_abi_version(void);
+
+/* Copies `count` rects (in the order monitor indices should have). Returns
+ * null and sets *status (if given) on invalid input or allocation failure. */
+CM_API cm_topology* cm_topology_create(const cm_rect* rects, size_t count, int* status);
+
+/* Only for topologies that were never handed to cm_mapper_set_topology. */
+CM_API void cm_topology_destroy(cm_topology* topo);
+
+CM_API size_t cm_topology_monitor_count(const cm_topology* topo);
+
+CM_API cm_mapper* cm_mapper_create(void);
+CM_API void       cm_mapper_destroy(cm_mapper* mapper);
+
+/* Swaps `topo` in atomically; the mapping thread picks it up on its next
+ * call and forgets the previous monitor. Ownership of `topo` is taken
+ * whatever the status. Topologies the mapping thread has moved past are
+ * freed here. */
+CM_API int cm_mapper_set_topology(cm_mapper* mapper, cm_topology* topo);
+
+/* Forget the previous position, e.g. after the host warped the cursor. */
+CM_API void cm_mapper_reset(cm_mapper* mapper);
+
+/* Maps one sample. */
+CM_API int cm_map_motion(cm_mapper* mapper, const cm_sample* in, cm_result* out);
+
+/* Maps `count` consecutive samples of one pointer, in order; equivalent to
+ * `count` cm_map_motion calls with the topology read once. `in` and `out`
+ * must not overlap. */
+CM_API int cm_map_motions(cm_mapper* mapper, const cm_sample* in, size_t count, cm_result* out);
+
+/* Subscribes to the crossing bus `name` (null: the default name). Reading
+ * starts at the next event, or at the oldest still buffered when
+ * from_oldest is non-zero. Returns null and sets *status (if given) when
+ * there is no compatible bus. */
+CM_API cm_bus* cm_bus_open(const char* name, int from_oldest, int* status);
+
+CM_API void cm_bus_close(cm_bus* bus);
+
+/* Copies up to `max` new events in order and returns how many; never
+ * blocks. *lost (if given) receives the total number of events that were
+ * overwritten before this subscriber read them. */
+CM_API size_t cm_bus_read(cm_bus* bus, cm_crossing_event* out, size_t max, uint64_t* lost);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CURSOR_MAPPER_H */
@@ -0,0 +1,174 @@
+#pragma once
+
+// Per-application mapping profiles. A profile names an executable and the
+// strategies to use while it has focus: its fallback covers every monitor
+// pair, portal or not, so a pass-through fallback without overrides turns
+// remapping off (CAD tools, games reading raw input). Profiles are
+// fixed at startup. The topology thread compiles every profile into a
+// PortalPolicyTable for each layout it publishes (TopologySnapshot::
+// profiles), the focus tracker resolves the foreground executable through
+// a hash table and hands the profile over with one atomic pointer store,
+// and the hook thread only loads that pointer and indexes the snapshot it
+// already holds. Nothing is freed while running, so there is no
+// reclamation.
+
+#include "remap_policy.h"
+#include "topology.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct AppProfile {
+    std::string          app;         // lower-case executable base name ("blender.exe")
+    PortalStrategyConfig strategies;
+    uint32_t             index = 0;   // into TopologySnapshot::profiles
+    uint64_t             hash  = 0;   // AppNameHash(app)
+};
+
+inline char AppNameLower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+// FNV-1a over the ASCII-lower-cased bytes.
+inline uint64_t AppNameHash(const char* s, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < n; ++i) h = (h ^ static_cast<uint8_t>(AppNameLower(s[i]))) * 0x100000001b3ull;
+    return h;
+}
+
+// Base name of an executable path, either separator.
+inline const char* AppBaseName(const char* path) {
+    const char* base = path;
+    for (const char* p = path; *p; ++p)
+        if (*p == '/' || *p == '\\') base = p + 1;
+    return base;
+}
+
+// Executable name -> profile, open addressing over a power-of-two slot
+// array kept at most half full.
+class AppProfileTable {
+public:
+    // Returns nullptr when the app already has a profile.
+    AppProfile* Add(const std::string& app, const PortalStrategyConfig& strategies) {
+        const char* base = AppBaseName(app.c_str());
+        if (Find(base)) return nullptr;
+        auto p = std::make_unique<AppProfile>();
+        for (const char* c = base; *c; ++c) p->app += AppNameLower(*c);
+        p->strategies = strategies;
+        p->index      = static_cast<uint32_t>(profiles_.size());
+        p->hash       = AppNameHash(p->app.data(), p->app.size());
+        profiles_.push_back(std::move(p));
+        if (profiles_.size() * 2 > slots_.size()) Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        else Insert(static_cast<int32_t>(profiles_.size() - 1));
+        return profiles_.back().get();
+    }
+
+    // Case-insensitive; nullptr: no profile, use the default.
+    const AppProfile* Find(const char* app, size_t n) const {
+        if (slots_.empty()) return nullptr;
+        uint64_t h = AppNameHash(app, n);
+        size_t mask = slots_.size() - 1;
+        for (size_t i = static_cast<size_t>(h) & mask;; i = (i + 1) & mask) {
+            int32_t s = slots_[i];
+            if (s < 0) return nullptr;
+            const AppProfile& p = *profiles_[s];
+            if (p.hash == h && p.app.size() == n && SameName(p.app.data(), app, n)) return &p;
+        }
+    }
+
+    const AppProfile* Find(const char* app) const { return Find(app, strlen(app)); }
+
+    // Full executable path as the OS reports it.
+    const AppProfile* FindPath(const char* path) const { return Find(AppBaseName(path)); }
+
+    size_t Size() const { return profiles_.size(); }
+    const AppProfile& operator[](size_t i) const { return *profiles_[i]; }
+
+    void SetMaxJump(long maxJump) {
+        for (auto& p : profiles_) p->strategies.maxJump = maxJump;
+    }
+
+private:
+    static bool SameName(const char* lower, const char* s, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            if (lower[i] != AppNameLower(s[i])) return false;
+        return true;
+    }
+
+    void Insert(int32_t index) {
+        size_t mask = slots_.size() - 1;
+        size_t i = static_cast<size_t>(profiles_[index]->hash) & mask;
+        while (slots_[i] >= 0) i = (i + 1) & mask;
+        slots_[i] = index;
+    }
+
+    void Rehash(size_t slots) {
+        slots_.assign(slots, -1);
+        for (size_t i = 0; i < profiles_.size(); ++i) Insert(static_cast<int32_t>(i));
+    }
+
+    std::vector<std::unique_ptr<AppProfile>> profiles_;  // stable addresses for ActiveProfile
+    std::vector<int32_t>                     slots_;     // -1: empty
+};
+
+// "APP=STRATEGY[,SRC:DST=STRATEGY]..." (--app-profile); maxJump is left
+// at its default for the caller to set.
+inline bool ParseAppProfile(const char* spec, std::string& app, PortalStrategyConfig& config) {
+    const char* eq = strchr(spec, '=');
+    if (!eq || eq == spec) return false;
+    app.assign(spec, eq);
+    config = {};
+    std::string rest = eq + 1;
+    size_t start = 0;
+    for (bool first = true; start <= rest.size(); first = false) {
+        size_t end = rest.find(',', start);
+        if (end == std::string::npos) end = rest.size();
+        std::string item = rest.substr(start, end - start);
+        start = end + 1;
+        if (first) {
+            if (!ParseRemapStrategy(item.c_str(), config.fallback)) return false;
+            continue;
+        }
+        PortalStrategyConfig::Override o{};
+        char name[32] = {};
+        if (sscanf(item.c_str(), "%d:%d=%31s", &o.src, &o.dst, name) != 3 || !ParseRemapStrategy(name, o.strategy))
+            return false;
+        config.overrides.push_back(o);
+    }
+    return true;
+}
+
+// One policy table per profile for a layout, in table order.
+inline std::vector<PortalPolicyTable> BuildProfilePolicies(const AppProfileTable& profiles,
+                                                           const std::vector<Rect>& mons,
+                                                           const std::vector<TopologyPortal>& portals,
+                                                           const std::vector<double>& mmPerPx = {}) {
+    std::vector<PortalPolicyTable> out;
+    out.reserve(profiles.Size());
+    for (size_t i = 0; i < profiles.Size(); ++i)
+        out.push_back(BuildPortalPolicies(mons, portals, profiles[i].strategies, mmPerPx));
+    return out;
+}
+
+// Policy table the hook uses on snap while profile has focus; nullptr when
+// the plain rect list gives the same answers.
+inline const PortalPolicyTable* ProfilePolicies(const TopologySnapshot& snap, const AppProfile* profile) {
+    const PortalPolicyTable& t =
+        profile && profile->index < snap.profiles.size() ? snap.profiles[profile->index] : snap.policies;
+    return t.Custom() ? &t : nullptr;
+}
+
+// Foreground profile, written by the focus tracker and loaded by the hook
+// thread once per event. nullptr is the command-line default.
+class ActiveProfile {
+public:
+    void Set(const AppProfile* p) { current_.store(p, std::memory_order_release); }
+    const AppProfile* Get() const { return current_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<const AppProfile*> current_{nullptr};
+};
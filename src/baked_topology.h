@@ -0,0 +1,59 @@
+#pragma once
+
+// Layouts fixed at compile time, for seats whose monitors never change
+// (kiosks). cursor_mapper_bake turns a layout description into a struct
+// with `static constexpr Rect MONITORS[]` and the signature hash;
+// BakedTopology<Layout> unrolls the monitor lookup per monitor, so every
+// bound is an immediate. Crossings run the generic MapCrossing over the
+// constexpr rects: per-pair instantiations reached through an indirect
+// call measured slower than that. EdgeRemapStage::ProcessWith runs it in
+// place of the rect list, and only while the live layout is the baked one
+// (BakedLayoutMatches); any other layout is mapped dynamically as usual.
+
+#include "mapping.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Bake at most this many monitors (the lookup is unrolled per monitor)
+static constexpr size_t BAKED_MAX_MONITORS = 16;
+
+template <typename Layout>
+class BakedTopology {
+public:
+    static constexpr size_t COUNT = std::size(Layout::MONITORS);
+    static_assert(COUNT > 0 && COUNT <= BAKED_MAX_MONITORS, "baked layout size out of range");
+
+    int MonitorIndex(Point p) const { return Index(p, std::make_index_sequence<COUNT>{}); }
+
+    CrossingDecision Cross(int src, int dst, Point from, Point to) const {
+        return MapCrossing(Layout::MONITORS[src], Layout::MONITORS[dst], from, to);
+    }
+
+private:
+    template <size_t... I>
+    static int Index(Point p, std::index_sequence<I...>) {
+        int found = -1;
+        // First match wins, as in MonitorIndexFromPoint
+        (void)((Contains(Layout::MONITORS[I], p) && (found = static_cast<int>(I), true)) || ...);
+        return found;
+    }
+};
+
+// The live layout is the baked one: same rects in the same order and, when
+// the layout came from `cursor_mapper --print-layout`, the same signature
+// hash (which also covers device names and the primary flag).
+template <typename Layout>
+inline bool BakedLayoutMatches(uint64_t signatureHash, const std::vector<Rect>& mons) {
+    if (Layout::SIGNATURE_HASH != 0 && Layout::SIGNATURE_HASH != signatureHash) return false;
+    if (mons.size() != BakedTopology<Layout>::COUNT) return false;
+    for (size_t i = 0; i < mons.size(); ++i) {
+        const Rect& a = mons[i];
+        const Rect& b = Layout::MONITORS[i];
+        if (a.left != b.left || a.top != b.top || a.right != b.right || a.bottom != b.bottom) return false;
+    }
+    return true;
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+// Crossing events broadcast through shared memory, for screen recorders
+// and accessibility tools that want to know when and where the cursor
+// changes monitors. There is one writer (the hook's crossing callback) and
+// any number of readers, each mapping the region read-only with its own
+// cursor.
+//
+// The ring is a power-of-two array of cache-line slots. The writer stamps a
+// slot odd, fills it, stamps it with the event's sequence number, then
+// advances `published`. It never looks at readers, so a reader that falls
+// more than BUS_CAPACITY events behind has been lapped. It finds out from
+// the slot stamps or from `published`, counts what it lost and resumes at
+// the oldest event still in the ring. Payload words are relaxed atomics,
+// copied and re-checked against the stamp as in ThreadMetrics' seqlock.
+//
+// Layout is fixed and versioned: bump BUS_LAYOUT_VERSION whenever
+// CrossingEvent or the header change shape.
+
+#include "mapping.h"
+#include "metrics.h"  // CACHE_LINE, MetricsNowNs
+#include "shared_region.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+static constexpr uint32_t BUS_MAGIC          = 0x424d434dU;  // "MCMB"
+static constexpr uint32_t BUS_LAYOUT_VERSION = 1;
+static constexpr uint32_t BUS_CAPACITY       = 4096;         // events; power of two
+
+#if defined(_WIN32)
+static constexpr const char* DEFAULT_BUS_NAME = "Local\\cursor_mapper_crossings";
+#else
+static constexpr const char* DEFAULT_BUS_NAME = "/cursor_mapper_crossings";
+#endif
+
+enum CrossingEventFlags : uint8_t {
+    CROSSING_REMAPPED = 1u << 0,  // entry differs from the raw landing point
+};
+
+struct CrossingEvent {
+    uint64_t timeNs;          // steady clock of the writer (CLOCK_MONOTONIC / QPC)
+    uint32_t time;            // MotionSample::time, ms
+    int16_t  src, dst;        // monitor indices in published order
+    uint8_t  edge;            // Edge the cursor left src through
+    uint8_t  flags;           // CrossingEventFlags
+    uint16_t reserved;
+    int32_t  exitX, exitY;    // last position on src
+    int32_t  rawX, rawY;      // where the OS put it on dst
+    int32_t  entryX, entryY;  // where the mapper put it (== raw unless remapped)
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(CrossingEvent) == 48, "crossing event layout changed");
+
+static constexpr size_t BUS_WORDS = sizeof(CrossingEvent) / sizeof(uint64_t);
+
+struct alignas(CACHE_LINE) BusSlot {
+    std::atomic<uint64_t> stamp{0};  // 2 * (seq + 1) once written; odd while being written
+    std::atomic<uint64_t> words[BUS_WORDS];
+};
+
+struct alignas(CACHE_LINE) BusHeader {
+    std::atomic<uint32_t> magic{0};  // stored last by the creator
+    uint32_t layoutVersion = 0;
+    uint32_t eventSize     = 0;      // sizeof(CrossingEvent)
+    uint32_t capacity      = 0;
+    uint64_t pid           = 0;
+    uint64_t startUnixMs   = 0;
+};
+
+struct BusLayout {
+    BusHeader header;
+    alignas(CACHE_LINE) std::atomic<uint64_t> published{0};  // events written so far
+    BusSlot slots[BUS_CAPACITY];
+};
+
+static_assert(sizeof(BusSlot) == CACHE_LINE, "bus slot spans cache lines");
+
+// --- Writer ---
+
+class CrossingBus {
+public:
+    bool Create(const std::string& name) {
+        if (!region_.Create(name, sizeof(BusLayout), offsetof(BusHeader, pid))) return false;
+        view_ = new (region_.Data()) BusLayout();
+        BusHeader& h = view_->header;
+        h.layoutVersion = BUS_LAYOUT_VERSION;
+        h.eventSize     = sizeof(CrossingEvent);
+        h.capacity      = BUS_CAPACITY;
+#if defined(_WIN32)
+        h.pid = GetCurrentProcessId();
+#else
+        h.pid = static_cast<uint64_t>(getpid());
+#endif
+        h.startUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        h.magic.store(BUS_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    void Close() {
+        region_.Close();
+        view_ = nullptr;
+    }
+
+    bool IsOpen() const { return view_ != nullptr; }
+    const char* Error() const { return region_.Error(); }
+
+    // Single writer; wait-free.
+    void Publish(const CrossingEvent& e) {
+        uint64_t seq = next_++;
+        BusSlot& slot = view_->slots[seq & (BUS_CAPACITY - 1)];
+        uint64_t words[BUS_WORDS];
+        memcpy(words, &e, sizeof(e));
+        slot.stamp.store(2 * seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < BUS_WORDS; ++i) slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.stamp.store(2 * (seq + 1), std::memory_order_release);
+        view_->published.store(seq + 1, std::memory_order_release);
+    }
+
+    uint64_t Published() const { return next_; }
+
+private:
+    SharedRegion region_;
+    BusLayout*   view_ = nullptr;
+    uint64_t     next_ = 0;
+};
+
+// --- Reader ---
+
+class CrossingBusReader {
+public:
+    // Maps the bus read-only. New readers start at the next event; pass
+    // fromOldest to also get what is still in the ring.
+    bool Open(const std::string& name, bool fromOldest = false) {
+        view_ = nullptr;
+        if (!region_.Open(name, sizeof(BusLayout))) return false;
+        view_ = static_cast<const BusLayout*>(region_.Data());
+        const BusHeader& h = view_->header;
+        if (h.magic.load(std::memory_order_acquire) != BUS_MAGIC) return Fail("region not initialised");
+        if (h.layoutVersion != BUS_LAYOUT_VERSION || h.eventSize != sizeof(CrossingEvent) ||
+            h.capacity != BUS_CAPACITY)
+            return Fail("layout version mismatch");
+        uint64_t published = view_->published.load(std::memory_order_acquire);
+        next_ = fromOldest && published > BUS_CAPACITY ? published - BUS_CAPACITY : fromOldest ? 0 : published;
+        lost_ = 0;
+        return true;
+    }
+
+    void Close() {
+        region_.Close();
+        view_ = nullptr;
+    }
+
+    bool IsOpen() const { return view_ != nullptr; }
+    const char* Error() const { return region_.Error(); }
+    const BusHeader& Header() const { return view_->header; }
+
+    // Copies up to max events in order; returns how many. Events the writer
+    // overwrote before they were read are skipped and added to Lost().
+    size_t Read(CrossingEvent* out, size_t max) {
+        size_t n = 0;
+        uint64_t published = view_->published.load(std::memory_order_acquire);
+        while (n < max) {
+            if (next_ >= published) {
+                // Caught up with the last look; one more before returning
+                published = view_->published.load(std::memory_order_acquire);
+                if (next_ >= published) break;
+            }
+            if (published - next_ > BUS_CAPACITY) {
+                Skip(published - BUS_CAPACITY);
+                continue;
+            }
+            const BusSlot& slot = view_->slots[next_ & (BUS_CAPACITY - 1)];
+            uint64_t want   = 2 * (next_ + 1);
+            uint64_t before = slot.stamp.load(std::memory_order_acquire);
+            if (before != want) {
+                if (before < want) break;  // not possible once published; be safe
+                // Lapped since `published` was read: a newer event is (being)
+                // written here
+                published = view_->published.load(std::memory_order_acquire);
+                Skip(next_ + 1);
+                continue;
+            }
+            uint64_t words[BUS_WORDS];
+            for (size_t i = 0; i < BUS_WORDS; ++i) words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.stamp.load(std::memory_order_relaxed) != want) {
+                published = view_->published.load(std::memory_order_acquire);
+                Skip(next_ + 1);
+                continue;
+            }
+            memcpy(&out[n++], words, sizeof(CrossingEvent));
+            ++next_;
+        }
+        return n;
+    }
+
+    uint64_t Next() const { return next_; }  // sequence number of the next event
+    uint64_t Lost() const { return lost_; }  // events overwritten before they were read
+
+private:
+    void Skip(uint64_t to) {
+        lost_ += to - next_;
+        next_ = to;
+    }
+
+    bool Fail(const char* why) {
+        view_ = nullptr;
+        return region_.Fail(why);
+    }
+
+    SharedRegion     region_;
+    const BusLayout* view_ = nullptr;
+    uint64_t         next_ = 0;
+    uint64_t         lost_ = 0;
+};
+
+// Event for a crossing the remap stage reported.
+inline CrossingEvent MakeCrossingEvent(int src, int dst, Edge edge, Point exit, Point raw, Point entry,
+                                       bool remapped, uint32_t time) {
+    CrossingEvent e{};
+    e.timeNs = MetricsNowNs();
+    e.time   = time;
+    e.src    = static_cast<int16_t>(src);
+    e.dst    = static_cast<int16_t>(dst);
+    e.edge   = static_cast<uint8_t>(edge);
+    e.flags  = remapped ? CROSSING_REMAPPED : 0;
+    e.exitX  = static_cast<int32_t>(exit.x);
+    e.exitY  = static_cast<int32_t>(exit.y);
+    e.rawX   = static_cast<int32_t>(raw.x);
+    e.rawY   = static_cast<int32_t>(raw.y);
+    e.entryX = static_cast<int32_t>(entry.x);
+    e.entryY = static_cast<int32_t>(entry.y);
+    return e;
+}
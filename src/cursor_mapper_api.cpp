@@ -0,0 +1,158 @@
+// C ABI (include/cursor_mapper.h) over the portable core. A cm_topology is
+// a TopologySnapshot; a cm_mapper is a SnapshotPublisher (the topology swap)
+// plus the EdgeRemapStage state of one pointer, which maps straight over the
+// acquired snapshot's rects. Nothing below the topology calls allocates, and
+// no exception crosses the ABI.
+
+#include "cursor_mapper.h"
+
+#include "crossing_bus.h"
+#include "filter_chain.h"
+#include "topology.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+static_assert(CM_REMAPPED == MOTION_REMAPPED && CM_CROSSING == MOTION_CROSSING &&
+              CM_OFFSCREEN == MOTION_OFFSCREEN, "result flags must match MotionFlags");
+static_assert(sizeof(cm_rect) == 16 && sizeof(cm_sample) == 16 && sizeof(cm_result) == 16,
+              "C ABI struct layout changed");
+static_assert(sizeof(cm_crossing_event) == sizeof(CrossingEvent) &&
+              offsetof(cm_crossing_event, exit_x) == offsetof(CrossingEvent, exitX) &&
+              offsetof(cm_crossing_event, entry_y) == offsetof(CrossingEvent, entryY),
+              "cm_crossing_event must mirror CrossingEvent");
+static_assert(CM_EDGE_LEFT == static_cast<int>(Edge::Left) && CM_EDGE_BOTTOM == static_cast<int>(Edge::Bottom) &&
+              CM_CROSSING_REMAPPED == CROSSING_REMAPPED, "crossing event constants changed");
+
+struct cm_mapper {
+    SnapshotPublisher publisher;
+    // Mapping thread only. monitors stays empty; ProcessOver reads the snapshot
+    EdgeRemapStage remap;
+    uint64_t       seenVersion = 0;
+};
+
+// Samples are widened into MotionSample in stack chunks of this size
+static constexpr size_t MAP_CHUNK = 256;
+
+static TopologySnapshot* Snapshot(cm_topology* topo) { return reinterpret_cast<TopologySnapshot*>(topo); }
+
+static const TopologySnapshot* Snapshot(const cm_topology* topo) {
+    return reinterpret_cast<const TopologySnapshot*>(topo);
+}
+
+// --- Topology ---
+
+extern "C" uint32_t cm_abi_version(void) { return CM_ABI_VERSION; }
+
+extern "C" cm_topology* cm_topology_create(const cm_rect* rects, size_t count, int* status) {
+    int rc = CM_OK;
+    TopologySnapshot* snap = nullptr;
+    if (!rects || count == 0) rc = CM_E_INVALID;
+    for (size_t i = 0; rc == CM_OK && i < count; ++i)
+        if (rects[i].right <= rects[i].left || rects[i].bottom <= rects[i].top) rc = CM_E_INVALID;
+    if (rc == CM_OK) {
+        try {
+            auto s = std::make_unique<TopologySnapshot>();
+            s->monitors.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                s->monitors.push_back({rects[i].left, rects[i].top, rects[i].right, rects[i].bottom});
+            snap = s.release();
+        } catch (const std::bad_alloc&) {
+            rc = CM_E_NO_MEMORY;
+        }
+    }
+    if (status) *status = rc;
+    return reinterpret_cast<cm_topology*>(snap);
+}
+
+extern "C" void cm_topology_destroy(cm_topology* topo) { delete Snapshot(topo); }
+
+extern "C" size_t cm_topology_monitor_count(const cm_topology* topo) {
+    return topo ? Snapshot(topo)->monitors.size() : 0;
+}
+
+// --- Mapper ---
+
+extern "C" cm_mapper* cm_mapper_create(void) { return new (std::nothrow) cm_mapper(); }
+
+extern "C" void cm_mapper_destroy(cm_mapper* mapper) { delete mapper; }
+
+extern "C" int cm_mapper_set_topology(cm_mapper* mapper, cm_topology* topo) {
+    if (!mapper || !topo) {
+        cm_topology_destroy(topo);
+        return CM_E_INVALID;
+    }
+    try {
+        mapper->publisher.Publish(std::unique_ptr<TopologySnapshot>(Snapshot(topo)));
+    } catch (const std::bad_alloc&) {
+        // The snapshot is live; only the retired list could not grow
+        return CM_E_NO_MEMORY;
+    }
+    return CM_OK;
+}
+
+extern "C" void cm_mapper_reset(cm_mapper* mapper) {
+    if (mapper) mapper->remap.lastMonitor = -1;
+}
+
+// --- Mapping ---
+
+extern "C" int cm_map_motions(cm_mapper* mapper, const cm_sample* in, size_t count, cm_result* out) {
+    if (!mapper || (count && (!in || !out))) return CM_E_INVALID;
+
+    const TopologySnapshot* topo = mapper->publisher.Acquire();
+    if (!topo) {
+        for (size_t i = 0; i < count; ++i) out[i] = {in[i].x, in[i].y, CM_OFFSCREEN, 0};
+        return CM_E_NO_TOPOLOGY;
+    }
+    EdgeRemapStage& remap = mapper->remap;
+    if (topo->version != mapper->seenVersion) {
+        // Same as SetMonitors: the previous monitor index means nothing now
+        remap.lastMonitor   = -1;
+        mapper->seenVersion = topo->version;
+    }
+
+    const Rect* mons = topo->monitors.data();
+    size_t monCount  = topo->monitors.size();
+    MotionSample buf[MAP_CHUNK];
+    for (size_t base = 0; base < count; base += MAP_CHUNK) {
+        size_t n = std::min(MAP_CHUNK, count - base);
+        const cm_sample* src = in + base;
+        for (size_t i = 0; i < n; ++i) buf[i] = {{src[i].x, src[i].y}, 0.0, 0.0, src[i].time, 0};
+        remap.ProcessOver(mons, monCount, buf, n);
+        cm_result* dst = out + base;
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = {static_cast<int32_t>(buf[i].pos.x), static_cast<int32_t>(buf[i].pos.y), buf[i].flags, 0};
+    }
+    return CM_OK;
+}
+
+extern "C" int cm_map_motion(cm_mapper* mapper, const cm_sample* in, cm_result* out) {
+    return cm_map_motions(mapper, in, 1, out);
+}
+
+// --- Crossing bus ---
+
+struct cm_bus {
+    CrossingBusReader reader;
+};
+
+extern "C" cm_bus* cm_bus_open(const char* name, int from_oldest, int* status) {
+    auto bus = std::unique_ptr<cm_bus>(new (std::nothrow) cm_bus());
+    int st = CM_OK;
+    if (!bus) st = CM_E_NO_MEMORY;
+    else if (!bus->reader.Open(name ? name : DEFAULT_BUS_NAME, from_oldest != 0)) st = CM_E_NO_BUS;
+    if (status) *status = st;
+    return st == CM_OK ? bus.release() : nullptr;
+}
+
+extern "C" void cm_bus_close(cm_bus* bus) { delete bus; }
+
+extern "C" size_t cm_bus_read(cm_bus* bus, cm_crossing_event* out, size_t max, uint64_t* lost) {
+    if (!bus || (!out && max)) return 0;
+    size_t n = bus->reader.Read(reinterpret_cast<CrossingEvent*>(out), max);
+    if (lost) *lost = bus->reader.Lost();
+    return n;
+}
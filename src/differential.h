@@ -0,0 +1,435 @@
+#pragma once
+
+// Differential checks of the mapping primitives against the frozen
+// reference (mapping_reference.h). One input type covers every primitive:
+// up to four rects, two points and an edge, read per target. The same
+// generator, comparison, shrinker and fuzz decoder then serve all of them
+// (tools/cursor_mapper_diff.cpp, fuzz/fuzz_mapping.cpp).
+//
+// Inputs respect what the mapper guarantees its callers: rects are
+// non-empty and coordinates stay within DIFF_COORD_LIMIT; a segment starts
+// inside its source rect; a crossing also ends inside the destination.
+// Variants may rely on exactly these preconditions and nothing more.
+
+#include "mapping.h"
+#include "mapping_reference.h"
+#include "mapping_variants.h"
+#include "trajectory.h"  // TrajectoryRng
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+enum class DiffTarget { MonitorIndex, ExitEdge, Remap, Crossing, Count };
+
+static constexpr size_t DIFF_MAX_RECTS   = 4;
+static constexpr long   DIFF_COORD_LIMIT = 1L << 20;  // fits 32-bit long with room for sums
+
+struct DiffInput {
+    DiffTarget target;
+    size_t     rectCount;
+    Rect       rects[DIFF_MAX_RECTS];
+    Point      a, b;  // point / from, to; Remap reads a.x as the hit coordinate
+    Edge       edge;  // Remap only
+};
+
+inline const char* DiffTargetName(DiffTarget t) {
+    switch (t) {
+    case DiffTarget::MonitorIndex: return "monitor";
+    case DiffTarget::ExitEdge:     return "exit";
+    case DiffTarget::Remap:        return "remap";
+    case DiffTarget::Crossing:     return "crossing";
+    default:                       return "?";
+    }
+}
+
+inline bool DiffInputValid(const DiffInput& in) {
+    if (in.rectCount < (in.target == DiffTarget::Remap || in.target == DiffTarget::Crossing ? 2u : 1u) ||
+        in.rectCount > DIFF_MAX_RECTS)
+        return false;
+    auto inLimit = [](long v) { return v >= -DIFF_COORD_LIMIT && v <= DIFF_COORD_LIMIT; };
+    for (size_t i = 0; i < in.rectCount; ++i) {
+        const Rect& r = in.rects[i];
+        if (!inLimit(r.left) || !inLimit(r.top) || !inLimit(r.right) || !inLimit(r.bottom)) return false;
+        if (r.right <= r.left || r.bottom <= r.top) return false;
+    }
+    if (!inLimit(in.a.x) || !inLimit(in.a.y) || !inLimit(in.b.x) || !inLimit(in.b.y)) return false;
+    switch (in.target) {
+    case DiffTarget::ExitEdge: return Contains(in.rects[0], in.a);
+    case DiffTarget::Remap:    return in.edge != Edge::None;
+    case DiffTarget::Crossing: return Contains(in.rects[0], in.a) && Contains(in.rects[1], in.b);
+    default:                   return true;
+    }
+}
+
+// --- Printing (minimal form: only what the target reads) ---
+
+inline std::string DiffRectText(const Rect& r) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{%ld,%ld,%ld,%ld}", r.left, r.top, r.right, r.bottom);
+    return buf;
+}
+
+inline std::string DiffInputText(const DiffInput& in) {
+    char buf[160];
+    std::string out;
+    switch (in.target) {
+    case DiffTarget::MonitorIndex:
+        out = "monitors=";
+        for (size_t i = 0; i < in.rectCount; ++i) out += DiffRectText(in.rects[i]);
+        snprintf(buf, sizeof(buf), " p=(%ld,%ld)", in.a.x, in.a.y);
+        break;
+    case DiffTarget::ExitEdge:
+        out = "rc=" + DiffRectText(in.rects[0]);
+        snprintf(buf, sizeof(buf), " from=(%ld,%ld) to=(%ld,%ld)", in.a.x, in.a.y, in.b.x, in.b.y);
+        break;
+    case DiffTarget::Remap:
+        out = "src=" + DiffRectText(in.rects[0]) + " dst=" + DiffRectText(in.rects[1]);
+        snprintf(buf, sizeof(buf), " edge=%s hit=%ld", EdgeName(in.edge), in.a.x);
+        break;
+    default:
+        out = "src=" + DiffRectText(in.rects[0]) + " dst=" + DiffRectText(in.rects[1]);
+        snprintf(buf, sizeof(buf), " from=(%ld,%ld) to=(%ld,%ld)", in.a.x, in.a.y, in.b.x, in.b.y);
+        break;
+    }
+    return out + buf;
+}
+
+inline std::string DiffHitText(const HitResult& h) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%s t=%.17g coord=%.17g", EdgeName(h.edge), h.t, h.coord);
+    return buf;
+}
+
+// Edges and flags compare exactly; t and coord within this (they are
+// computed in double and a variant may legitimately reassociate).
+static constexpr double DIFF_T_TOLERANCE = 1e-9;
+
+inline bool SameHit(const HitResult& a, const HitResult& b) {
+    if (a.edge != b.edge) return false;
+    if (a.edge == Edge::None) return true;
+    return std::abs(a.t - b.t) <= DIFF_T_TOLERANCE &&
+           std::abs(a.coord - b.coord) <= DIFF_T_TOLERANCE * (1.0 + std::abs(a.coord));
+}
+
+// --- Comparers: run one implementation and the reference on an input ---
+
+using DiffSameFn = bool (*)(const DiffInput& in, std::string* detail);
+
+template <int (*Fn)(const Rect*, size_t, Point)>
+inline bool SameMonitorIndex(const DiffInput& in, std::string* detail) {
+    int ref = ReferenceMonitorIndexFromPoint(in.rects, in.rectCount, in.a);
+    int got = Fn(in.rects, in.rectCount, in.a);
+    if (ref == got) return true;
+    if (detail) *detail = "reference " + std::to_string(ref) + ", variant " + std::to_string(got);
+    return false;
+}
+
+template <HitResult (*Fn)(Point, Point, const Rect&)>
+inline bool SameExitEdge(const DiffInput& in, std::string* detail) {
+    HitResult ref = ReferenceFindExitEdge(in.a, in.b, in.rects[0]);
+    HitResult got = Fn(in.a, in.b, in.rects[0]);
+    if (SameHit(ref, got)) return true;
+    if (detail) *detail = "reference " + DiffHitText(ref) + ", variant " + DiffHitText(got);
+    return false;
+}
+
+template <bool (*Fn)(const Rect&, const Rect&, Edge, double, Point&)>
+inline bool SameRemap(const DiffInput& in, std::string* detail) {
+    Point ref{0, 0}, got{0, 0};
+    bool refOk = ReferenceRemapCursor(in.rects[0], in.rects[1], in.edge, static_cast<double>(in.a.x), ref);
+    bool gotOk = Fn(in.rects[0], in.rects[1], in.edge, static_cast<double>(in.a.x), got);
+    if (refOk == gotOk && (!refOk || ref == got)) return true;
+    if (detail) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "reference %s(%ld,%ld), variant %s(%ld,%ld)", refOk ? "" : "rejected ",
+                 ref.x, ref.y, gotOk ? "" : "rejected ", got.x, got.y);
+        *detail = buf;
+    }
+    return false;
+}
+
+template <CrossingDecision (*Fn)(const Rect&, const Rect&, Point, Point)>
+inline bool SameCrossing(const DiffInput& in, std::string* detail) {
+    CrossingDecision ref = ReferenceMapCrossing(in.rects[0], in.rects[1], in.a, in.b);
+    CrossingDecision got = Fn(in.rects[0], in.rects[1], in.a, in.b);
+    if (SameHit(ref.hit, got.hit) && ref.remapped == got.remapped && ref.mapped == got.mapped) return true;
+    if (detail) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), " -> %s(%ld,%ld)", ref.remapped ? "" : "kept ", ref.mapped.x, ref.mapped.y);
+        *detail = "reference " + DiffHitText(ref.hit) + buf;
+        snprintf(buf, sizeof(buf), " -> %s(%ld,%ld)", got.remapped ? "" : "kept ", got.mapped.x, got.mapped.y);
+        *detail += ", variant " + DiffHitText(got.hit) + buf;
+    }
+    return false;
+}
+
+// --- Implementations under test ---
+// The live functions are listed too, so an accidental change to mapping.h
+// shows up as a divergence from the frozen reference.
+
+struct DiffVariant {
+    DiffTarget  target;
+    const char* name;
+    DiffSameFn  same;
+};
+
+static const DiffVariant DIFF_VARIANTS[] = {
+    {DiffTarget::MonitorIndex, "MonitorIndexFromPoint", SameMonitorIndex<MonitorIndexFromPoint>},
+    {DiffTarget::MonitorIndex, "MonitorIndexFromPointMask", SameMonitorIndex<MonitorIndexFromPointMask>},
+    {DiffTarget::ExitEdge, "FindExitEdge", SameExitEdge<FindExitEdge>},
+    {DiffTarget::ExitEdge, "FindExitEdgeDirectional", SameExitEdge<FindExitEdgeDirectional>},
+    {DiffTarget::Remap, "RemapCursor", SameRemap<RemapCursor>},
+    {DiffTarget::Crossing, "MapCrossing", SameCrossing<MapCrossing>},
+};
+
+// --- Input generation: random and adversarial ---
+
+inline long DiffPick(TrajectoryRng& rng, long lo, long hi) {  // inclusive
+    return lo + static_cast<long>(rng.Next() % static_cast<uint64_t>(hi - lo + 1));
+}
+
+// Coordinates that sit on, just inside or just outside r's boundary.
+inline long DiffBoundaryX(TrajectoryRng& rng, const Rect& r) {
+    const long xs[] = {r.left - 1, r.left, r.left + 1, r.right - 2, r.right - 1, r.right, r.right + 1};
+    return xs[rng.Next() % 7];
+}
+inline long DiffBoundaryY(TrajectoryRng& rng, const Rect& r) {
+    const long ys[] = {r.top - 1, r.top, r.top + 1, r.bottom - 2, r.bottom - 1, r.bottom, r.bottom + 1};
+    return ys[rng.Next() % 7];
+}
+
+inline Point DiffPointIn(TrajectoryRng& rng, const Rect& r) {
+    Point p{DiffPick(rng, r.left, r.right - 1), DiffPick(rng, r.top, r.bottom - 1)};
+    if (rng.Next() & 1) p.x = std::clamp(DiffBoundaryX(rng, r), r.left, r.right - 1);
+    if (rng.Next() & 1) p.y = std::clamp(DiffBoundaryY(rng, r), r.top, r.bottom - 1);
+    return p;
+}
+
+inline Rect DiffRandomRect(TrajectoryRng& rng) {
+    long span = (rng.Next() & 3) == 0 ? 4 : (rng.Next() & 1) ? 4096 : DIFF_COORD_LIMIT / 2;
+    long w = DiffPick(rng, 1, span), h = DiffPick(rng, 1, span);
+    long l = DiffPick(rng, -DIFF_COORD_LIMIT / 2, DIFF_COORD_LIMIT / 2 - w);
+    long t = DiffPick(rng, -DIFF_COORD_LIMIT / 2, DIFF_COORD_LIMIT / 2 - h);
+    return {l, t, l + w, t + h};
+}
+
+// A rect attached to one side of r: sharing the edge with an offset,
+// touching only at a corner, or flush with either end.
+inline Rect DiffNeighbour(TrajectoryRng& rng, const Rect& r) {
+    long w = (rng.Next() & 3) == 0 ? DiffPick(rng, 1, 4) : DiffPick(rng, 1, 4096);
+    long h = (rng.Next() & 3) == 0 ? DiffPick(rng, 1, 4) : DiffPick(rng, 1, 4096);
+    int side = static_cast<int>(rng.Next() % 4);
+    bool horiz = side < 2;
+    long lo = horiz ? r.top : r.left, hi = horiz ? r.bottom : r.right, len = horiz ? h : w;
+    long starts[] = {lo - len, lo, hi - len, hi, DiffPick(rng, lo - len + 1, hi - 1)};
+    long s = starts[rng.Next() % 5];
+    switch (side) {
+    case 0:  return {r.right, s, r.right + w, s + h};
+    case 1:  return {r.left - w, s, r.left, s + h};
+    case 2:  return {s, r.bottom, s + w, r.bottom + h};
+    default: return {s, r.top - h, s + w, r.top};
+    }
+}
+
+inline void DiffTopology(TrajectoryRng& rng, DiffInput& in, size_t minRects) {
+    in.rectCount = std::max(minRects, static_cast<size_t>(DiffPick(rng, 1, DIFF_MAX_RECTS)));
+    in.rects[0] = DiffRandomRect(rng);
+    bool attached = (rng.Next() & 3) != 0;
+    for (size_t i = 1; i < in.rectCount; ++i)
+        in.rects[i] = attached ? DiffNeighbour(rng, in.rects[rng.Next() % i]) : DiffRandomRect(rng);
+}
+
+// End point for a segment leaving r from p: exactly through a corner,
+// along an edge, zero length, a short step or anywhere.
+inline Point DiffSegmentEnd(TrajectoryRng& rng, const Rect& r, Point p) {
+    switch (rng.Next() % 6) {
+    case 0: {
+        Point c{(rng.Next() & 1) ? r.left : r.right, (rng.Next() & 1) ? r.top : r.bottom};
+        long k = DiffPick(rng, 1, 3);
+        return {p.x + k * (c.x - p.x), p.y + k * (c.y - p.y)};
+    }
+    case 1: return {DiffBoundaryX(rng, r), p.y};
+    case 2: return {p.x, DiffBoundaryY(rng, r)};
+    case 3: return p;
+    case 4: return {p.x + DiffPick(rng, -3, 3), p.y + DiffPick(rng, -3, 3)};
+    default: return {DiffPick(rng, -DIFF_COORD_LIMIT / 2, DIFF_COORD_LIMIT / 2),
+                     DiffPick(rng, -DIFF_COORD_LIMIT / 2, DIFF_COORD_LIMIT / 2)};
+    }
+}
+
+inline void GenerateDiffInput(DiffTarget target, TrajectoryRng& rng, DiffInput& in) {
+    for (;;) {
+        in = {};
+        in.target = target;
+        switch (target) {
+        case DiffTarget::MonitorIndex: {
+            DiffTopology(rng, in, 1);
+            const Rect& r = in.rects[rng.Next() % in.rectCount];
+            in.a = (rng.Next() & 1) ? Point{DiffBoundaryX(rng, r), DiffBoundaryY(rng, r)} : DiffPointIn(rng, r);
+            break;
+        }
+        case DiffTarget::ExitEdge:
+            in.rectCount = 1;
+            in.rects[0] = DiffRandomRect(rng);
+            in.a = DiffPointIn(rng, in.rects[0]);
+            in.b = DiffSegmentEnd(rng, in.rects[0], in.a);
+            break;
+        case DiffTarget::Remap: {
+            DiffTopology(rng, in, 2);
+            in.edge = static_cast<Edge>(DiffPick(rng, 1, 4));
+            const Rect& s = in.rects[0];
+            bool horiz = in.edge == Edge::Left || in.edge == Edge::Right;
+            in.a.x = (rng.Next() & 1) ? (horiz ? DiffBoundaryY(rng, s) : DiffBoundaryX(rng, s))
+                                      : DiffPick(rng, (horiz ? s.top : s.left) - 8, (horiz ? s.bottom : s.right) + 8);
+            break;
+        }
+        default: {
+            DiffTopology(rng, in, 2);
+            std::swap(in.rects[1], in.rects[1 + rng.Next() % (in.rectCount - 1)]);
+            in.a = DiffPointIn(rng, in.rects[0]);
+            Point end = DiffSegmentEnd(rng, in.rects[0], in.a);
+            in.b = Contains(in.rects[1], end) ? end : DiffPointIn(rng, in.rects[1]);
+            break;
+        }
+        }
+        if (DiffInputValid(in)) return;
+    }
+}
+
+// --- Shrinking ---
+// Greedy: keep any simplification that is still valid and still makes
+// `same` fail. Tries dropping trailing rects, then moves every coordinate
+// toward zero (to zero, halfway, one step), then the whole input toward the
+// origin, until nothing changes.
+
+inline DiffInput ShrinkDiffInput(DiffInput in, DiffSameFn same) {
+    auto fails = [&](const DiffInput& c) { return DiffInputValid(c) && !same(c, nullptr); };
+    auto fields = [](DiffInput& c, long** out) {
+        size_t n = 0;
+        for (size_t i = 0; i < c.rectCount; ++i) {
+            out[n++] = &c.rects[i].left;
+            out[n++] = &c.rects[i].top;
+            out[n++] = &c.rects[i].right;
+            out[n++] = &c.rects[i].bottom;
+        }
+        out[n++] = &c.a.x;
+        out[n++] = &c.a.y;
+        out[n++] = &c.b.x;
+        out[n++] = &c.b.y;
+        return n;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        while (in.rectCount > 1) {
+            DiffInput c = in;
+            --c.rectCount;
+            if (!fails(c)) break;
+            in = c;
+            changed = true;
+        }
+        // Translate everything so rects[0] starts at the origin. Remap's
+        // hit coordinate (a.x) runs along the edge, so it moves with y for
+        // left / right edges.
+        for (int axis = 0; axis < 2; ++axis) {
+            long d = axis ? in.rects[0].top : in.rects[0].left;
+            if (!d) continue;
+            DiffInput c = in;
+            for (size_t i = 0; i < c.rectCount; ++i) {
+                (axis ? c.rects[i].top : c.rects[i].left) -= d;
+                (axis ? c.rects[i].bottom : c.rects[i].right) -= d;
+            }
+            if (c.target == DiffTarget::Remap) {
+                int hitAxis = (c.edge == Edge::Left || c.edge == Edge::Right) ? 1 : 0;
+                if (axis == hitAxis) c.a.x -= d;
+            } else {
+                (axis ? c.a.y : c.a.x) -= d;
+                (axis ? c.b.y : c.b.x) -= d;
+            }
+            if (fails(c)) {
+                in = c;
+                changed = true;
+            }
+        }
+        long* f[DIFF_MAX_RECTS * 4 + 4];
+        size_t n = fields(in, f);
+        for (size_t i = 0; i < n; ++i) {
+            for (;;) {
+                long v = *f[i];
+                if (!v) break;
+                long tries[] = {0, v / 2, v - (v > 0 ? 1 : -1)};
+                bool stepped = false;
+                for (long t : tries) {
+                    if (t == v) continue;
+                    DiffInput c = in;
+                    long* cf[DIFF_MAX_RECTS * 4 + 4];
+                    fields(c, cf);
+                    *cf[i] = t;
+                    if (fails(c)) {
+                        in = c;
+                        fields(in, f);
+                        stepped = changed = true;
+                        break;
+                    }
+                }
+                if (!stepped) break;
+            }
+        }
+    }
+    return in;
+}
+
+// --- Fuzz input ---
+// Byte 0 picks the target, byte 1 the rect count, byte 2 the edge; then
+// little-endian int32 fields. Rects are origin plus size, and points are
+// placed relative to them (inside the source, inside the destination, or
+// near a boundary), so almost every input meets the preconditions and the
+// fuzzer spends its time on geometry rather than on rejected inputs.
+
+inline bool DecodeDiffInput(const uint8_t* data, size_t size, DiffInput& in) {
+    if (size < 3) return false;
+    in = {};
+    in.target    = static_cast<DiffTarget>(data[0] % static_cast<uint8_t>(DiffTarget::Count));
+    in.rectCount = 1 + data[1] % DIFF_MAX_RECTS;
+    in.edge      = static_cast<Edge>(data[2] % 5);
+    size_t pos = 3;
+    auto next = [&]() -> long {
+        int32_t v = 0;
+        if (pos + 4 <= size) memcpy(&v, data + pos, 4);
+        pos += 4;
+        return static_cast<long>(v % static_cast<int32_t>(DIFF_COORD_LIMIT / 2));
+    };
+    auto within = [](long v, long lo, long len) { return lo + std::abs(v) % len; };
+    for (size_t i = 0; i < in.rectCount; ++i) {
+        long l = next(), t = next(), w = next(), h = next();
+        in.rects[i] = {l, t, l + std::abs(w) % 8192 + 1, t + std::abs(h) % 8192 + 1};
+    }
+    const Rect& r0 = in.rects[0];
+    const Rect& r1 = in.rects[in.rectCount > 1 ? 1 : 0];
+    long ax = next(), ay = next(), bx = next(), by = next();
+    switch (in.target) {
+    case DiffTarget::MonitorIndex: {
+        const Rect& r = in.rects[std::abs(bx) % in.rectCount];
+        in.a = {within(ax, r.left - 2, r.right - r.left + 4), within(ay, r.top - 2, r.bottom - r.top + 4)};
+        break;
+    }
+    case DiffTarget::ExitEdge:
+        in.a = {within(ax, r0.left, r0.right - r0.left), within(ay, r0.top, r0.bottom - r0.top)};
+        in.b = {in.a.x + bx % 16384, in.a.y + by % 16384};
+        break;
+    case DiffTarget::Remap: {
+        bool horiz = in.edge == Edge::Left || in.edge == Edge::Right;
+        long lo = horiz ? r0.top : r0.left, len = horiz ? r0.bottom - r0.top : r0.right - r0.left;
+        in.a.x = within(ax, lo - 8, len + 16);
+        break;
+    }
+    default:
+        in.a = {within(ax, r0.left, r0.right - r0.left), within(ay, r0.top, r0.bottom - r0.top)};
+        in.b = {within(bx, r1.left, r1.right - r1.left), within(by, r1.top, r1.bottom - r1.top)};
+        break;
+    }
+    return DiffInputValid(in);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+// Echo cancellation for self-generated warps. Every warp we issue is
+// recorded (target + sequence + timestamp) in a tiny fixed ring; an incoming
+// motion event landing exactly on a live target is our own echo and is
+// consumed. Lookup scans ECHO_SLOTS entries, so cost is constant and no
+// backend needs a global "currently warping" flag. Echoes may arrive late or
+// interleaved with real motion; entries older than the expiry are ignored.
+//
+// A real motion that lands exactly on a pending target inside the window is
+// also swallowed; that costs one event at a position we just warped to.
+
+#include "mapping.h"
+#include "probes.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct EchoTable {
+    static constexpr size_t ECHO_SLOTS = 8;
+
+    struct Entry {
+        Point    target;
+        uint32_t seq;    // 0 = free
+        uint32_t time;
+    };
+
+    Entry    slots[ECHO_SLOTS] = {};
+    uint32_t nextSeq  = 1;
+    uint32_t expiry   = 250;  // same units as time (ms for hook timestamps)
+
+    uint64_t matched  = 0;    // echoes consumed
+    uint64_t expired  = 0;    // entries dropped without an echo
+    uint64_t evicted  = 0;    // entries overwritten while still live
+
+    // Returns the sequence number, usable with Cancel().
+    uint32_t Record(Point target, uint32_t now) {
+        uint32_t seq = nextSeq++;
+        if (nextSeq == 0) nextSeq = 1;
+        Entry& e = slots[seq % ECHO_SLOTS];
+        if (e.seq) {
+            if (Live(e, now)) ++evicted;
+            else ++expired;
+        }
+        e = {target, seq, now};
+        return seq;
+    }
+
+    // The warp was never applied (e.g. the OS call failed).
+    void Cancel(uint32_t seq) {
+        Entry& e = slots[seq % ECHO_SLOTS];
+        if (e.seq == seq) e.seq = 0;
+    }
+
+    // True when p is the echo of a pending warp; that entry is consumed.
+    // The oldest matching entry wins so repeated warps to one spot pair up
+    // with their echoes in order.
+    bool Consume(Point p, uint32_t now) {
+        Entry* best = nullptr;
+        for (auto& e : slots) {
+            if (!e.seq) continue;
+            if (!Live(e, now)) {
+                e.seq = 0;
+                ++expired;
+                continue;
+            }
+            if (e.target == p && (!best || static_cast<int32_t>(e.seq - best->seq) < 0))
+                best = &e;
+        }
+        if (!best) return false;
+        best->seq = 0;
+        ++matched;
+        CURSOR_MAPPER_PROBE2(echo, p.x, p.y);
+        return true;
+    }
+
+    size_t Pending() const {
+        size_t n = 0;
+        for (auto& e : slots) n += e.seq != 0;
+        return n;
+    }
+
+private:
+    // Signed difference so wrapped tick counters and echoes stamped slightly
+    // before the record (clock granularity) both count as live.
+    bool Live(const Entry& e, uint32_t now) const {
+        return static_cast<int32_t>(now - e.time) <= static_cast<int32_t>(expiry);
+    }
+};
@@ -0,0 +1,326 @@
+#pragma once
+
+// Input filter chain: motion samples flow through a sequence of stages,
+// each processing a batch in place. Chain<...> composes stages at compile
+// time (no virtual dispatch, every stage inlinable); RuntimeChain holds the
+// same stage types behind function pointers so the set can change at runtime.
+
+#include "mapping.h"
+#include "probes.h"
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// --- Motion sample ---
+
+enum MotionFlags : uint32_t {
+    MOTION_REMAPPED  = 1u << 0,  // pos was rewritten by EdgeRemapStage
+    MOTION_CROSSING  = 1u << 1,  // sample moved onto a different monitor
+    MOTION_OFFSCREEN = 1u << 2,  // sample lies outside every monitor
+};
+
+struct MotionSample {
+    Point    pos;     // absolute cursor position
+    double   dx, dy;  // relative motion that led to pos
+    uint32_t time;    // milliseconds (same clock as MSLLHOOKSTRUCT::time)
+    uint32_t flags;   // MotionFlags
+};
+
+// Stage contract:
+//   size_t Process(MotionSample* s, size_t n)
+// rewrites s[0..n) in place and returns the number of samples that remain.
+// Delta stages (dead zone, acceleration) shape dx/dy, SubPixelStage turns
+// deltas into integer positions, EdgeRemapStage works on pos.
+
+// --- Dead zone: drop deltas shorter than radius ---
+
+struct DeadZoneStage {
+    double radius = 0.0;
+
+    size_t Process(MotionSample* s, size_t n) const {
+        double r2 = radius * radius;
+        for (size_t i = 0; i < n; ++i) {
+            if (s[i].dx * s[i].dx + s[i].dy * s[i].dy < r2) {
+                s[i].dx = 0.0;
+                s[i].dy = 0.0;
+            }
+        }
+        return n;
+    }
+};
+
+// --- Acceleration: linear gain above a speed threshold, capped ---
+
+struct AccelCurveStage {
+    double threshold = 2.0;   // counts per sample before gain applies
+    double gain      = 0.05;  // extra scale per count above threshold
+    double maxScale  = 3.0;
+
+    size_t Process(MotionSample* s, size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            double speed = std::sqrt(s[i].dx * s[i].dx + s[i].dy * s[i].dy);
+            double scale = 1.0 + gain * std::max(0.0, speed - threshold);
+            scale = std::min(scale, maxScale);
+            s[i].dx *= scale;
+            s[i].dy *= scale;
+        }
+        return n;
+    }
+};
+
+// --- Sub-pixel accumulation: integrate fractional deltas into pos ---
+
+struct SubPixelStage {
+    Point  cursor{0, 0};
+    double remX = 0.0;
+    double remY = 0.0;
+
+    void Reset(Point p) {
+        cursor = p;
+        remX = remY = 0.0;
+    }
+
+    size_t Process(MotionSample* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            double x = s[i].dx + remX;
+            double y = s[i].dy + remY;
+            long ix = static_cast<long>(x);  // truncate toward zero
+            long iy = static_cast<long>(y);
+            remX = x - ix;
+            remY = y - iy;
+            cursor.x += ix;
+            cursor.y += iy;
+            s[i].pos = cursor;
+        }
+        return n;
+    }
+};
+
+// --- Backlog coalescing: merge queued motion before mapping ---
+// When the consumer falls behind (batch larger than backlogCount, or the
+// oldest sample older than maxAge) consecutive samples are merged into one
+// segment, but only while the whole segment stays inside one monitor. Rects
+// are convex, so if every merged endpoint is inside, the merged segment is
+// too and FindExitEdge on it sees no exit; the sample that leaves the monitor
+// is kept separate, so EdgeRemapStage still sees the exact crossing step and
+// the same lastPos it would have seen without coalescing.
+
+struct CoalesceStage {
+    std::vector<Rect> monitors;
+    size_t   backlogCount = 8;
+    uint32_t maxAge       = 16;    // same units as sample time (ms for hook time)
+    uint32_t now          = 0;     // caller's clock, same units as sample time
+    Point    anchor{0, 0};         // end of the last emitted segment
+    bool     hasAnchor    = false;
+
+    uint64_t coalescedEvents   = 0;  // samples merged away
+    uint64_t coalescedSegments = 0;  // output samples that absorbed others
+
+    void SetMonitors(std::vector<Rect> mons) {
+        monitors  = std::move(mons);
+        hasAnchor = false;
+    }
+
+    bool Backlogged(const MotionSample* s, size_t n) const {
+        // Signed difference so a wrapped tick counter still compares correctly
+        return n >= backlogCount ||
+               (n && static_cast<int32_t>(now - s[0].time) > static_cast<int32_t>(maxAge));
+    }
+
+    size_t Process(MotionSample* s, size_t n) {
+        if (!n) return 0;
+        if (!Backlogged(s, n)) {
+            anchor    = s[n - 1].pos;
+            hasAnchor = true;
+            return n;
+        }
+
+        const Rect* mons = monitors.data();
+        size_t count = monitors.size();
+        int segStartMon = hasAnchor ? MonitorIndexFromPoint(mons, count, anchor) : -1;
+        int lastOutMon  = -1;
+        bool merging    = false;  // s[out - 1] already absorbed a sample
+        size_t out = 0;
+
+        for (size_t i = 0; i < n; ++i) {
+            int mon = MonitorIndexFromPoint(mons, count, s[i].pos);
+            if (out > 0 && mon >= 0 && mon == segStartMon && lastOutMon == segStartMon) {
+                MotionSample& m = s[out - 1];
+                m.pos    = s[i].pos;
+                m.dx    += s[i].dx;
+                m.dy    += s[i].dy;
+                m.time   = s[i].time;
+                m.flags |= s[i].flags;
+                ++coalescedEvents;
+                if (!merging) ++coalescedSegments;
+                merging = true;
+                continue;
+            }
+            if (out > 0) segStartMon = lastOutMon;
+            s[out++]   = s[i];
+            lastOutMon = mon;
+            merging    = false;
+        }
+
+        anchor    = s[out - 1].pos;
+        hasAnchor = true;
+        return out;
+    }
+};
+
+// --- Edge remap: percentage mapping on monitor crossings ---
+// Same decisions MouseHookProc used to make inline: a crossing is a change
+// of monitor between consecutive on-screen samples, the exit edge comes from
+// the previous->current segment and the percentage from the previous point.
+
+struct CrossingInfo {
+    int      src, dst;   // monitor indices
+    Edge     edge;       // exit edge of src; None when no exit was found
+    double   t;          // hit parameter along from -> to
+    Point    from, to;   // segment that crossed
+    Point    mapped;     // position applied (== to unless remapped)
+    bool     remapped;
+    uint32_t time;
+};
+
+// Called for every crossing; crossings are rare, so an indirect call is fine.
+using CrossingFn = void (*)(void* ctx, const CrossingInfo& info);
+
+// Monitor set EdgeRemapStage maps over. Any type with the same two members
+// works; baked_topology.h provides one whose bounds are compile-time
+// constants.
+struct RectListTopology {
+    const Rect* mons;
+    size_t      count;
+
+    int MonitorIndex(Point p) const { return MonitorIndexFromPoint(mons, count, p); }
+
+    CrossingDecision Cross(int src, int dst, Point from, Point to) const {
+        return MapCrossing(mons[src], mons[dst], from, to);
+    }
+};
+
+struct EdgeRemapStage {
+    std::vector<Rect> monitors;
+    int   lastMonitor = -1;
+    Point lastPos{0, 0};
+
+    CrossingFn onCrossing  = nullptr;
+    void*      crossingCtx = nullptr;
+
+    void SetMonitors(std::vector<Rect> mons) {
+        monitors    = std::move(mons);
+        lastMonitor = -1;
+    }
+
+    // Re-anchor on p, e.g. when a remapped position could not be applied.
+    void Resync(Point p) {
+        int cur = MonitorIndexFromPoint(monitors.data(), monitors.size(), p);
+        if (cur >= 0) {
+            lastMonitor = cur;
+            lastPos     = p;
+        }
+    }
+
+    size_t Process(MotionSample* s, size_t n) { return ProcessOver(monitors.data(), monitors.size(), s, n); }
+
+    // Same decisions over a rect list owned elsewhere (a published snapshot),
+    // so callers that must not allocate never copy it into `monitors`.
+    size_t ProcessOver(const Rect* mons, size_t count, MotionSample* s, size_t n) {
+        return ProcessWith(RectListTopology{mons, count}, s, n);
+    }
+
+    // Same decisions over any topology type (see RectListTopology). Resync
+    // still looks indices up in `monitors`.
+    template <typename Topology>
+    size_t ProcessWith(const Topology& topo, MotionSample* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            Point pt = s[i].pos;
+            CURSOR_MAPPER_PROBE3(event_entry, pt.x, pt.y, s[i].time);
+            int cur = topo.MonitorIndex(pt);
+            if (cur < 0) {
+                s[i].flags |= MOTION_OFFSCREEN;
+                CURSOR_MAPPER_PROBE2(offscreen, pt.x, pt.y);
+                continue;
+            }
+
+            if (lastMonitor >= 0 && cur != lastMonitor) {
+                s[i].flags |= MOTION_CROSSING;
+                int src = lastMonitor, dst = cur;
+                CrossingDecision d = topo.Cross(src, dst, lastPos, pt);
+                CURSOR_MAPPER_PROBE4(crossing, src, dst, static_cast<int>(d.hit.edge),
+                                     static_cast<long>(d.hit.t * 1e6));
+                if (d.remapped) {
+                    s[i].pos    = d.mapped;
+                    s[i].flags |= MOTION_REMAPPED;
+                    cur = topo.MonitorIndex(d.mapped);
+                }
+                CURSOR_MAPPER_PROBE5(remap, src, dst, s[i].pos.x, s[i].pos.y,
+                                     (s[i].flags & MOTION_REMAPPED) != 0);
+                if (onCrossing) {
+                    onCrossing(crossingCtx, {src, dst, d.hit.edge, d.hit.t, lastPos, pt, s[i].pos,
+                                             (s[i].flags & MOTION_REMAPPED) != 0, s[i].time});
+                }
+                if (cur < 0) continue;
+            } else {
+                CURSOR_MAPPER_PROBE1(fast_path, cur);
+            }
+            lastMonitor = cur;
+            lastPos     = s[i].pos;
+        }
+        return n;
+    }
+};
+
+// --- Compile-time composition ---
+
+template <typename... Stages>
+class Chain {
+public:
+    size_t Process(MotionSample* s, size_t n) { return Run<0>(s, n); }
+
+    template <typename Stage>
+    Stage& Get() { return std::get<Stage>(stages_); }
+
+private:
+    template <size_t I>
+    size_t Run(MotionSample* s, size_t n) {
+        if constexpr (I == sizeof...(Stages)) {
+            return n;
+        } else {
+            n = std::get<I>(stages_).Process(s, n);
+            return Run<I + 1>(s, n);
+        }
+    }
+
+    std::tuple<Stages...> stages_;
+};
+
+// --- Runtime composition over the same stage types ---
+// Stages are referenced, not owned; they must outlive the chain.
+
+class RuntimeChain {
+public:
+    template <typename Stage>
+    void Add(Stage& stage) {
+        entries_.push_back({&stage, [](void* p, MotionSample* s, size_t n) {
+            return static_cast<Stage*>(p)->Process(s, n);
+        }});
+    }
+
+    void Clear() { entries_.clear(); }
+
+    size_t Process(MotionSample* s, size_t n) const {
+        for (const auto& e : entries_) n = e.fn(e.stage, s, n);
+        return n;
+    }
+
+private:
+    struct Entry {
+        void* stage;
+        size_t (*fn)(void*, MotionSample*, size_t);
+    };
+    std::vector<Entry> entries_;
+};
@@ -3,33 +3,85 @@
 #include <vector>
 #include <string>
 #include <cstdio>
-#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <algorithm>
-#include <climits>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "mapping.h"
+#include "filter_chain.h"
+#include "echo_filter.h"
+#include "topology.h"
+#include "app_profiles.h"
+#include "topology_cache.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "stats_shm.h"
+#include "crossing_bus.h"
+#include "shadow.h"
+#include "mapped_file.h"
+#include "trace_format.h"
+#include "probes.h"
+
+#if defined(CURSOR_MAPPER_BAKED)
+#include "baked_layout.h"  // generated by cursor_mapper_bake (CURSOR_MAPPER_BAKED_LAYOUT)
+#endif
 
 // --- Data structures ---
 
 struct MonitorInfo {
     HMONITOR handle;
-    RECT     rc;
+    Rect     rc;
     bool     primary;
     WCHAR    device[CCHDEVICENAME];
+    double   mmPerPx;  // physical pixel pitch from the raw DPI; 0 when unknown
 };
 
-enum class Edge { None, Left, Right, Top, Bottom };
-
-// --- Global state (main thread only, no locking needed) ---
-
-static std::vector<MonitorInfo> g_monitors;
-static HMONITOR  g_lastMonitor = nullptr;
-static POINT     g_lastPos     = {LONG_MIN, LONG_MIN};
-static bool      g_suppressing = false;
+// Stages run by the hook on every move; crossing state lives in EdgeRemapStage.
+using HookChain = Chain<EdgeRemapStage>;
+
+// --- Global state ---
+// Hook thread (main): mouse hook and mapping state, no locking needed.
+// Topology thread: hidden window, enumeration and signature; hands results
+// to the hook thread only through g_publisher.
+
+static SnapshotPublisher g_publisher;
+static MetricsRegistry   g_metrics;      // read by the exporter thread
+static StatsRegion       g_stats;        // backs g_metrics when shared stats are on
+static CrossingBus       g_bus;          // hook thread writes; external readers map it
+static ShadowEvaluator   g_shadow;       // fed by the hook thread when --shadow is on
+
+static HookChain g_chain;                 // hook thread
+static EchoTable g_echoes;                // hook thread
+static uint64_t  g_topoVersion = 0;       // hook thread: snapshot g_chain is on
+static bool      g_bakedLive = false;     // hook thread: that snapshot is the baked layout
+static const TopologySnapshot* g_policyTopo = nullptr;  // hook thread: that snapshot, if it has portal policies
+static const PortalPolicyTable* g_policyTable = nullptr; // hook thread: its table for g_profile
+static const AppProfile* g_profile = nullptr;           // hook thread: profile g_policyTable is for
+static ThreadMetrics* g_hookMetrics = nullptr;  // hook thread
+static bool      g_replaying = false;     // hook thread: --replay, warps loop back instead of moving the cursor
 static DWORD     g_mainThreadId = 0;
-static HWND      g_hwnd = nullptr;
 static HHOOK     g_hook = nullptr;
 
-static constexpr UINT_PTR TIMER_TOPO_CHECK = 1;
-static constexpr UINT     TOPO_INTERVAL_MS = 30000;
+static std::vector<MonitorInfo> g_monitors;  // topology thread
+static HWND          g_hwnd = nullptr;       // topology thread
+static VerifyBackoff g_verify;               // topology thread
+static WakeupCounter g_wakeups;              // topology thread
+static ThreadMetrics* g_topoMetrics = nullptr;  // topology thread
+static std::string   g_topoCacheDir;         // topology thread; empty: no persisted snapshots
+static PortalStrategyConfig g_strategies;    // topology thread; set before it starts
+static AppProfileTable g_profiles;           // read-only once the topology thread starts
+static ActiveProfile   g_activeProfile;      // focus tracker (topology thread) -> hook thread
+static DWORD         g_focusPid = 0;         // topology thread: last foreground process
+
+static constexpr const char* DEFAULT_METRICS_PIPE = "\\\\.\\pipe\\cursor_mapper_metrics";
+
+// One-shot verification timer, armed only after a change notification
+static constexpr UINT_PTR TIMER_TOPO_VERIFY = 1;
 
 // --- Topology signature for change detection ---
 
@@ -65,225 +117,259 @@ static BOOL CALLBACK MonitorEnumProc(HMONITOR hMon, HDC, LPRECT, LPARAM lParam)
     if (GetMonitorInfoW(hMon, &mi)) {
         MonitorInfo info{};
         info.handle  = hMon;
-        info.rc      = mi.rcMonitor;
+        info.rc      = {mi.rcMonitor.left, mi.rcMonitor.top,
+                        mi.rcMonitor.right, mi.rcMonitor.bottom};
         info.primary = (mi.dwFlags & MONITORINFOF_PRIMARY) != 0;
         wmemcpy(info.device, mi.szDevice, CCHDEVICENAME);
+        UINT dpiX = 0, dpiY = 0;
+        if (SUCCEEDED(GetDpiForMonitor(hMon, MDT_RAW_DPI, &dpiX, &dpiY)) && dpiX) info.mmPerPx = 25.4 / dpiX;
         out->push_back(info);
     }
     return TRUE;
 }
 
-static void RefreshMonitors() {
+// Returns true when the layout changed and a new snapshot was published.
+static bool RefreshMonitors() {
     std::vector<MonitorInfo> fresh;
     EnumDisplayMonitors(nullptr, nullptr, MonitorEnumProc,
                         reinterpret_cast<LPARAM>(&fresh));
     auto sig = BuildTopoSignature(fresh);
-    if (sig == g_topoSignature) return; // no change
+    bool unchanged = sig == g_topoSignature;
+    {
+        MetricsUpdate update(g_topoMetrics);
+        g_topoMetrics->refreshes.Add();
+        if (unchanged) g_topoMetrics->signatureHits.Add();
+        else g_topoMetrics->publishes.Add();
+    }
+    if (unchanged) return false;
+
+    std::vector<Rect> rects;
+    rects.reserve(fresh.size());
+    for (auto& m : fresh) rects.push_back(m.rc);
+
+    // A layout seen before comes back from its cache file; anything else is
+    // derived here and persisted once it is live
+    uint64_t sigHash = TopologySignatureHash(sig);
+    std::unique_ptr<TopologySnapshot> snap;
+    if (!g_topoCacheDir.empty()) {
+        const char* why = nullptr;
+        snap = LoadTopologyCache(g_topoCacheDir, sigHash, &why);
+        if (snap && !std::equal(rects.begin(), rects.end(), snap->monitors.begin(), snap->monitors.end(),
+                                [](const Rect& a, const Rect& b) { return memcmp(&a, &b, sizeof(a)) == 0; })) {
+            snap.reset();
+            why = "monitor rects differ";
+        }
+        if (!snap && strcmp(why, "no cache file") != 0) printf("Topology cache rejected: %s\n", why);
+    }
+    bool cached = snap != nullptr;
+    if (!snap) {
+        snap = std::make_unique<TopologySnapshot>();
+        snap->monitors = std::move(rects);
+        snap->portals  = BuildPortals(snap->monitors);
+    }
 
+    // Policies depend on the command line, so they are resolved here rather
+    // than cached with the layout
+    std::vector<double> pitches;
+    for (auto& m : fresh) pitches.push_back(m.mmPerPx);
+    snap->policies = BuildPortalPolicies(snap->monitors, snap->portals, g_strategies, pitches);
+    snap->profiles = BuildProfilePolicies(g_profiles, snap->monitors, snap->portals, pitches);
+
+#if defined(CURSOR_MAPPER_BAKED)
+    // The baked pairs only know percentage mapping
+    snap->baked = !snap->policies.Custom() && BakedLayoutMatches<BakedLayout>(sigHash, snap->monitors);
+#endif
+
+    // Only this thread publishes, so the snapshot outlives the write below
+    const TopologySnapshot* live = snap.get();
     g_monitors      = std::move(fresh);
     g_topoSignature = std::move(sig);
-    g_lastMonitor   = nullptr;
-    g_lastPos        = {LONG_MIN, LONG_MIN};
-    printf("Monitors refreshed (%zu detected)\n", g_monitors.size());
+    g_publisher.Publish(std::move(snap));
+    printf("Monitors refreshed (%zu detected, %zu portals%s%s)\n", g_monitors.size(), live->portals.size(),
+           cached ? ", from cache" : "", live->baked ? ", baked layout" : "");
+    for (const PortalTransform& t : live->policies.transforms) {
+        if (t.strategy == RemapStrategy::Percent) continue;
+        const TopologyPortal& p = live->portals[&t - live->policies.transforms.data()];
+        printf("  portal %d->%d (%s): %s\n", p.src, p.dst, EdgeName(p.edge), RemapStrategyName(t.strategy));
+    }
+    if (!cached && !g_topoCacheDir.empty() &&
+        !WriteTopologyCache(TopologyCachePath(g_topoCacheDir, sigHash), sigHash, *live))
+        printf("Failed to write topology cache in %s\n", g_topoCacheDir.c_str());
+    return true;
 }
 
-// --- Edge detection via line-segment / rect intersection ---
-// RECT is half-open [left, right) / [top, bottom) for pixel containment,
-// but intersection tests use closed intervals to capture corner exits.
+// Layout description for cursor_mapper_bake: the signature hash and the
+// rects in published order.
+static bool WriteLayout(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "# cursor_mapper layout, %zu monitor(s)\n", g_monitors.size());
+    fprintf(f, "signature %016llx\n", static_cast<unsigned long long>(TopologySignatureHash(g_topoSignature)));
+    for (auto& m : g_monitors) fprintf(f, "monitor %ld %ld %ld %ld\n", m.rc.left, m.rc.top, m.rc.right, m.rc.bottom);
+    return fclose(f) == 0;
+}
 
-struct HitResult {
-    Edge   edge;
-    double t;       // parameter along segment [0,1]
-    double coord;   // intersection coordinate along the edge
-};
+// Re-arm (or drop) the verification timer from g_verify's schedule.
+static void ArmVerifyTimer() {
+    uint64_t delay = g_verify.NextDelay(GetTickCount64());
+    if (delay == NO_DEADLINE) {
+        KillTimer(g_hwnd, TIMER_TOPO_VERIFY);
+        return;
+    }
+    // USER_TIMER_MINIMUM is 10 ms; SetTimer clamps smaller values itself
+    SetTimer(g_hwnd, TIMER_TOPO_VERIFY, static_cast<UINT>(delay), nullptr);
+}
 
-static HitResult FindExitEdge(POINT p0, POINT p1, const RECT& rc) {
-    double dx = static_cast<double>(p1.x) - p0.x;
-    double dy = static_cast<double>(p1.y) - p0.y;
-
-    HitResult best{Edge::None, 2.0, 0.0};
-
-    auto tryEdge = [&](Edge e, double t, double along) {
-        if (t < -1e-9 || t > 1.0) return;
-        // t≈0: p0 is on the edge, only accept if moving outward
-        if (t < 1e-9) {
-            bool outward = (e == Edge::Left && dx < 0) ||
-                           (e == Edge::Right && dx > 0) ||
-                           (e == Edge::Top && dy < 0) ||
-                           (e == Edge::Bottom && dy > 0);
-            if (!outward) return;
-        }
-        if (t < best.t - 1e-9) {
-            best = {e, t, along};
-        } else if (std::abs(t - best.t) < 1e-9) {
-            bool horiz = (e == Edge::Left || e == Edge::Right);
-            if (horiz && std::abs(dx) >= std::abs(dy)) best = {e, t, along};
-            if (!horiz && std::abs(dy) > std::abs(dx)) best = {e, t, along};
-        }
-    };
+// --- Low-level mouse hook ---
 
-    // Right edge: x = rc.right
-    if (dx != 0.0) {
-        double t = (rc.right - p0.x) / dx;
-        double y = p0.y + t * dy;
-        if (y >= rc.top && y <= rc.bottom)
-            tryEdge(Edge::Right, t, y);
-    }
-    // Left edge: x = rc.left
-    if (dx != 0.0) {
-        double t = (rc.left - p0.x) / dx;
-        double y = p0.y + t * dy;
-        if (y >= rc.top && y <= rc.bottom)
-            tryEdge(Edge::Left, t, y);
-    }
-    // Bottom edge: y = rc.bottom
-    if (dy != 0.0) {
-        double t = (rc.bottom - p0.y) / dy;
-        double x = p0.x + t * dx;
-        if (x >= rc.left && x <= rc.right)
-            tryEdge(Edge::Bottom, t, x);
-    }
-    // Top edge: y = rc.top
-    if (dy != 0.0) {
-        double t = (rc.top - p0.y) / dy;
-        double x = p0.x + t * dx;
-        if (x >= rc.left && x <= rc.right)
-            tryEdge(Edge::Top, t, x);
-    }
-
-    return best;
+static void OnCrossing(void*, const CrossingInfo& c) {
+    g_hookMetrics->CountPortal(c.src, c.dst);
+    if (g_bus.IsOpen())
+        g_bus.Publish(MakeCrossingEvent(c.src, c.dst, c.edge, c.from, c.to, c.mapped, c.remapped, c.time));
+    if (g_shadow.Running()) {
+        const auto& mons = g_chain.Get<EdgeRemapStage>().monitors;
+        CrossingDecision live{{c.edge, c.t, 0.0}, c.remapped, c.mapped};
+        if (!g_shadow.Submit({mons[c.src], mons[c.dst], c.from, c.to, c.src, c.dst, live, c.time}))
+            g_hookMetrics->shadowDropped.Add();
+    }
 }
 
-// --- Percentage mapping with shared-edge overlap ---
+// Shadow thread: log the first few divergences, count the rest
+static constexpr unsigned SHADOW_LOG_LIMIT = 20;
+
+static void OnShadowDivergence(void*, const ShadowDivergence& d) {
+    static unsigned logged = 0;
+    if (logged >= SHADOW_LOG_LIMIT) return;
+    const ShadowCrossing& c = d.crossing;
+    printf("Shadow %s divergence: %d->%d (%ld,%ld)->(%ld,%ld) live %s(%ld,%ld) candidate %s(%ld,%ld)%s\n",
+           ShadowDiffName(d.kind), c.srcIndex, c.dstIndex, c.from.x, c.from.y, c.to.x, c.to.y,
+           c.live.remapped ? "" : "kept ", c.live.mapped.x, c.live.mapped.y,
+           d.candidate.remapped ? "" : "kept ", d.candidate.mapped.x, d.candidate.mapped.y,
+           ++logged == SHADOW_LOG_LIMIT ? " (further divergences are only counted)" : "");
+}
 
-static const MonitorInfo* FindMonitor(HMONITOR h) {
-    for (auto& m : g_monitors)
-        if (m.handle == h) return &m;
-    return nullptr;
+// Fixed-layout build on its baked layout: EdgeRemapStage (the whole of
+// HookChain) with every bound an immediate.
+static void ProcessBaked(EdgeRemapStage& remap, MotionSample& sample) {
+#if defined(CURSOR_MAPPER_BAKED)
+    remap.ProcessWith(BakedTopology<BakedLayout>{}, &sample, 1);
+#else
+    (void)remap;
+    (void)sample;
+#endif
 }
 
-static bool RemapCursor(const RECT& src, const RECT& dst, Edge edge, double hitCoord, POINT& out) {
-    // Overlap: only used to verify monitors are adjacent
-    // Percentage is based on source full edge, mapped to destination full edge
-    long ovStart, ovEnd, srcStart, srcEnd, dstStart, dstEnd;
+// Returns true when the event was replaced by a warp and must be swallowed.
+static bool HandleMove(const MSLLHOOKSTRUCT& ms) {
+    MetricsUpdate update(g_hookMetrics);
+    LatencyScope timing(&g_hookMetrics->mapLatency);
+    Point pt{ms.pt.x, ms.pt.y};
+    uint32_t now = static_cast<uint32_t>(ms.time);
+
+    // Echo of our own SetCursorPos: consume its pending record
+    if (g_echoes.Consume(pt, now)) {
+        g_hookMetrics->echoes.Add();
+        return false;
+    }
+    // Skip other injected events (SendInput from other tools)
+    if (ms.flags & LLMHF_INJECTED) return false;
+
+    // Pick up a layout published by the topology thread and the profile of
+    // the focused application (neither blocks; both were resolved elsewhere)
+    auto& remap = g_chain.Get<EdgeRemapStage>();
+    const TopologySnapshot* topo = g_publisher.Acquire();
+    const AppProfile* profile = g_activeProfile.Get();
+    if (topo && (topo->version != g_topoVersion || profile != g_profile)) {
+        if (topo->version != g_topoVersion) remap.SetMonitors(topo->monitors);
+        g_topoVersion = topo->version;
+        g_profile     = profile;
+        g_policyTable = ProfilePolicies(*topo, profile);
+        g_policyTopo  = g_policyTable ? topo : nullptr;
+        g_bakedLive   = topo->baked && !g_policyTable;
+    }
 
-    if (edge == Edge::Left || edge == Edge::Right) {
-        ovStart  = std::max(src.top, dst.top);
-        ovEnd    = std::min(src.bottom, dst.bottom);
-        srcStart = src.top;  srcEnd = src.bottom;
-        dstStart = dst.top;  dstEnd = dst.bottom;
+    MotionSample sample{pt,
+                        static_cast<double>(pt.x - remap.lastPos.x),
+                        static_cast<double>(pt.y - remap.lastPos.y),
+                        now, 0};
+    if (g_bakedLive) {
+        ProcessBaked(remap, sample);
+    } else if (g_policyTopo) {
+        const auto& mons = g_policyTopo->monitors;
+        remap.ProcessWith(PolicyTopology<>{mons.data(), mons.size(), g_policyTable}, &sample, 1);
     } else {
-        ovStart  = std::max(src.left, dst.left);
-        ovEnd    = std::min(src.right, dst.right);
-        srcStart = src.left;  srcEnd = src.right;
-        dstStart = dst.left;  dstEnd = dst.right;
+        g_chain.Process(&sample, 1);
     }
-
-    long srcLen = srcEnd - srcStart;
-    long dstLen = dstEnd - dstStart;
-    if (ovEnd - ovStart <= 0 || srcLen <= 0 || dstLen <= 0) return false;
-
-    // Percentage along source full edge
-    double pct = (hitCoord - srcStart) / static_cast<double>(srcLen);
-    pct = std::clamp(pct, 0.0, 1.0);
-
-    // Map to destination full edge, then round, then inset 1px
-    long mapped = dstStart + static_cast<long>(std::lround(pct * dstLen));
-    mapped = std::clamp(mapped, dstStart + 1, dstEnd - 2);
-
-    // Build output point
-    switch (edge) {
-    case Edge::Right:  out = {dst.left + 1, mapped};     break;
-    case Edge::Left:   out = {dst.right - 2, mapped};    break;
-    case Edge::Bottom: out = {mapped, dst.top + 1};      break;
-    case Edge::Top:    out = {mapped, dst.bottom - 2};   break;
-    default: return false;
+    g_hookMetrics->CountSample(sample);
+
+    if (sample.flags & MOTION_REMAPPED) {
+        uint32_t seq = g_echoes.Record(sample.pos, g_replaying ? now : GetTickCount());
+        BOOL warped = g_replaying ? TRUE : SetCursorPos(sample.pos.x, sample.pos.y);
+        CURSOR_MAPPER_PROBE3(warp, sample.pos.x, sample.pos.y, warped != 0);
+        if (warped) {
+            g_hookMetrics->remaps.Add();
+            return true;
+        }
+        g_hookMetrics->warpFailures.Add();
+        g_echoes.Cancel(seq);
+        remap.Resync(pt);
     }
-    return true;
+    return false;
 }
 
-// --- Low-level mouse hook ---
-
 static LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
-    if (nCode == HC_ACTION && wParam == WM_MOUSEMOVE) {
-        auto* ms = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-
-        // Skip injected events (primary anti-recursion guard)
-        if (ms->flags & LLMHF_INJECTED) {
-            // printf("[DBG] skip injected pt=(%ld,%ld) flags=0x%lx\n", ms->pt.x, ms->pt.y, ms->flags);
-            return CallNextHookEx(g_hook, nCode, wParam, lParam);
-        }
-        // Skip if we just called SetCursorPos (secondary guard)
-        if (g_suppressing) {
-            return CallNextHookEx(g_hook, nCode, wParam, lParam);
-        }
-
-        POINT pt = ms->pt;
-        HMONITOR curMon = MonitorFromPoint(pt, MONITOR_DEFAULTTONULL);
-        if (!curMon) { /* printf("[DBG] MonitorFromPoint returned NULL for (%ld,%ld)\n", pt.x, pt.y); */ goto done; }
-
-        if (g_lastMonitor && curMon != g_lastMonitor &&
-            g_lastPos.x != LONG_MIN)
-        {
-            // printf("[DBG] CROSS detected: lastMon=%p curMon=%p lastPos=(%ld,%ld) pt=(%ld,%ld)\n",
-            //        (void*)g_lastMonitor, (void*)curMon, g_lastPos.x, g_lastPos.y, pt.x, pt.y);
-            const MonitorInfo* src = FindMonitor(g_lastMonitor);
-            const MonitorInfo* dst = FindMonitor(curMon);
-
-            // printf("[DBG] FindMonitor: src=%p dst=%p\n", (const void*)src, (const void*)dst);
-            if (src && dst) {
-                // printf("[DBG] src rc=(%ld,%ld,%ld,%ld) dst rc=(%ld,%ld,%ld,%ld)\n",
-                //        src->rc.left, src->rc.top, src->rc.right, src->rc.bottom,
-                //        dst->rc.left, dst->rc.top, dst->rc.right, dst->rc.bottom);
-                HitResult hit = FindExitEdge(g_lastPos, pt, src->rc);
-                // printf("[DBG] FindExitEdge: edge=%d t=%.6f coord=%.1f\n",
-                //        (int)hit.edge, hit.t, hit.coord);
-                if (hit.edge != Edge::None) {
-                    // Use lastPos coordinate for percentage (pt may be clipped by system)
-                    double srcCoord = (hit.edge == Edge::Left || hit.edge == Edge::Right)
-                        ? static_cast<double>(g_lastPos.y)
-                        : static_cast<double>(g_lastPos.x);
-                    POINT mapped;
-                    if (RemapCursor(src->rc, dst->rc, hit.edge,
-                                    srcCoord, mapped))
-                    {
-                        // printf("[DBG] RemapCursor: mapped=(%ld,%ld) cur=(%ld,%ld)\n",
-                        //        mapped.x, mapped.y, pt.x, pt.y);
-                        if (mapped.x != pt.x || mapped.y != pt.y) {
-                            g_suppressing = true;
-                            BOOL ok = SetCursorPos(mapped.x, mapped.y);
-                            g_suppressing = false;
-                            // printf("[DBG] SetCursorPos(%ld,%ld) => %d\n", mapped.x, mapped.y, ok);
-                            if (ok) {
-                                g_lastMonitor = MonitorFromPoint(
-                                    mapped, MONITOR_DEFAULTTONULL);
-                                g_lastPos = mapped;
-                                return 1; // suppress original event
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    done:
-        if (wParam == WM_MOUSEMOVE) {
-            auto* ms2 = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-            HMONITOR cur = MonitorFromPoint(ms2->pt, MONITOR_DEFAULTTONULL);
-            if (cur) {
-                g_lastMonitor = cur;
-                g_lastPos = ms2->pt;
-            }
-        }
+    if (nCode == HC_ACTION && wParam == WM_MOUSEMOVE &&
+        HandleMove(*reinterpret_cast<MSLLHOOKSTRUCT*>(lParam)))
+    {
+        return 1; // suppress original event
     }
     return CallNextHookEx(g_hook, nCode, wParam, lParam);
 }
 
+// --- Trace replay (--replay) ---
+// A recorded trace through HandleMove on the layout it was recorded on, with
+// no hook installed and each warp looped back as its echo instead of moving
+// the cursor. cursor_mapper_pgo_train profiles the hook path this way.
+
+static bool ReplayTrace(const std::string& path) {
+    MappedFile map;
+    const char* why = "cannot open";
+    if (!map.Open(path) || map.Size() < sizeof(TraceHeader) ||
+        !ValidateTraceHeader(*reinterpret_cast<const TraceHeader*>(map.Data()), map.Size(), &why)) {
+        printf("Cannot replay %s: %s\n", path.c_str(), why);
+        return false;
+    }
+    auto snap = std::make_unique<TopologySnapshot>();
+    snap->monitors = TraceMonitors(*reinterpret_cast<const TraceHeader*>(map.Data()));
+    snap->portals  = BuildPortals(snap->monitors);
+    snap->policies = BuildPortalPolicies(snap->monitors, snap->portals, g_strategies);
+    g_publisher.Publish(std::move(snap));
+
+    const auto* records = reinterpret_cast<const TraceRecord*>(map.Data() + sizeof(TraceHeader));
+    uint64_t count = TraceRecordCount(map.Size()), remaps = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        MSLLHOOKSTRUCT ms{};
+        ms.pt   = {records[i].x, records[i].y};
+        ms.time = records[i].time;
+        if (!HandleMove(ms)) continue;
+        // The warp's echo arrives next
+        ++remaps;
+        const Point& to = g_chain.Get<EdgeRemapStage>().lastPos;
+        ms.pt = {static_cast<LONG>(to.x), static_cast<LONG>(to.y)};
+        HandleMove(ms);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    printf("Replayed %s: %llu events, %llu remaps, %.1f ns/event\n", path.c_str(),
+           static_cast<unsigned long long>(count), static_cast<unsigned long long>(remaps),
+           count ? ns / static_cast<double>(count) : 0.0);
+    return true;
+}
+
 // --- Console Ctrl handler (runs on a separate thread) ---
 
 static BOOL WINAPI ConsoleCtrlHandler(DWORD) {
-    if (!PostThreadMessage(g_mainThreadId, WM_QUIT, 0, 0)) {
-        if (g_hwnd) PostMessage(g_hwnd, WM_CLOSE, 0, 0);
-    }
+    PostThreadMessage(g_mainThreadId, WM_QUIT, 0, 0);
     return TRUE;
 }
 
@@ -293,10 +379,18 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
     switch (msg) {
     case WM_DISPLAYCHANGE:
     case WM_SETTINGCHANGE:
+        ++g_wakeups.notifications;
         RefreshMonitors();
+        g_verify.OnChangeNotification(GetTickCount64());
+        ArmVerifyTimer();
         return 0;
     case WM_TIMER:
-        if (wParam == TIMER_TOPO_CHECK) RefreshMonitors();
+        if (wParam == TIMER_TOPO_VERIFY) {
+            ++g_wakeups.timerWakeups;
+            bool changed = RefreshMonitors();
+            g_verify.OnChecked(GetTickCount64(), changed);
+            ArmVerifyTimer();
+        }
         return 0;
     case WM_CLOSE:
         PostQuitMessage(0);
@@ -305,21 +399,40 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
     return DefWindowProc(hwnd, msg, wParam, lParam);
 }
 
-// --- Entry point ---
-
-int main() {
-    // DPI awareness (non-fatal fallback for manifest)
-    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+// --- Focus tracking (per-application profiles) ---
+// EVENT_SYSTEM_FOREGROUND arrives on the topology thread's message loop
+// (out of context). The process name is resolved here, once per change of
+// foreground process; the hook thread only sees the resulting pointer.
+
+static const AppProfile* ResolveProfile(DWORD pid) {
+    HANDLE proc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!proc) return nullptr;
+    wchar_t wide[MAX_PATH];
+    DWORD len = MAX_PATH;
+    char path[MAX_PATH * 3] = {};
+    if (QueryFullProcessImageNameW(proc, 0, wide, &len))
+        WideCharToMultiByte(CP_UTF8, 0, wide, static_cast<int>(len), path, sizeof(path) - 1, nullptr, nullptr);
+    CloseHandle(proc);
+    return g_profiles.FindPath(path);
+}
 
-    g_mainThreadId = GetCurrentThreadId();
-    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+static void CALLBACK OnForeground(HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject, LONG, DWORD, DWORD) {
+    if (!hwnd || idObject != OBJID_WINDOW) return;
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    if (pid == g_focusPid) return;
+    g_focusPid = pid;
+    const AppProfile* profile = ResolveProfile(pid);
+    if (profile == g_activeProfile.Get()) return;
+    g_activeProfile.Set(profile);
+    printf("Profile: %s\n", profile ? profile->app.c_str() : "default");
+}
 
-    RefreshMonitors();
-    if (g_monitors.empty()) {
-        printf("No monitors detected.\n");
-        return 1;
-    }
+// --- Topology thread ---
+// Owns the hidden window, so display notifications and the enumeration they
+// trigger never run on the hook thread. `ready` reports window setup.
 
+static void TopologyThread(std::promise<bool> ready) {
     // Hidden top-level window for WM_DISPLAYCHANGE / WM_SETTINGCHANGE
     WNDCLASSW wc{};
     wc.lpfnWndProc   = WndProc;
@@ -327,7 +440,8 @@ int main() {
     wc.lpszClassName  = L"CursorMapperHidden";
     if (!RegisterClassW(&wc)) {
         printf("Failed to register window class: %lu\n", GetLastError());
-        return 1;
+        ready.set_value(false);
+        return;
     }
 
     g_hwnd = CreateWindowExW(0, wc.lpszClassName, nullptr,
@@ -335,24 +449,211 @@ int main() {
                              nullptr, nullptr, wc.hInstance, nullptr);
     if (!g_hwnd) {
         printf("Failed to create hidden window: %lu\n", GetLastError());
+        ready.set_value(false);
+        return;
+    }
+
+    // Foreground changes, only when some application has a profile
+    HWINEVENTHOOK focusHook = nullptr;
+    if (g_profiles.Size()) {
+        focusHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, OnForeground, 0, 0,
+                                    WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+        if (!focusHook) printf("Failed to track the foreground window: %lu\n", GetLastError());
+        else OnForeground(nullptr, EVENT_SYSTEM_FOREGROUND, GetForegroundWindow(), OBJID_WINDOW, CHILDID_SELF, 0, 0);
+    }
+
+    g_wakeups.startMs = GetTickCount64();
+    ready.set_value(true);
+
+    MSG msg;
+    BOOL ret;
+    while ((ret = GetMessage(&msg, nullptr, 0, 0)) != 0) {
+        if (ret == -1) {
+            printf("GetMessage error (topology): %lu\n", GetLastError());
+            break;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    if (focusHook) UnhookWinEvent(focusHook);
+    KillTimer(g_hwnd, TIMER_TOPO_VERIFY);
+    DestroyWindow(g_hwnd);
+    printf("Topology wakeups: %llu (%.2f/h)\n",
+           static_cast<unsigned long long>(g_wakeups.Total()),
+           g_wakeups.PerHour(GetTickCount64()));
+}
+
+// --- Entry point ---
+
+int main(int argc, char** argv) {
+    std::string metricsPipe = DEFAULT_METRICS_PIPE;
+    std::string statsName   = DEFAULT_STATS_NAME;
+    std::string busName     = DEFAULT_BUS_NAME;
+    const ShadowCandidate* shadow = nullptr;
+    std::string layoutOut;
+    std::vector<std::string> replay;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--no-verify-poll") == 0) {
+            g_verify.enabled = false;
+        } else if (strncmp(argv[i], "--metrics-pipe=", 15) == 0) {
+            metricsPipe = argv[i] + 15;
+        } else if (strcmp(argv[i], "--no-metrics") == 0) {
+            metricsPipe.clear();
+        } else if (strncmp(argv[i], "--stats-shm=", 12) == 0) {
+            statsName = argv[i] + 12;
+        } else if (strcmp(argv[i], "--no-stats-shm") == 0) {
+            statsName.clear();
+        } else if (strncmp(argv[i], "--crossing-bus=", 15) == 0) {
+            busName = argv[i] + 15;
+        } else if (strcmp(argv[i], "--no-crossing-bus") == 0) {
+            busName.clear();
+        } else if (strncmp(argv[i], "--print-layout=", 15) == 0) {
+            layoutOut = argv[i] + 15;
+        } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+            replay.push_back(argv[i] + 9);
+        } else if (strncmp(argv[i], "--topology-cache=", 17) == 0) {
+            g_topoCacheDir = argv[i] + 17;
+        } else if (strncmp(argv[i], "--strategy=", 11) == 0) {
+            if (!ParseRemapStrategy(argv[i] + 11, g_strategies.fallback)) {
+                printf("Unknown strategy: %s (percent, pass-through, physical, offset, clamped)\n", argv[i] + 11);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--portal-strategy=", 18) == 0) {
+            PortalStrategyConfig::Override o{};
+            char name[32] = {};
+            if (sscanf(argv[i] + 18, "%d:%d=%31s", &o.src, &o.dst, name) != 3 || !ParseRemapStrategy(name, o.strategy)) {
+                printf("Bad portal strategy: %s (expected SRC:DST=STRATEGY)\n", argv[i] + 18);
+                return 1;
+            }
+            g_strategies.overrides.push_back(o);
+        } else if (strncmp(argv[i], "--app-profile=", 14) == 0) {
+            std::string app;
+            PortalStrategyConfig config;
+            if (!ParseAppProfile(argv[i] + 14, app, config)) {
+                printf("Bad app profile: %s (expected APP=STRATEGY[,SRC:DST=STRATEGY]...)\n", argv[i] + 14);
+                return 1;
+            }
+            if (!g_profiles.Add(app, config)) {
+                printf("Duplicate app profile: %s\n", app.c_str());
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--max-jump=", 11) == 0) {
+            g_strategies.maxJump = std::max(0L, strtol(argv[i] + 11, nullptr, 10));
+        } else if (strncmp(argv[i], "--shadow=", 9) == 0) {
+            shadow = FindShadowCandidate(argv[i] + 9);
+            if (!shadow) {
+                printf("Unknown shadow candidate: %s\n", argv[i] + 9);
+                for (const auto& c : SHADOW_CANDIDATES) printf("  %-14s %s\n", c.name, c.description);
+                return 1;
+            }
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Usage: cursor_mapper [--no-verify-poll] [--metrics-pipe=NAME | --no-metrics]\n"
+                   "                     [--stats-shm=NAME | --no-stats-shm] [--shadow=CANDIDATE]\n"
+                   "                     [--crossing-bus=NAME | --no-crossing-bus]\n"
+                   "                     [--strategy=STRATEGY] [--portal-strategy=SRC:DST=STRATEGY]...\n"
+                   "                     [--max-jump=PX] [--app-profile=APP=STRATEGY[,SRC:DST=STRATEGY]...]...\n"
+                   "                     [--topology-cache=DIR] [--print-layout=FILE] [--replay=TRACE]...\n");
+            return 1;
+        }
+    }
+
+    g_profiles.SetMaxJump(g_strategies.maxJump);
+    for (size_t i = 0; i < g_profiles.Size(); ++i)
+        printf("App profile %s: %s%s\n", g_profiles[i].app.c_str(), RemapStrategyName(g_profiles[i].strategies.fallback),
+               g_profiles[i].strategies.overrides.empty() ? "" : " (with portal overrides)");
+
+    // A replay must not take over the regions of an instance that is running
+    if (!replay.empty()) {
+        statsName.clear();
+        busName.clear();
+    }
+
+    // Counters live in the shared region when available, so cursor_mapper_stat
+    // reads them without talking to this process
+    if (!statsName.empty()) {
+        if (g_stats.Create(statsName)) {
+            g_metrics.UseStorage(g_stats.Blocks(), STATS_SLOTS);
+            printf("Stats region %s\n", statsName.c_str());
+        } else {
+            printf("Failed to create stats region %s: %s\n", statsName.c_str(), g_stats.Error());
+        }
+    }
+    // Crossing events for external subscribers (screen recorders, a11y)
+    if (!busName.empty()) {
+        if (g_bus.Create(busName)) printf("Crossing bus %s\n", busName.c_str());
+        else printf("Failed to create crossing bus %s: %s\n", busName.c_str(), g_bus.Error());
+    }
+    g_hookMetrics = g_metrics.Register();
+    g_topoMetrics = g_metrics.Register();
+    g_chain.Get<EdgeRemapStage>().onCrossing = OnCrossing;
+    if (shadow) {
+        g_shadow.Start(shadow->fn, g_metrics.Register(), OnShadowDivergence);
+        printf("Shadow candidate: %s (%s)\n", shadow->name, shadow->description);
+    }
+
+    // Offline: no hook and no topology thread, each trace brings its layout
+    if (!replay.empty()) {
+        g_replaying = true;
+        bool ok = true;
+        for (const auto& path : replay) ok = ReplayTrace(path) && ok;
+        g_shadow.Stop();
+        return ok ? 0 : 1;
+    }
+
+    // DPI awareness (non-fatal fallback for manifest)
+    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+    g_mainThreadId = GetCurrentThreadId();
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+
+    RefreshMonitors();
+    if (g_monitors.empty()) {
+        printf("No monitors detected.\n");
         return 1;
     }
+    if (!layoutOut.empty()) {
+        if (!WriteLayout(layoutOut)) {
+            printf("Failed to write %s\n", layoutOut.c_str());
+            return 1;
+        }
+        printf("Layout written to %s (input for cursor_mapper_bake)\n", layoutOut.c_str());
+        return 0;
+    }
 
-    if (!SetTimer(g_hwnd, TIMER_TOPO_CHECK, TOPO_INTERVAL_MS, nullptr)) {
-        printf("Failed to create topology check timer: %lu\n", GetLastError());
-        DestroyWindow(g_hwnd);
+    // Topology thread takes over g_monitors / g_topoSignature from here
+    std::promise<bool> topoReady;
+    auto topoStarted = topoReady.get_future();
+    std::thread topoThread(TopologyThread, std::move(topoReady));
+    if (!topoStarted.get()) {
+        topoThread.join();
         return 1;
     }
 
+    auto stopTopology = [&] {
+        PostMessage(g_hwnd, WM_CLOSE, 0, 0);
+        topoThread.join();
+    };
+
     // Install low-level mouse hook
     g_hook = SetWindowsHookExW(WH_MOUSE_LL, MouseHookProc,
                                GetModuleHandle(nullptr), 0);
     if (!g_hook) {
         printf("Failed to install mouse hook: %lu\n", GetLastError());
-        DestroyWindow(g_hwnd);
+        stopTopology();
         return 1;
     }
 
+    // Exporter thread renders from the per-thread blocks on each connection
+    MetricsServer metricsServer;
+    if (!metricsPipe.empty()) {
+        if (metricsServer.Start(metricsPipe, [] { return g_metrics.RenderPrometheus(); }))
+            printf("Metrics on %s\n", metricsPipe.c_str());
+        else
+            printf("Failed to start metrics pipe %s\n", metricsPipe.c_str());
+    }
+
     printf("cursor_mapper running. Press Ctrl+C to exit.\n");
 
     // Message loop (required for WH_MOUSE_LL dispatch)
@@ -368,8 +669,11 @@ int main() {
     }
 
     UnhookWindowsHookEx(g_hook);
-    KillTimer(g_hwnd, TIMER_TOPO_CHECK);
-    DestroyWindow(g_hwnd);
+    g_shadow.Stop();
+    metricsServer.Stop();
+    stopTopology();
+    g_stats.Close();
+    g_bus.Close();
     printf("cursor_mapper stopped.\n");
     return 0;
 }
@@ -0,0 +1,181 @@
+#pragma once
+
+// Portable mapping core: edge detection and percentage remap.
+// No Windows headers here so benchmarks and tools build on any platform.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// --- Geometry (layout-compatible with Win32 POINT / RECT) ---
+
+struct Point {
+    long x, y;
+};
+
+// Half-open [left, right) / [top, bottom), same convention as RECT.
+struct Rect {
+    long left, top, right, bottom;
+};
+
+enum class Edge { None, Left, Right, Top, Bottom };
+
+inline const char* EdgeName(Edge e) {
+    switch (e) {
+    case Edge::Left:   return "left";
+    case Edge::Right:  return "right";
+    case Edge::Top:    return "top";
+    case Edge::Bottom: return "bottom";
+    default:           return "none";
+    }
+}
+
+inline bool operator==(Point a, Point b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(Point a, Point b) { return !(a == b); }
+
+inline bool Contains(const Rect& rc, Point p) {
+    return p.x >= rc.left && p.x < rc.right && p.y >= rc.top && p.y < rc.bottom;
+}
+
+// Equivalent of MonitorFromPoint(pt, MONITOR_DEFAULTTONULL) over a rect list.
+// Returns the monitor index or -1 when the point lies outside every monitor.
+inline int MonitorIndexFromPoint(const Rect* mons, size_t count, Point p) {
+    for (size_t i = 0; i < count; ++i)
+        if (Contains(mons[i], p)) return static_cast<int>(i);
+    return -1;
+}
+
+// --- Edge detection via line-segment / rect intersection ---
+// RECT is half-open [left, right) / [top, bottom) for pixel containment,
+// but intersection tests use closed intervals to capture corner exits.
+
+struct HitResult {
+    Edge   edge;
+    double t;       // parameter along segment [0,1]
+    double coord;   // intersection coordinate along the edge
+};
+
+inline HitResult FindExitEdge(Point p0, Point p1, const Rect& rc) {
+    double dx = static_cast<double>(p1.x) - p0.x;
+    double dy = static_cast<double>(p1.y) - p0.y;
+
+    HitResult best{Edge::None, 2.0, 0.0};
+
+    auto tryEdge = [&](Edge e, double t, double along) {
+        if (t < -1e-9 || t > 1.0) return;
+        // t≈0: p0 is on the edge, only accept if moving outward
+        if (t < 1e-9) {
+            bool outward = (e == Edge::Left && dx < 0) ||
+                           (e == Edge::Right && dx > 0) ||
+                           (e == Edge::Top && dy < 0) ||
+                           (e == Edge::Bottom && dy > 0);
+            if (!outward) return;
+        }
+        if (t < best.t - 1e-9) {
+            best = {e, t, along};
+        } else if (std::abs(t - best.t) < 1e-9) {
+            bool horiz = (e == Edge::Left || e == Edge::Right);
+            if (horiz && std::abs(dx) >= std::abs(dy)) best = {e, t, along};
+            if (!horiz && std::abs(dy) > std::abs(dx)) best = {e, t, along};
+        }
+    };
+
+    // Right edge: x = rc.right
+    if (dx != 0.0) {
+        double t = (rc.right - p0.x) / dx;
+        double y = p0.y + t * dy;
+        if (y >= rc.top && y <= rc.bottom)
+            tryEdge(Edge::Right, t, y);
+    }
+    // Left edge: x = rc.left
+    if (dx != 0.0) {
+        double t = (rc.left - p0.x) / dx;
+        double y = p0.y + t * dy;
+        if (y >= rc.top && y <= rc.bottom)
+            tryEdge(Edge::Left, t, y);
+    }
+    // Bottom edge: y = rc.bottom
+    if (dy != 0.0) {
+        double t = (rc.bottom - p0.y) / dy;
+        double x = p0.x + t * dx;
+        if (x >= rc.left && x <= rc.right)
+            tryEdge(Edge::Bottom, t, x);
+    }
+    // Top edge: y = rc.top
+    if (dy != 0.0) {
+        double t = (rc.top - p0.y) / dy;
+        double x = p0.x + t * dx;
+        if (x >= rc.left && x <= rc.right)
+            tryEdge(Edge::Top, t, x);
+    }
+
+    return best;
+}
+
+// --- Percentage mapping with shared-edge overlap ---
+
+inline bool RemapCursor(const Rect& src, const Rect& dst, Edge edge, double hitCoord, Point& out) {
+    // Overlap: only used to verify monitors are adjacent
+    // Percentage is based on source full edge, mapped to destination full edge
+    long ovStart, ovEnd, srcStart, srcEnd, dstStart, dstEnd;
+
+    if (edge == Edge::Left || edge == Edge::Right) {
+        ovStart  = std::max(src.top, dst.top);
+        ovEnd    = std::min(src.bottom, dst.bottom);
+        srcStart = src.top;  srcEnd = src.bottom;
+        dstStart = dst.top;  dstEnd = dst.bottom;
+    } else {
+        ovStart  = std::max(src.left, dst.left);
+        ovEnd    = std::min(src.right, dst.right);
+        srcStart = src.left;  srcEnd = src.right;
+        dstStart = dst.left;  dstEnd = dst.right;
+    }
+
+    long srcLen = srcEnd - srcStart;
+    long dstLen = dstEnd - dstStart;
+    if (ovEnd - ovStart <= 0 || srcLen <= 0 || dstLen <= 0) return false;
+
+    // Percentage along source full edge
+    double pct = (hitCoord - srcStart) / static_cast<double>(srcLen);
+    pct = std::clamp(pct, 0.0, 1.0);
+
+    // Map to destination full edge, then round, then inset 1px
+    long mapped = dstStart + static_cast<long>(std::lround(pct * dstLen));
+    mapped = std::clamp(mapped, dstStart + 1, dstEnd - 2);
+
+    // Build output point
+    switch (edge) {
+    case Edge::Right:  out = {dst.left + 1, mapped};     break;
+    case Edge::Left:   out = {dst.right - 2, mapped};    break;
+    case Edge::Bottom: out = {mapped, dst.top + 1};      break;
+    case Edge::Top:    out = {mapped, dst.bottom - 2};   break;
+    default: return false;
+    }
+    return true;
+}
+
+// --- Whole crossing decision ---
+// What the mapper does when the cursor moves from a point on src to a point
+// on dst: exit edge from the segment, percentage from the previous point.
+// Pure, so other implementations can be checked against it (shadow.h).
+
+struct CrossingDecision {
+    HitResult hit;
+    bool      remapped;
+    Point     mapped;    // == to unless remapped
+};
+
+inline CrossingDecision MapCrossing(const Rect& src, const Rect& dst, Point from, Point to) {
+    CrossingDecision d{FindExitEdge(from, to, src), false, to};
+    if (d.hit.edge == Edge::None) return d;
+    // Use from's coordinate for percentage (to may be clipped by system)
+    double srcCoord = (d.hit.edge == Edge::Left || d.hit.edge == Edge::Right)
+        ? static_cast<double>(from.y)
+        : static_cast<double>(from.x);
+    Point mapped;
+    if (RemapCursor(src, dst, d.hit.edge, srcCoord, mapped) && mapped != to) {
+        d.remapped = true;
+        d.mapped   = mapped;
+    }
+    return d;
+}
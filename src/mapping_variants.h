@@ -0,0 +1,86 @@
+#pragma once
+
+// Optimised variants of the mapping primitives, staged here until the
+// differential harness (differential.h, cursor_mapper_diff, fuzz_mapping)
+// shows they match the reference on every input the mapper can produce.
+// Nothing in the mapper calls them yet.
+
+#include "mapping.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// --- Exit edge: only the edges the segment moves toward ---
+// p0 is inside rc whenever the mapper asks (it is the previous on-screen
+// position on the source monitor), so an edge behind the motion can only
+// produce t <= 0 and is rejected by FindExitEdge anyway. Testing at most
+// one vertical and one horizontal edge halves the divisions.
+
+inline HitResult FindExitEdgeDirectional(Point p0, Point p1, const Rect& rc) {
+    double dx = static_cast<double>(p1.x) - p0.x;
+    double dy = static_cast<double>(p1.y) - p0.y;
+
+    HitResult best{Edge::None, 2.0, 0.0};
+
+    // Same acceptance and tie-break as FindExitEdge, and the same order
+    // (left / right before top / bottom), which the tie-break depends on
+    auto tryEdge = [&](Edge e, double t, double along) {
+        if (t < -1e-9 || t > 1.0) return;
+        if (t < 1e-9) {
+            bool outward = (e == Edge::Left && dx < 0) ||
+                           (e == Edge::Right && dx > 0) ||
+                           (e == Edge::Top && dy < 0) ||
+                           (e == Edge::Bottom && dy > 0);
+            if (!outward) return;
+        }
+        if (t < best.t - 1e-9) {
+            best = {e, t, along};
+        } else if (std::abs(t - best.t) < 1e-9) {
+            bool horiz = (e == Edge::Left || e == Edge::Right);
+            if (horiz && std::abs(dx) >= std::abs(dy)) best = {e, t, along};
+            if (!horiz && std::abs(dy) > std::abs(dx)) best = {e, t, along};
+        }
+    };
+
+    if (dx > 0.0) {
+        double t = (rc.right - p0.x) / dx;
+        double y = p0.y + t * dy;
+        if (y >= rc.top && y <= rc.bottom) tryEdge(Edge::Right, t, y);
+    } else if (dx < 0.0) {
+        double t = (rc.left - p0.x) / dx;
+        double y = p0.y + t * dy;
+        if (y >= rc.top && y <= rc.bottom) tryEdge(Edge::Left, t, y);
+    }
+    if (dy > 0.0) {
+        double t = (rc.bottom - p0.y) / dy;
+        double x = p0.x + t * dx;
+        if (x >= rc.left && x <= rc.right) tryEdge(Edge::Bottom, t, x);
+    } else if (dy < 0.0) {
+        double t = (rc.top - p0.y) / dy;
+        double x = p0.x + t * dx;
+        if (x >= rc.left && x <= rc.right) tryEdge(Edge::Top, t, x);
+    }
+    return best;
+}
+
+// --- Monitor lookup: containment mask, no early exit ---
+// Every rect is tested (a loop the compiler can vectorise) and the lowest
+// set bit is the first match, as in MonitorIndexFromPoint. Up to 64
+// monitors; beyond that falls back to the scan.
+
+inline int MonitorIndexFromPointMask(const Rect* mons, size_t count, Point p) {
+    if (count > 64) return MonitorIndexFromPoint(mons, count, p);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        bool in = (p.x >= mons[i].left) & (p.x < mons[i].right) & (p.y >= mons[i].top) & (p.y < mons[i].bottom);
+        mask |= static_cast<uint64_t>(in) << i;
+    }
+    if (!mask) return -1;
+    int index = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+// Operational counters and latency histograms.
+//
+// Each thread writes only its own cache-line-aligned ThreadMetrics block, so
+// counting is a relaxed load + store with no lock prefix and no sharing.
+// Updates belonging to one event are bracketed by a per-block seqlock;
+// readers (the exporter thread, or another process through the shared
+// stats region) retry until they copy a block between two updates and
+// never make the owner wait.
+
+#include "filter_chain.h"
+#include "spsc_queue.h"  // CACHE_LINE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+inline uint64_t MetricsNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// --- Single-writer counter ---
+
+struct Counter {
+    std::atomic<uint64_t> v{0};
+
+    void Add(uint64_t n = 1) { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t Load() const { return v.load(std::memory_order_relaxed); }
+};
+
+// --- Latency histogram: bucket i holds samples <= 250 ns * 2^i ---
+
+static constexpr size_t   LATENCY_BUCKETS   = 14;  // 250 ns .. ~2 ms, then +Inf
+static constexpr uint64_t LATENCY_FIRST_NS  = 250;
+
+struct LatencyHistogram {
+    Counter buckets[LATENCY_BUCKETS + 1];  // last one is +Inf
+    Counter sumNs;
+    Counter count;
+
+    static size_t BucketFor(uint64_t ns) {
+        uint64_t bound = LATENCY_FIRST_NS;
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i, bound <<= 1)
+            if (ns <= bound) return i;
+        return LATENCY_BUCKETS;
+    }
+
+    void Record(uint64_t ns) {
+        buckets[BucketFor(ns)].Add();
+        sumNs.Add(ns);
+        count.Add();
+    }
+};
+
+// Records the enclosing scope's duration.
+struct LatencyScope {
+    LatencyHistogram* hist;
+    uint64_t          t0;
+
+    explicit LatencyScope(LatencyHistogram* h) : hist(h), t0(h ? MetricsNowNs() : 0) {}
+    ~LatencyScope() { if (hist) hist->Record(MetricsNowNs() - t0); }
+};
+
+// --- Per-thread block ---
+
+static constexpr size_t METRICS_MAX_MONITORS = 8;  // portal matrix is N x N
+
+struct alignas(CACHE_LINE) ThreadMetrics {
+    std::atomic<uint32_t> seq{0};  // odd while the owner is mid-update
+
+    // Mapping thread
+    Counter events;        // motion events entering the mapper
+    Counter fastPath;      // stayed on the same monitor, no crossing work
+    Counter offscreen;     // outside every monitor
+    Counter crossings;     // monitor changes
+    Counter remaps;        // remapped positions applied
+    Counter warpFailures;  // SetCursorPos / warp calls that failed
+    Counter echoes;        // own warp echoes consumed
+    Counter portal[METRICS_MAX_MONITORS][METRICS_MAX_MONITORS];  // [src][dst]
+    LatencyHistogram mapLatency;
+
+    // Topology thread
+    Counter refreshes;      // enumerations run
+    Counter signatureHits;  // enumerations matching the current signature
+    Counter publishes;      // snapshots published
+
+    // Shadow evaluation (shadow.h); dropped is counted by the mapping thread
+    Counter shadowEvaluated;     // crossings re-run with the candidate
+    Counter shadowDropped;       // crossings the full shadow queue turned away
+    Counter shadowEdgeDiffs;     // candidate picked another exit edge
+    Counter shadowRemapDiffs;    // same edge, one remapped and the other did not
+    Counter shadowPositionDiffs; // both remapped, to different points
+    Counter shadowTimedCalls;    // calls timed per implementation
+    Counter shadowLiveNs;        // time spent in those calls, live
+    Counter shadowCandidateNs;   // ... and candidate
+
+    // Classify one mapped sample by the flags EdgeRemapStage left on it.
+    void CountSample(const MotionSample& s) {
+        events.Add();
+        if (s.flags & MOTION_OFFSCREEN) offscreen.Add();
+        else if (s.flags & MOTION_CROSSING) crossings.Add();
+        else fastPath.Add();
+    }
+
+    void CountPortal(int src, int dst) {
+        if (src >= 0 && dst >= 0 && static_cast<size_t>(src) < METRICS_MAX_MONITORS &&
+            static_cast<size_t>(dst) < METRICS_MAX_MONITORS)
+            portal[src][dst].Add();
+    }
+
+    void BeginUpdate() {
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void EndUpdate() { seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Adds every counter into dst. Not consistent on its own while the owner
+    // is running; see SnapshotInto.
+    void AddTo(ThreadMetrics& dst) const;
+
+    // Adds a consistent copy into dst. Returns false if the owner was
+    // mid-update on every attempt (e.g. it died holding the seqlock).
+    bool SnapshotInto(ThreadMetrics& dst, int attempts = 1024) const {
+        SpinWait wait;
+        for (int i = 0; i < attempts; ++i) {
+            uint32_t before = seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                wait();
+                continue;
+            }
+            ThreadMetrics copy;
+            AddTo(copy);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) {
+                copy.AddTo(dst);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+inline void ThreadMetrics::AddTo(ThreadMetrics& dst) const {
+    auto add = [](Counter& d, const Counter& s) { d.Add(s.Load()); };
+    add(dst.events, events);
+    add(dst.fastPath, fastPath);
+    add(dst.offscreen, offscreen);
+    add(dst.crossings, crossings);
+    add(dst.remaps, remaps);
+    add(dst.warpFailures, warpFailures);
+    add(dst.echoes, echoes);
+    for (size_t s = 0; s < METRICS_MAX_MONITORS; ++s)
+        for (size_t d = 0; d < METRICS_MAX_MONITORS; ++d) add(dst.portal[s][d], portal[s][d]);
+    for (size_t i = 0; i <= LATENCY_BUCKETS; ++i) add(dst.mapLatency.buckets[i], mapLatency.buckets[i]);
+    add(dst.mapLatency.sumNs, mapLatency.sumNs);
+    add(dst.mapLatency.count, mapLatency.count);
+    add(dst.refreshes, refreshes);
+    add(dst.signatureHits, signatureHits);
+    add(dst.publishes, publishes);
+    add(dst.shadowEvaluated, shadowEvaluated);
+    add(dst.shadowDropped, shadowDropped);
+    add(dst.shadowEdgeDiffs, shadowEdgeDiffs);
+    add(dst.shadowRemapDiffs, shadowRemapDiffs);
+    add(dst.shadowPositionDiffs, shadowPositionDiffs);
+    add(dst.shadowTimedCalls, shadowTimedCalls);
+    add(dst.shadowLiveNs, shadowLiveNs);
+    add(dst.shadowCandidateNs, shadowCandidateNs);
+}
+
+// Brackets the counter updates for one event; null-safe like LatencyScope.
+// Declare it before any LatencyScope so the latency lands inside the update.
+struct MetricsUpdate {
+    ThreadMetrics* m;
+
+    explicit MetricsUpdate(ThreadMetrics* block) : m(block) { if (m) m->BeginUpdate(); }
+    ~MetricsUpdate() { if (m) m->EndUpdate(); }
+    MetricsUpdate(const MetricsUpdate&) = delete;
+    MetricsUpdate& operator=(const MetricsUpdate&) = delete;
+};
+
+inline std::string RenderPrometheus(const ThreadMetrics& total);
+
+// --- Registry ---
+// Blocks live for as long as the registry, so readers can snapshot them
+// without coordinating with their owners. By default the registry owns them;
+// UseStorage() places them in caller memory instead (the shared stats
+// region), and must be called before the first Register().
+
+class MetricsRegistry {
+public:
+    static constexpr size_t MAX_THREADS = 16;
+
+    MetricsRegistry() : owned_(new ThreadMetrics[MAX_THREADS]), slots_(owned_.get()) {}
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    void UseStorage(ThreadMetrics* slots, size_t count) {
+        owned_.reset();
+        slots_    = slots;
+        capacity_ = count < MAX_THREADS ? count : MAX_THREADS;
+    }
+
+    // Returns nullptr when all slots are taken.
+    ThreadMetrics* Register() {
+        size_t slot = count_.fetch_add(1, std::memory_order_acq_rel);
+        if (slot >= capacity_) return nullptr;
+        return &slots_[slot];
+    }
+
+    // Sums consistent snapshots of the registered blocks into total; returns
+    // how many could not be read consistently. Those are added as they are
+    // rather than left out, so a block busy on every attempt never makes
+    // its counters read as zero (each one is still monotonic).
+    size_t Total(ThreadMetrics& total) const {
+        size_t registered = count_.load(std::memory_order_acquire);
+        if (registered > capacity_) registered = capacity_;
+        size_t torn = 0;
+        for (size_t i = 0; i < registered; ++i) {
+            if (slots_[i].SnapshotInto(total)) continue;
+            slots_[i].AddTo(total);
+            ++torn;
+        }
+        return torn;
+    }
+
+    std::string RenderPrometheus() const {
+        ThreadMetrics total;
+        Total(total);
+        return ::RenderPrometheus(total);
+    }
+
+private:
+    std::unique_ptr<ThreadMetrics[]> owned_;
+    ThreadMetrics*                   slots_    = nullptr;
+    size_t                           capacity_ = MAX_THREADS;
+    std::atomic<size_t>              count_{0};
+};
+
+inline std::string RenderPrometheus(const ThreadMetrics& total) {
+    std::string out;
+    char line[256];
+    auto counter = [&](const char* name, const char* help, Counter ThreadMetrics::*field) {
+        snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                 name, help, name, name, static_cast<unsigned long long>((total.*field).Load()));
+        out += line;
+    };
+
+    counter("cursor_mapper_events_total", "Motion events seen by the mapper.", &ThreadMetrics::events);
+    counter("cursor_mapper_fast_path_total", "Events that stayed on the same monitor.", &ThreadMetrics::fastPath);
+    counter("cursor_mapper_offscreen_total", "Events outside every monitor.", &ThreadMetrics::offscreen);
+    counter("cursor_mapper_crossings_total", "Monitor crossings detected.", &ThreadMetrics::crossings);
+    counter("cursor_mapper_remaps_total", "Remapped cursor positions applied.", &ThreadMetrics::remaps);
+    counter("cursor_mapper_warp_failures_total", "Cursor warps the OS rejected.", &ThreadMetrics::warpFailures);
+    counter("cursor_mapper_echoes_total", "Echoes of own warps suppressed.", &ThreadMetrics::echoes);
+    counter("cursor_mapper_topology_refreshes_total", "Monitor enumerations run.", &ThreadMetrics::refreshes);
+    counter("cursor_mapper_topology_signature_hits_total", "Enumerations matching the current signature.", &ThreadMetrics::signatureHits);
+    counter("cursor_mapper_topology_publishes_total", "Topology snapshots published.", &ThreadMetrics::publishes);
+
+    counter("cursor_mapper_shadow_evaluated_total", "Crossings re-run by the shadow candidate.", &ThreadMetrics::shadowEvaluated);
+    counter("cursor_mapper_shadow_dropped_total", "Crossings dropped because the shadow queue was full.", &ThreadMetrics::shadowDropped);
+    counter("cursor_mapper_shadow_timed_calls_total", "Mapping calls timed per shadow implementation.", &ThreadMetrics::shadowTimedCalls);
+
+    if (total.shadowEvaluated.Load()) {
+        out += "# HELP cursor_mapper_shadow_divergences_total Shadow candidate answers that differ from the live one.\n"
+               "# TYPE cursor_mapper_shadow_divergences_total counter\n";
+        snprintf(line, sizeof(line), "cursor_mapper_shadow_divergences_total{kind=\"edge\"} %llu\n"
+                 "cursor_mapper_shadow_divergences_total{kind=\"remap\"} %llu\n"
+                 "cursor_mapper_shadow_divergences_total{kind=\"position\"} %llu\n",
+                 static_cast<unsigned long long>(total.shadowEdgeDiffs.Load()),
+                 static_cast<unsigned long long>(total.shadowRemapDiffs.Load()),
+                 static_cast<unsigned long long>(total.shadowPositionDiffs.Load()));
+        out += line;
+        out += "# HELP cursor_mapper_shadow_mapping_seconds_total Time spent in timed shadow calls.\n"
+               "# TYPE cursor_mapper_shadow_mapping_seconds_total counter\n";
+        snprintf(line, sizeof(line), "cursor_mapper_shadow_mapping_seconds_total{impl=\"live\"} %.9f\n"
+                 "cursor_mapper_shadow_mapping_seconds_total{impl=\"candidate\"} %.9f\n",
+                 static_cast<double>(total.shadowLiveNs.Load()) / 1e9,
+                 static_cast<double>(total.shadowCandidateNs.Load()) / 1e9);
+        out += line;
+    }
+
+    out += "# HELP cursor_mapper_portal_crossings_total Crossings per source/destination monitor.\n"
+           "# TYPE cursor_mapper_portal_crossings_total counter\n";
+    for (size_t s = 0; s < METRICS_MAX_MONITORS; ++s) {
+        for (size_t d = 0; d < METRICS_MAX_MONITORS; ++d) {
+            uint64_t n = total.portal[s][d].Load();
+            if (!n) continue;
+            snprintf(line, sizeof(line), "cursor_mapper_portal_crossings_total{src=\"%zu\",dst=\"%zu\"} %llu\n",
+                     s, d, static_cast<unsigned long long>(n));
+            out += line;
+        }
+    }
+
+    out += "# HELP cursor_mapper_map_latency_seconds Time spent mapping one event.\n"
+           "# TYPE cursor_mapper_map_latency_seconds histogram\n";
+    uint64_t cumulative = 0, bound = LATENCY_FIRST_NS;
+    for (size_t i = 0; i <= LATENCY_BUCKETS; ++i, bound <<= 1) {
+        cumulative += total.mapLatency.buckets[i].Load();
+        if (i < LATENCY_BUCKETS)
+            snprintf(line, sizeof(line), "cursor_mapper_map_latency_seconds_bucket{le=\"%g\"} %llu\n",
+                     static_cast<double>(bound) / 1e9, static_cast<unsigned long long>(cumulative));
+        else
+            snprintf(line, sizeof(line), "cursor_mapper_map_latency_seconds_bucket{le=\"+Inf\"} %llu\n",
+                     static_cast<unsigned long long>(cumulative));
+        out += line;
+    }
+    uint64_t sumNs = total.mapLatency.sumNs.Load(), count = total.mapLatency.count.Load();
+    snprintf(line, sizeof(line), "cursor_mapper_map_latency_seconds_sum %.9f\n"
+             "cursor_mapper_map_latency_seconds_count %llu\n",
+             static_cast<double>(sumNs) / 1e9, static_cast<unsigned long long>(count));
+    out += line;
+    return out;
+}
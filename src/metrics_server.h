@@ -0,0 +1,174 @@
+#pragma once
+
+// Serves a text body (the Prometheus exposition) to local clients on a
+// dedicated thread: a named pipe on Windows, a Unix-domain socket elsewhere.
+// Each connection gets one freshly rendered body and is closed; nothing on
+// the mapping thread ever waits for a scraper.
+//
+//   Windows: type \\.\pipe\cursor_mapper_metrics  (or any pipe client)
+//   Linux:   socat - UNIX-CONNECT:/run/user/$UID/cursor_mapper.metrics
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+class MetricsServer {
+public:
+    using RenderFn = std::function<std::string()>;
+
+    MetricsServer() = default;
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+    ~MetricsServer() {
+        Stop();
+#if defined(_WIN32)
+        if (security_) LocalFree(security_);
+#endif
+    }
+
+    // Returns false when the endpoint cannot be created.
+    bool Start(const std::string& endpoint, RenderFn render) {
+        endpoint_ = endpoint;
+        render_   = std::move(render);
+        stop_     = false;
+#if defined(_WIN32)
+        // The pipe is readable by the current user only, as the 0600 socket
+        // below; the default DACL would also admit other local accounts
+        if (!security_ && !BuildOwnerOnlySecurity()) return false;
+#else
+        sockaddr_un addr{};
+        if (endpoint.size() >= sizeof(addr.sun_path)) return false;
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd_ < 0) return false;
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, endpoint.c_str(), endpoint.size() + 1);
+        unlink(endpoint.c_str());
+        // The socket file is created 0600: no window in which other users
+        // can connect before a chmod
+        mode_t oldMask = umask(077);
+        int bound = bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        umask(oldMask);
+        if (bound != 0 || listen(listenFd_, 8) != 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+#endif
+        thread_ = std::thread([this] { Serve(); });
+        return true;
+    }
+
+    void Stop() {
+        if (!thread_.joinable()) return;
+        stop_ = true;
+#if defined(_WIN32)
+        // Connect once so a blocked ConnectNamedPipe returns.
+        HANDLE h = CreateFileA(endpoint_.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+#else
+        shutdown(listenFd_, SHUT_RDWR);  // wakes accept()
+#endif
+        thread_.join();
+#if !defined(_WIN32)
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(endpoint_.c_str());
+#endif
+    }
+
+    uint64_t Scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+private:
+#if defined(_WIN32)
+    void Serve() {
+        SECURITY_ATTRIBUTES attrs{sizeof(attrs), security_, FALSE};
+        while (!stop_) {
+            HANDLE pipe = CreateNamedPipeA(endpoint_.c_str(), PIPE_ACCESS_OUTBOUND,
+                                           PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                           1, 64 * 1024, 0, 0, &attrs);
+            if (pipe == INVALID_HANDLE_VALUE) return;
+            BOOL connected = ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+            if (connected && !stop_) {
+                std::string body = render_();
+                DWORD written = 0;
+                WriteFile(pipe, body.data(), static_cast<DWORD>(body.size()), &written, nullptr);
+                FlushFileBuffers(pipe);
+                scrapes_.fetch_add(1, std::memory_order_relaxed);
+            }
+            DisconnectNamedPipe(pipe);
+            CloseHandle(pipe);
+        }
+    }
+
+    // Protected DACL with a single ACE: full access for the token's user.
+    bool BuildOwnerOnlySecurity() {
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return false;
+        alignas(TOKEN_USER) unsigned char buf[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+        DWORD len = 0;
+        BOOL got = GetTokenInformation(token, TokenUser, buf, sizeof(buf), &len);
+        CloseHandle(token);
+        char* sid = nullptr;
+        if (!got || !ConvertSidToStringSidA(reinterpret_cast<TOKEN_USER*>(buf)->User.Sid, &sid)) return false;
+        std::string sddl = std::string("D:P(A;;GA;;;") + sid + ")";
+        LocalFree(sid);
+        return ConvertStringSecurityDescriptorToSecurityDescriptorA(sddl.c_str(), SDDL_REVISION_1, &security_,
+                                                                    nullptr) != 0;
+    }
+
+    PSECURITY_DESCRIPTOR security_ = nullptr;  // LocalAlloc'd; kept for every pipe instance
+#else
+    void Serve() {
+        while (!stop_) {
+            int fd = accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                if (stop_) return;
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                // Out of descriptors or memory: the pending connection stays
+                // queued, so back off instead of spinning on it
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_BACKOFF_MS));
+                    continue;
+                }
+                return;
+            }
+            std::string body = render_();
+            const char* p = body.data();
+            size_t left = body.size();
+            while (left) {
+                ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+                if (n <= 0) break;
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+            close(fd);
+            scrapes_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr int ACCEPT_BACKOFF_MS = 100;
+
+    int listenFd_ = -1;
+#endif
+
+    std::string           endpoint_;
+    RenderFn              render_;
+    std::atomic<bool>     stop_{false};
+    std::atomic<uint64_t> scrapes_{0};
+    std::thread           thread_;
+};
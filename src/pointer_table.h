@@ -0,0 +1,141 @@
+#pragma once
+
+// Mapping state for several cursors on one layout (X11 MPX master pointers,
+// collaborative-display rooms). Each pointer keeps its own previous monitor
+// and position in a small table indexed by device ID; MultiPointerRemap
+// runs interleaved events from all of them through one EdgeRemapStage,
+// swapping the owning pointer's state in for each run of its events. One
+// mapping thread owns everything here, so there are no locks and one
+// pointer's motion never decides another's crossing.
+
+#include "filter_chain.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct PointerState {
+    int   lastMonitor = -1;
+    Point lastPos{0, 0};
+};
+
+// Device ID -> slot through a direct-indexed byte table; slots stay packed
+// (removal moves the last slot into the hole), so iterating live pointers
+// touches only Size() entries.
+class PointerTable {
+public:
+    static constexpr size_t   MAX_POINTERS  = 32;
+    static constexpr uint32_t MAX_DEVICE_ID = 256;  // exclusive; XI2 ids are small
+    static constexpr uint8_t  NO_SLOT       = 0xFF;
+
+    PointerTable() { slotOf_.fill(NO_SLOT); }
+
+    PointerState* Find(uint32_t device) {
+        if (device >= MAX_DEVICE_ID || slotOf_[device] == NO_SLOT) return nullptr;
+        return &states_[slotOf_[device]];
+    }
+
+    // Existing state, or a fresh one on the first event of a pointer;
+    // nullptr when the ID is out of range or the table is full.
+    PointerState* Acquire(uint32_t device) {
+        if (device >= MAX_DEVICE_ID) return nullptr;
+        uint8_t slot = slotOf_[device];
+        if (slot != NO_SLOT) return &states_[slot];
+        if (size_ == MAX_POINTERS) return nullptr;
+        slot            = static_cast<uint8_t>(size_++);
+        slotOf_[device] = slot;
+        deviceOf_[slot] = static_cast<uint16_t>(device);
+        states_[slot]   = {};
+        return &states_[slot];
+    }
+
+    // A master pointer went away.
+    void Remove(uint32_t device) {
+        if (device >= MAX_DEVICE_ID || slotOf_[device] == NO_SLOT) return;
+        uint8_t slot = slotOf_[device];
+        size_t last  = --size_;
+        if (slot != last) {
+            states_[slot]            = states_[last];
+            deviceOf_[slot]          = deviceOf_[last];
+            slotOf_[deviceOf_[slot]] = slot;
+        }
+        slotOf_[device] = NO_SLOT;
+    }
+
+    // Layout changed: every pointer's previous monitor index is stale.
+    void ForgetMonitors() {
+        for (size_t i = 0; i < size_; ++i) states_[i].lastMonitor = -1;
+    }
+
+    size_t Size() const { return size_; }
+
+private:
+    std::array<uint8_t, MAX_DEVICE_ID>     slotOf_;
+    std::array<PointerState, MAX_POINTERS> states_;
+    std::array<uint16_t, MAX_POINTERS>     deviceOf_{};
+    size_t                                 size_ = 0;
+};
+
+class MultiPointerRemap {
+public:
+    // Monitors and the crossing callback live on the shared stage; its own
+    // lastMonitor / lastPos are scratch.
+    EdgeRemapStage& Stage() { return remap_; }
+
+    void SetMonitors(std::vector<Rect> mons) {
+        remap_.SetMonitors(std::move(mons));
+        pointers_.ForgetMonitors();
+    }
+
+    void RemovePointer(uint32_t device) { pointers_.Remove(device); }
+
+    // Pointer whose events are being mapped; valid inside onCrossing.
+    uint32_t CurrentDevice() const { return current_; }
+
+    // Maps s[0..n) in order; devices[i] produced s[i]. Samples of pointers
+    // the table cannot hold pass through unmapped and are counted.
+    void Process(MotionSample* s, const uint16_t* devices, size_t n) {
+        size_t i = 0;
+        while (i < n) {
+            uint16_t device = devices[i];
+            size_t end = i + 1;
+            while (end < n && devices[end] == device) ++end;
+
+            PointerState* st = pointers_.Acquire(device);
+            if (!st) {
+                untracked += end - i;
+                i = end;
+                continue;
+            }
+            current_           = device;
+            remap_.lastMonitor = st->lastMonitor;
+            remap_.lastPos     = st->lastPos;
+            remap_.Process(s + i, end - i);
+            st->lastMonitor = remap_.lastMonitor;
+            st->lastPos     = remap_.lastPos;
+            i = end;
+        }
+    }
+
+    // Re-anchor one pointer, e.g. when its warp failed.
+    void Resync(uint32_t device, Point p) {
+        PointerState* st = pointers_.Find(device);
+        if (!st) return;
+        remap_.lastMonitor = st->lastMonitor;
+        remap_.lastPos     = st->lastPos;
+        remap_.Resync(p);
+        st->lastMonitor = remap_.lastMonitor;
+        st->lastPos     = remap_.lastPos;
+    }
+
+    size_t PointerCount() const { return pointers_.Size(); }
+
+    uint64_t untracked = 0;  // samples from pointers beyond the table
+
+private:
+    EdgeRemapStage remap_;
+    PointerTable   pointers_;
+    uint32_t       current_ = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+// USDT static probes (provider "cursor_mapper") for bpftrace / perf on
+// Linux. Each probe is a single nop plus an ELF note describing where its
+// arguments live; nothing runs unless a tracer attaches. Without
+// <sys/sdt.h> (Windows, or a host lacking systemtap-sdt-dev), or with
+// CURSOR_MAPPER_NO_PROBES, every probe expands to nothing.
+//
+// Arguments are integers only: bpftrace cannot read floating-point probe
+// arguments, so fractions are passed in parts per million.
+//
+//   event_entry(x, y, time)          sample enters edge remapping
+//   offscreen(x, y)                  sample outside every monitor
+//   fast_path(monitor)               stayed on the same monitor
+//   crossing(src, dst, edge, t_ppm)  monitor change; edge is Edge, t in ppm
+//   remap(src, dst, x, y, remapped)  position leaving the crossing
+//   warp(x, y, ok)                   cursor warp issued by the backend
+//   echo(x, y)                       own warp echo suppressed
+//   topology_published(version, monitors)
+
+#if !defined(CURSOR_MAPPER_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CURSOR_MAPPER_HAVE_PROBES 1
+#endif
+#endif
+
+#if defined(CURSOR_MAPPER_HAVE_PROBES)
+#define CURSOR_MAPPER_PROBE1(name, a)             DTRACE_PROBE1(cursor_mapper, name, a)
+#define CURSOR_MAPPER_PROBE2(name, a, b)          DTRACE_PROBE2(cursor_mapper, name, a, b)
+#define CURSOR_MAPPER_PROBE3(name, a, b, c)       DTRACE_PROBE3(cursor_mapper, name, a, b, c)
+#define CURSOR_MAPPER_PROBE4(name, a, b, c, d)    DTRACE_PROBE4(cursor_mapper, name, a, b, c, d)
+#define CURSOR_MAPPER_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(cursor_mapper, name, a, b, c, d, e)
+#else
+#define CURSOR_MAPPER_PROBE1(name, a)             ((void)0)
+#define CURSOR_MAPPER_PROBE2(name, a, b)          ((void)0)
+#define CURSOR_MAPPER_PROBE3(name, a, b, c)       ((void)0)
+#define CURSOR_MAPPER_PROBE4(name, a, b, c, d)    ((void)0)
+#define CURSOR_MAPPER_PROBE5(name, a, b, c, d, e) ((void)0)
+#endif
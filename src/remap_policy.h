@@ -0,0 +1,279 @@
+#pragma once
+
+// Per-portal remap strategies. RemapCursor maps the percentage along the
+// full source edge onto the full destination edge; a layout can instead
+// choose, portal by portal, one of the policies below. Each policy is a
+// type with a Build step (run once per portal at topology refresh, storing
+// everything it needs in a PortalTransform) and a Map step (run on the
+// crossing). PolicyTopology looks the portal up in a flat pair table and
+// dispatches on its strategy through a fold over the policy types, with no
+// virtual calls.
+
+#include "mapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum class RemapStrategy : uint8_t {
+    Percent,      // full source edge -> full destination edge (RemapCursor)
+    PassThrough,  // keep where the OS put the cursor (no remap)
+    Physical,     // same physical distance (mm) from the overlap centre
+    Offset,       // identity across the overlap, the rest of each edge scaled
+    Clamped,      // percentage, but never more than maxJump px from the OS position
+};
+
+inline const char* RemapStrategyName(RemapStrategy s) {
+    switch (s) {
+    case RemapStrategy::Percent:     return "percent";
+    case RemapStrategy::PassThrough: return "pass-through";
+    case RemapStrategy::Physical:    return "physical";
+    case RemapStrategy::Offset:      return "offset";
+    case RemapStrategy::Clamped:     return "clamped";
+    default:                         return "?";
+    }
+}
+
+inline bool ParseRemapStrategy(const char* s, RemapStrategy& out) {
+    for (RemapStrategy c : {RemapStrategy::Percent, RemapStrategy::PassThrough, RemapStrategy::Physical,
+                            RemapStrategy::Offset, RemapStrategy::Clamped}) {
+        if (strcmp(s, RemapStrategyName(c)) == 0) {
+            out = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Which strategy each monitor pair uses: `fallback` unless a src -> dst
+// override names the pair (monitor indices in published order). It covers
+// crossings through the pair's portal and crossings between the two
+// monitors that no portal connects.
+struct PortalStrategyConfig {
+    struct Override {
+        int           src, dst;
+        RemapStrategy strategy;
+    };
+
+    RemapStrategy         fallback = RemapStrategy::Percent;
+    std::vector<Override> overrides;
+    long                  maxJump = 240;  // px, Clamped
+
+    RemapStrategy For(int src, int dst) const {
+        for (const Override& o : overrides)
+            if (o.src == src && o.dst == dst) return o.strategy;
+        return fallback;
+    }
+};
+
+// Everything a crossing through one portal needs, resolved at refresh.
+// Along-edge coordinates are y for left / right portals, x otherwise.
+struct PortalTransform {
+    Edge          edge;
+    RemapStrategy strategy;
+    long          across;             // entry coordinate across the edge (1 px inside dst)
+    long          srcStart, srcLen;   // full source edge
+    long          dstStart, dstLen;   // full destination edge
+    long          ovStart, ovEnd;     // shared stretch
+    long          maxJump;
+    double        scaleLo, scaleHi;   // Offset: outside the overlap; Physical: scaleLo
+    double        anchor;             // Physical: overlap centre
+};
+
+// Destination point for an along-edge coordinate, 1 px inside the edges as
+// RemapCursor does.
+inline Point PortalEntry(const PortalTransform& t, long along) {
+    along = std::clamp(along, t.dstStart + 1, t.dstStart + t.dstLen - 2);
+    return t.edge == Edge::Left || t.edge == Edge::Right ? Point{t.across, along} : Point{along, t.across};
+}
+
+// --- Policies ---
+// static void Build(PortalTransform&, double srcMmPerPx, double dstMmPerPx)
+// static bool Map(const PortalTransform&, long coord, Point& out)
+// Map gets the along-edge coordinate of the last point on src and returns
+// false to leave the cursor where the OS put it.
+
+struct PercentPolicy {
+    static constexpr RemapStrategy ID = RemapStrategy::Percent;
+
+    static void Build(PortalTransform&, double, double) {}
+
+    // Same arithmetic as RemapCursor, so results agree bit for bit
+    static long Along(const PortalTransform& t, long coord) {
+        double pct = std::clamp((static_cast<double>(coord) - t.srcStart) / static_cast<double>(t.srcLen), 0.0, 1.0);
+        return t.dstStart + static_cast<long>(std::lround(pct * t.dstLen));
+    }
+
+    static bool Map(const PortalTransform& t, long coord, Point& out) {
+        out = PortalEntry(t, Along(t, coord));
+        return true;
+    }
+};
+
+struct PassThroughPolicy {
+    static constexpr RemapStrategy ID = RemapStrategy::PassThrough;
+
+    static void Build(PortalTransform&, double, double) {}
+    static bool Map(const PortalTransform&, long, Point&) { return false; }
+};
+
+struct PhysicalPolicy {
+    static constexpr RemapStrategy ID = RemapStrategy::Physical;
+
+    // Unknown sizes (0) count as equal pixel pitch
+    static void Build(PortalTransform& t, double srcMmPerPx, double dstMmPerPx) {
+        t.scaleLo = srcMmPerPx > 0.0 && dstMmPerPx > 0.0 ? srcMmPerPx / dstMmPerPx : 1.0;
+        t.anchor  = 0.5 * static_cast<double>(t.ovStart + t.ovEnd);
+    }
+
+    static bool Map(const PortalTransform& t, long coord, Point& out) {
+        out = PortalEntry(t, std::lround(t.anchor + (static_cast<double>(coord) - t.anchor) * t.scaleLo));
+        return true;
+    }
+};
+
+struct OffsetPolicy {
+    static constexpr RemapStrategy ID = RemapStrategy::Offset;
+
+    // Source edge beyond each end of the overlap onto the destination edge
+    // beyond the same end; an end with nothing beyond it on src maps nothing
+    static void Build(PortalTransform& t, double, double) {
+        long srcLo = t.ovStart - t.srcStart, srcHi = t.srcStart + t.srcLen - t.ovEnd;
+        long dstLo = t.ovStart - t.dstStart, dstHi = t.dstStart + t.dstLen - t.ovEnd;
+        t.scaleLo = srcLo > 0 ? static_cast<double>(dstLo) / srcLo : 0.0;
+        t.scaleHi = srcHi > 0 ? static_cast<double>(dstHi) / srcHi : 0.0;
+    }
+
+    static bool Map(const PortalTransform& t, long coord, Point& out) {
+        long along = coord;
+        if (coord < t.ovStart)
+            along = t.ovStart - std::lround(static_cast<double>(t.ovStart - coord) * t.scaleLo);
+        else if (coord >= t.ovEnd)
+            along = t.ovEnd + std::lround(static_cast<double>(coord - t.ovEnd) * t.scaleHi);
+        out = PortalEntry(t, along);
+        return true;
+    }
+};
+
+struct ClampedPolicy {
+    static constexpr RemapStrategy ID = RemapStrategy::Clamped;
+
+    static void Build(PortalTransform&, double, double) {}
+
+    static bool Map(const PortalTransform& t, long coord, Point& out) {
+        long along = std::clamp(PercentPolicy::Along(t, coord), coord - t.maxJump, coord + t.maxJump);
+        out = PortalEntry(t, along);
+        return true;
+    }
+};
+
+// --- Dispatch ---
+
+template <typename... Policies>
+struct PolicySet {
+    static bool Build(PortalTransform& t, double srcMmPerPx, double dstMmPerPx) {
+        return ((t.strategy == Policies::ID && (Policies::Build(t, srcMmPerPx, dstMmPerPx), true)) || ...);
+    }
+
+    static bool Map(const PortalTransform& t, long coord, Point& out) {
+        bool remap = false;
+        (void)((t.strategy == Policies::ID && (remap = Policies::Map(t, coord, out), true)) || ...);
+        return remap;
+    }
+};
+
+using DefaultPolicySet = PolicySet<PercentPolicy, PassThroughPolicy, PhysicalPolicy, OffsetPolicy, ClampedPolicy>;
+
+// Transforms of every portal of a layout plus src * count + dst -> portal
+// and -> strategy lookups (the latter for crossings without a portal).
+// When every pair maps by percentage the plain rect list gives the same
+// answers, so callers skip the table (Custom() is false).
+struct PortalPolicyTable {
+    size_t                       count = 0;  // monitors
+    std::vector<int32_t>         pairPortal;    // -1: no portal
+    std::vector<RemapStrategy>   pairStrategy;  // every pair, portal or not
+    std::vector<PortalTransform> transforms;
+    std::vector<double>          mmPerPx;       // per monitor, for Physical without a portal
+    long                         maxJump = 0;
+    bool                         custom  = false;  // some pair is not Percent
+
+    bool Custom() const { return custom; }
+};
+
+// Shared stretch of src and dst across `edge` when projected onto it,
+// whether or not they touch; false when there is none (RemapCursor leaves
+// such crossings alone).
+inline bool ProjectedOverlap(const Rect& src, const Rect& dst, Edge edge, long& lo, long& hi) {
+    bool vertical = edge == Edge::Left || edge == Edge::Right;
+    lo = vertical ? std::max(src.top, dst.top) : std::max(src.left, dst.left);
+    hi = vertical ? std::min(src.bottom, dst.bottom) : std::min(src.right, dst.right);
+    return hi > lo;
+}
+
+inline PortalTransform MakePortalTransform(const Rect& src, const Rect& dst, Edge edge, long ovStart, long ovEnd,
+                                           RemapStrategy strategy, long maxJump) {
+    PortalTransform t{};
+    bool vertical = edge == Edge::Left || edge == Edge::Right;
+    t.edge     = edge;
+    t.strategy = strategy;
+    t.srcStart = vertical ? src.top : src.left;
+    t.srcLen   = vertical ? src.bottom - src.top : src.right - src.left;
+    t.dstStart = vertical ? dst.top : dst.left;
+    t.dstLen   = vertical ? dst.bottom - dst.top : dst.right - dst.left;
+    t.ovStart  = ovStart;
+    t.ovEnd    = ovEnd;
+    t.maxJump  = maxJump;
+    switch (edge) {
+    case Edge::Right:  t.across = dst.left + 1;   break;
+    case Edge::Left:   t.across = dst.right - 2;  break;
+    case Edge::Bottom: t.across = dst.top + 1;    break;
+    default:           t.across = dst.bottom - 2; break;
+    }
+    return t;
+}
+
+// --- Topology ---
+// Rect list plus policy table for EdgeRemapStage::ProcessWith. A crossing
+// the table has no portal for (the cursor skipped a monitor in one event,
+// or left through another edge than the portal's) uses the pair's strategy
+// on a transform built on the spot over the projected overlap. Without
+// such an overlap nothing is remapped, as RemapCursor does, so Percent
+// agrees with the plain rect list everywhere.
+
+template <typename Set = DefaultPolicySet>
+struct PolicyTopology {
+    const Rect*              mons;
+    size_t                   count;
+    const PortalPolicyTable* table;
+
+    int MonitorIndex(Point p) const { return MonitorIndexFromPoint(mons, count, p); }
+
+    CrossingDecision Cross(int src, int dst, Point from, Point to) const {
+        const Rect& s = mons[src];
+        CrossingDecision d{FindExitEdge(from, to, s), false, to};
+        if (d.hit.edge == Edge::None) return d;
+        bool vertical = d.hit.edge == Edge::Left || d.hit.edge == Edge::Right;
+        long coord = vertical ? from.y : from.x;
+        size_t pair = static_cast<size_t>(src) * table->count + static_cast<size_t>(dst);
+        int32_t portal = table->pairPortal[pair];
+        Point mapped;
+        bool remap;
+        if (portal >= 0 && table->transforms[portal].edge == d.hit.edge) {
+            remap = Set::Map(table->transforms[portal], coord, mapped);
+        } else {
+            long lo, hi;
+            if (!ProjectedOverlap(s, mons[dst], d.hit.edge, lo, hi)) return d;
+            PortalTransform t = MakePortalTransform(s, mons[dst], d.hit.edge, lo, hi, table->pairStrategy[pair],
+                                                    table->maxJump);
+            Set::Build(t, table->mmPerPx[static_cast<size_t>(src)], table->mmPerPx[static_cast<size_t>(dst)]);
+            remap = Set::Map(t, coord, mapped);
+        }
+        if (remap && mapped != to) {
+            d.remapped = true;
+            d.mapped   = mapped;
+        }
+        return d;
+    }
+};
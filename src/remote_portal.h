@@ -0,0 +1,534 @@
+#pragma once
+
+// Remote portals: an outer desktop edge with no local neighbour hands the
+// cursor to another machine over UDP. The percentage mapping of a local
+// crossing carries over: the position along that side of the desktop
+// travels as a fraction, and the peer maps it onto the opposite side of
+// its own topology. While the cursor is away, local motion is forwarded
+// in batched packets. Whichever side's cursor leaves through its portal
+// edge hands it back the same way.
+//
+// Wire format: fixed-width fields behind a 24-byte header, copied as host
+// byte order structs; both ends must share a byte order (every supported
+// target is little-endian). Every packet has a per-sender sequence number
+// (never 0, wrapping).
+// Enter packets are retransmitted until acked and applied once. Motion
+// packets are fire-and-forget; late ones are dropped and gaps counted.
+// Ack and Pong echo the sender's timestamp, which gives round-trip times
+// without synchronised clocks.
+
+#include "mapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t PORTAL_MAGIC      = 0x50524d43;  // "CMRP"
+static constexpr uint16_t PORTAL_VERSION    = 1;
+static constexpr size_t   PORTAL_MAX_BATCH  = 64;          // motion deltas per packet
+static constexpr uint64_t PORTAL_RESEND_NS  = 20000000;    // Enter retransmit interval
+
+enum class PortalPacket : uint16_t { Enter = 1, Motion = 2, Ack = 3, Ping = 4, Pong = 5 };
+
+struct PortalHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;     // PortalPacket
+    uint32_t session;  // sender instance; a new value resets the receiver's sequence state
+    uint32_t seq;      // per sender, every packet
+    uint64_t sentNs;   // sender clock; Ack / Pong carry the acked packet's value back
+};
+
+struct PortalEnterBody {
+    uint32_t edge;   // Edge the receiving side's cursor enters through
+    uint32_t along;  // position along that edge, 0 .. 2^32-1 for 0 .. 1
+};
+
+struct PortalAckBody {
+    uint32_t seq;  // acked Enter
+    uint32_t reserved;
+};
+
+struct PortalMotionBody {
+    uint32_t motionSeq;  // counts motion packets only, for loss accounting
+    uint16_t count;      // deltas that follow, <= PORTAL_MAX_BATCH
+    uint16_t reserved;
+};
+
+struct PortalDelta {
+    int16_t dx, dy;
+};
+
+static_assert(sizeof(PortalHeader) == 24, "portal header layout changed");
+static_assert(sizeof(PortalEnterBody) == 8 && sizeof(PortalAckBody) == 8 && sizeof(PortalMotionBody) == 8 &&
+              sizeof(PortalDelta) == 4, "portal body layout changed");
+
+static constexpr size_t PORTAL_MAX_PACKET =
+    sizeof(PortalHeader) + sizeof(PortalMotionBody) + PORTAL_MAX_BATCH * sizeof(PortalDelta);
+
+inline Edge OppositeEdge(Edge e) {
+    switch (e) {
+    case Edge::Left:   return Edge::Right;
+    case Edge::Right:  return Edge::Left;
+    case Edge::Top:    return Edge::Bottom;
+    case Edge::Bottom: return Edge::Top;
+    default:           return Edge::None;
+    }
+}
+
+// --- Geometry ---
+
+// Outer edge the cursor at p (on mons[mon]) pushes through with motion
+// (dx, dy): p sits on the edge pixel, the motion points out, and no local
+// monitor lies beyond. Edge::None otherwise.
+inline Edge OuterExitEdge(const std::vector<Rect>& mons, int mon, Point p, long dx, long dy) {
+    if (mon < 0) return Edge::None;
+    const Rect& rc = mons[mon];
+    Point beyond{p.x + dx, p.y + dy};
+    if (MonitorIndexFromPoint(mons.data(), mons.size(), beyond) >= 0) return Edge::None;
+    // Dominant axis first, matching FindExitEdge's corner tie-break
+    bool horizFirst = std::abs(dx) >= std::abs(dy);
+    for (int pass = 0; pass < 2; ++pass) {
+        if ((pass == 0) == horizFirst) {
+            if (dx < 0 && p.x == rc.left) return Edge::Left;
+            if (dx > 0 && p.x == rc.right - 1) return Edge::Right;
+        } else {
+            if (dy < 0 && p.y == rc.top) return Edge::Top;
+            if (dy > 0 && p.y == rc.bottom - 1) return Edge::Bottom;
+        }
+    }
+    return Edge::None;
+}
+
+// How far out a monitor reaches on side e, and the extent [lo, hi) along
+// that side of the monitors reaching furthest (the desktop's outer edge).
+inline long OuterReach(const Rect& r, Edge e) {
+    switch (e) {
+    case Edge::Left:  return -r.left;
+    case Edge::Right: return r.right;
+    case Edge::Top:   return -r.top;
+    default:          return r.bottom;
+    }
+}
+
+inline bool OuterEdgeSpan(const std::vector<Rect>& mons, Edge e, long& reach, long& lo, long& hi) {
+    reach = lo = hi = 0;
+    if (mons.empty() || e == Edge::None) return false;
+    bool vertical = e == Edge::Left || e == Edge::Right;
+    reach = OuterReach(mons[0], e);
+    for (const Rect& r : mons) reach = std::max(reach, OuterReach(r, e));
+    bool any = false;
+    for (const Rect& r : mons) {
+        if (OuterReach(r, e) != reach) continue;
+        long a = vertical ? r.top : r.left, b = vertical ? r.bottom : r.right;
+        lo  = any ? std::min(lo, a) : a;
+        hi  = any ? std::max(hi, b) : b;
+        any = true;
+    }
+    return true;
+}
+
+// Fraction along the outer edge e at p. Sender and receiver both measure
+// over the whole side of their desktop, so a round trip lands where it left.
+inline double OuterEdgeFraction(const std::vector<Rect>& mons, Edge e, Point p) {
+    long reach, lo, hi;
+    if (!OuterEdgeSpan(mons, e, reach, lo, hi)) return 0.0;
+    double coord = e == Edge::Left || e == Edge::Right ? static_cast<double>(p.y) : static_cast<double>(p.x);
+    return std::clamp((coord - static_cast<double>(lo)) / static_cast<double>(hi - lo), 0.0, 1.0);
+}
+
+inline uint32_t EncodeFraction(double f) {
+    return static_cast<uint32_t>(std::clamp(f, 0.0, 1.0) * 4294967295.0 + 0.5);
+}
+inline double DecodeFraction(uint32_t q) { return static_cast<double>(q) / 4294967295.0; }
+
+// Where a cursor entering through outer edge e at fraction `along` lands:
+// that point of the outer edge, 1 px inside the outermost monitor nearest
+// to it (the side may have gaps), as RemapCursor insets. False for an
+// empty layout.
+inline bool MapRemoteEntry(const std::vector<Rect>& mons, Edge e, double along, Point& out) {
+    long reach, lo, hi;
+    if (!OuterEdgeSpan(mons, e, reach, lo, hi)) return false;
+    bool vertical = e == Edge::Left || e == Edge::Right;
+    long coord = std::min(lo + std::lround(std::clamp(along, 0.0, 1.0) * static_cast<double>(hi - lo)), hi - 1);
+    const Rect* target = nullptr;
+    long bestDist = 0;
+    for (const Rect& r : mons) {
+        if (OuterReach(r, e) != reach) continue;
+        long a = vertical ? r.top : r.left, b = vertical ? r.bottom : r.right;
+        long dist = coord < a ? a - coord : coord >= b ? coord - b + 1 : 0;
+        if (!target || dist < bestDist) {
+            target   = &r;
+            bestDist = dist;
+        }
+    }
+    const Rect& r = *target;
+    long a = vertical ? r.top : r.left, b = vertical ? r.bottom : r.right;
+    coord = std::clamp(coord, a + 1, b - 2);
+    switch (e) {
+    case Edge::Left:   out = {r.left + 1, coord};    break;
+    case Edge::Right:  out = {r.right - 2, coord};   break;
+    case Edge::Top:    out = {coord, r.top + 1};     break;
+    default:           out = {coord, r.bottom - 2};  break;
+    }
+    return true;
+}
+
+// --- UDP endpoint ---
+
+class PortalSocket {
+public:
+    PortalSocket() = default;
+    PortalSocket(const PortalSocket&) = delete;
+    PortalSocket& operator=(const PortalSocket&) = delete;
+    ~PortalSocket() { Close(); }
+
+    // Binds host:port (port 0 picks one); false with Error() set on failure.
+    bool Open(const std::string& host, uint16_t port) {
+        Close();
+#if defined(_WIN32)
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return Fail("WSAStartup failed");
+        wsaStarted_ = true;
+#endif
+        sockaddr_in addr{};
+        if (!Resolve(host, port, addr)) return Fail("cannot resolve bind address");
+        fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (fd_ == BAD_SOCKET) return Fail("socket failed");
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return Fail("bind failed");
+        return true;
+    }
+
+    bool SetPeer(const std::string& host, uint16_t port) {
+        if (!Resolve(host, port, peer_)) return Fail("cannot resolve peer");
+        hasPeer_ = true;
+        return true;
+    }
+
+    uint16_t LocalPort() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) return 0;
+        return ntohs(addr.sin_port);
+    }
+
+    bool Send(const void* data, size_t size) {
+        if (!hasPeer_) return false;
+        return sendto(fd_, static_cast<const char*>(data), static_cast<int>(size), 0,
+                      reinterpret_cast<const sockaddr*>(&peer_), sizeof(peer_)) == static_cast<int>(size);
+    }
+
+    // Waits up to timeoutMs (0: poll, -1: forever); returns the datagram
+    // size, 0 on timeout, -1 on error.
+    int Recv(void* buf, size_t size, int timeoutMs) {
+#if defined(_WIN32)
+        WSAPOLLFD p{fd_, POLLRDNORM, 0};
+        int ready = WSAPoll(&p, 1, timeoutMs);
+#else
+        pollfd p{fd_, POLLIN, 0};
+        int ready = poll(&p, 1, timeoutMs);
+#endif
+        if (ready <= 0) return ready;
+        int n = static_cast<int>(recv(fd_, static_cast<char*>(buf), static_cast<int>(size), 0));
+        return n < 0 ? -1 : n;
+    }
+
+    void Close() {
+        if (fd_ != BAD_SOCKET) {
+#if defined(_WIN32)
+            closesocket(fd_);
+#else
+            close(fd_);
+#endif
+            fd_ = BAD_SOCKET;
+        }
+#if defined(_WIN32)
+        if (wsaStarted_) WSACleanup();
+        wsaStarted_ = false;
+#endif
+        hasPeer_ = false;
+    }
+
+    const char* Error() const { return error_; }
+
+private:
+#if defined(_WIN32)
+    using SocketHandle = SOCKET;
+    using socklen_t    = int;
+    static constexpr SocketHandle BAD_SOCKET = INVALID_SOCKET;
+    bool wsaStarted_ = false;
+#else
+    using SocketHandle = int;
+    static constexpr SocketHandle BAD_SOCKET = -1;
+#endif
+
+    static bool Resolve(const std::string& host, uint16_t port, sockaddr_in& out) {
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family   = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || !res) return false;
+        out = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+        out.sin_port = htons(port);
+        freeaddrinfo(res);
+        return true;
+    }
+
+    bool Fail(const char* why) {
+        error_ = why;
+        Close();
+        return false;
+    }
+
+    SocketHandle fd_      = BAD_SOCKET;
+    sockaddr_in  peer_{};
+    bool         hasPeer_ = false;
+    const char*  error_   = "";
+};
+
+// --- Session: one portal edge, one peer ---
+// Not thread-safe; one thread feeds motion, polls and handles packets.
+
+struct PortalStats {
+    uint64_t packetsSent     = 0;
+    uint64_t packetsReceived = 0;
+    uint64_t motionPackets   = 0;  // received and applied
+    uint64_t motionDeltas    = 0;
+    uint64_t motionLate      = 0;  // arrived after a newer one; dropped
+    uint64_t motionLost      = 0;  // gaps in motionSeq
+    uint64_t motionStray     = 0;  // arrived while the cursor was not here
+    uint64_t handoffsOut     = 0;
+    uint64_t handoffsIn      = 0;
+    uint64_t resends         = 0;
+    uint64_t rejected        = 0;  // bad magic / version / size
+    uint64_t rttSamples      = 0;
+    uint64_t rttNsTotal      = 0;
+};
+
+class PortalSession {
+public:
+    using SendFn = bool (*)(void* ctx, const void* data, size_t size);
+
+    // What a received packet did to the local cursor.
+    struct Event {
+        enum Kind { None, Entered, Moved } kind = None;
+        Point entry{0, 0};    // Entered: where the cursor appears
+        long  dx = 0, dy = 0; // Moved: summed deltas to apply
+    };
+
+    // `edge` is this side's portal edge (toward the peer); `session`
+    // identifies this instance to the peer.
+    PortalSession(Edge edge, uint32_t session, SendFn send, void* ctx, size_t batch = 16)
+        : edge_(edge), session_(session), send_(send), ctx_(ctx),
+          batch_(std::clamp<size_t>(batch, 1, PORTAL_MAX_BATCH)) {}
+
+    Edge PortalEdge() const { return edge_; }
+    bool CursorHere() const { return here_; }
+    const PortalStats& Stats() const { return stats_; }
+    uint64_t LastRttNs() const { return lastRttNs_; }
+
+    // The cursor left through the portal edge at fraction `along`.
+    void HandOff(double along, uint64_t nowNs) {
+        here_ = false;
+        pendingEnter_ = {static_cast<uint32_t>(OppositeEdge(edge_)), EncodeFraction(along)};
+        pendingSeq_   = SendPacket(PortalPacket::Enter, &pendingEnter_, sizeof(pendingEnter_), nowNs);
+        pendingSince_ = nowNs;
+        enterPending_ = true;
+        ++stats_.handoffsOut;
+    }
+
+    // Local input while the cursor is on the peer; sent in batches.
+    void QueueMotion(long dx, long dy, uint64_t nowNs) {
+        while (dx || dy) {
+            // Split deltas beyond int16 so nothing is lost
+            long sx = std::clamp<long>(dx, -32768, 32767), sy = std::clamp<long>(dy, -32768, 32767);
+            batchBuf_[batchCount_++] = {static_cast<int16_t>(sx), static_cast<int16_t>(sy)};
+            dx -= sx;
+            dy -= sy;
+            if (batchCount_ == batch_) Flush(nowNs);
+        }
+        if (batchCount_ && !batchStartNs_) batchStartNs_ = nowNs;
+    }
+
+    // Sends a partial batch older than maxAgeNs, and retransmits an unacked
+    // Enter. Call at least every maxAgeNs.
+    void Poll(uint64_t nowNs, uint64_t maxAgeNs) {
+        if (batchCount_ && nowNs - batchStartNs_ >= maxAgeNs) Flush(nowNs);
+        if (enterPending_ && nowNs - pendingSince_ >= PORTAL_RESEND_NS) {
+            SendPacket(PortalPacket::Enter, &pendingEnter_, sizeof(pendingEnter_), nowNs, pendingSeq_);
+            pendingSince_ = nowNs;
+            ++stats_.resends;
+        }
+    }
+
+    void Flush(uint64_t nowNs) {
+        if (!batchCount_) return;
+        uint8_t buf[PORTAL_MAX_PACKET];
+        PortalMotionBody body{motionSeq_++, static_cast<uint16_t>(batchCount_), 0};
+        memcpy(buf, &body, sizeof(body));
+        memcpy(buf + sizeof(body), batchBuf_, batchCount_ * sizeof(PortalDelta));
+        SendPacket(PortalPacket::Motion, buf, sizeof(body) + batchCount_ * sizeof(PortalDelta), nowNs);
+        batchCount_   = 0;
+        batchStartNs_ = 0;
+    }
+
+    void Ping(uint64_t nowNs) { SendPacket(PortalPacket::Ping, nullptr, 0, nowNs); }
+
+    // Handles one datagram; mons is this side's topology (for Enter).
+    Event OnPacket(const void* data, size_t size, const std::vector<Rect>& mons, uint64_t nowNs) {
+        Event ev;
+        PortalHeader h;
+        if (size < sizeof(h)) return Reject();
+        memcpy(&h, data, sizeof(h));
+        if (h.magic != PORTAL_MAGIC || h.version != PORTAL_VERSION) return Reject();
+        const uint8_t* body = static_cast<const uint8_t*>(data) + sizeof(h);
+        size_t bodySize = size - sizeof(h);
+        ++stats_.packetsReceived;
+        if (h.session != peerSession_) {
+            // Peer restarted: forget its sequence state
+            peerSession_   = h.session;
+            haveEnterSeq_  = false;
+            haveMotionSeq_ = false;
+        }
+
+        switch (static_cast<PortalPacket>(h.type)) {
+        case PortalPacket::Enter: {
+            PortalEnterBody e;
+            if (bodySize < sizeof(e)) return Reject();
+            memcpy(&e, body, sizeof(e));
+            PortalAckBody ack{h.seq, 0};
+            SendPacket(PortalPacket::Ack, &ack, sizeof(ack), h.sentNs);
+            // Retransmit of one already applied; seq wraps, as motionSeq does
+            if (haveEnterSeq_ && static_cast<int32_t>(h.seq - lastEnterSeq_) <= 0) break;
+            lastEnterSeq_ = h.seq;
+            haveEnterSeq_ = true;
+            Edge edge = static_cast<Edge>(e.edge);
+            if (edge < Edge::Left || edge > Edge::Bottom || !MapRemoteEntry(mons, edge, DecodeFraction(e.along), ev.entry))
+                break;
+            here_         = true;
+            enterPending_ = false;  // a crossing hand-off supersedes ours
+            ev.kind = Event::Entered;
+            ++stats_.handoffsIn;
+            break;
+        }
+        case PortalPacket::Motion: {
+            PortalMotionBody m;
+            if (bodySize < sizeof(m)) return Reject();
+            memcpy(&m, body, sizeof(m));
+            if (m.count > PORTAL_MAX_BATCH || bodySize < sizeof(m) + m.count * sizeof(PortalDelta)) return Reject();
+            if (haveMotionSeq_ && static_cast<int32_t>(m.motionSeq - lastMotionSeq_) <= 0) {
+                ++stats_.motionLate;
+                break;
+            }
+            if (haveMotionSeq_) stats_.motionLost += m.motionSeq - lastMotionSeq_ - 1;
+            lastMotionSeq_ = m.motionSeq;
+            haveMotionSeq_ = true;
+            if (!here_) {
+                ++stats_.motionStray;
+                break;
+            }
+            PortalDelta d[PORTAL_MAX_BATCH];
+            memcpy(d, body + sizeof(m), m.count * sizeof(PortalDelta));
+            for (size_t i = 0; i < m.count; ++i) {
+                ev.dx += d[i].dx;
+                ev.dy += d[i].dy;
+            }
+            ev.kind = Event::Moved;
+            ++stats_.motionPackets;
+            stats_.motionDeltas += m.count;
+            break;
+        }
+        case PortalPacket::Ack: {
+            PortalAckBody a;
+            if (bodySize < sizeof(a)) return Reject();
+            memcpy(&a, body, sizeof(a));
+            if (enterPending_ && a.seq == pendingSeq_) enterPending_ = false;
+            AddRtt(nowNs - h.sentNs);
+            break;
+        }
+        case PortalPacket::Ping:
+            SendPacket(PortalPacket::Pong, nullptr, 0, h.sentNs);
+            break;
+        case PortalPacket::Pong:
+            AddRtt(nowNs - h.sentNs);
+            break;
+        default:
+            return Reject();
+        }
+        return ev;
+    }
+
+    // Cursor handed to us before any peer exists (the side with the input
+    // device starts with it).
+    void SetCursorHere(bool here) { here_ = here; }
+
+private:
+    Event Reject() {
+        ++stats_.rejected;
+        return {};
+    }
+
+    void AddRtt(uint64_t ns) {
+        ++stats_.rttSamples;
+        stats_.rttNsTotal += ns;
+        lastRttNs_ = ns;
+    }
+
+    // Returns the sequence number used (seq, or the next one when 0).
+    uint32_t SendPacket(PortalPacket type, const void* body, size_t size, uint64_t sentNs, uint32_t seq = 0) {
+        uint8_t buf[PORTAL_MAX_PACKET];
+        if (!seq) {
+            if (++seq_ == 0) ++seq_;  // 0 asks for the next one, so it is never sent
+            seq = seq_;
+        }
+        PortalHeader h{PORTAL_MAGIC, PORTAL_VERSION, static_cast<uint16_t>(type), session_, seq, sentNs};
+        memcpy(buf, &h, sizeof(h));
+        if (size) memcpy(buf + sizeof(h), body, size);
+        if (send_(ctx_, buf, sizeof(h) + size)) ++stats_.packetsSent;
+        return h.seq;
+    }
+
+    Edge     edge_;
+    uint32_t session_;
+    SendFn   send_;
+    void*    ctx_;
+    size_t   batch_;
+
+    bool     here_ = false;
+    uint32_t seq_  = 0;
+
+    PortalDelta batchBuf_[PORTAL_MAX_BATCH];
+    size_t      batchCount_   = 0;
+    uint64_t    batchStartNs_ = 0;
+    uint32_t    motionSeq_    = 0;
+
+    bool            enterPending_ = false;
+    PortalEnterBody pendingEnter_{};
+    uint32_t        pendingSeq_   = 0;
+    uint64_t        pendingSince_ = 0;
+
+    uint32_t peerSession_   = 0;
+    uint32_t lastEnterSeq_  = 0;
+    bool     haveEnterSeq_  = false;
+    uint32_t lastMotionSeq_ = 0;
+    bool     haveMotionSeq_ = false;
+
+    uint64_t    lastRttNs_ = 0;
+    PortalStats stats_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+// Portable timing policy for topology verification. No timers of its own:
+// the platform layer asks NextDelay() and arms whatever one-shot timer it
+// has, so the policy runs unchanged against a fake clock.
+//
+// Idle costs nothing: verification is only armed by a change notification,
+// then re-checks at initialMs, 2x, 4x ... up to maxMs and stops. A check
+// that finds another change restarts the sequence (the layout is still
+// settling, e.g. a dock attaching monitors one by one).
+
+#include <cstdint>
+
+static constexpr uint64_t NO_DEADLINE = UINT64_MAX;
+
+struct VerifyBackoff {
+    uint64_t initialMs = 250;
+    uint64_t maxMs     = 8000;
+    bool     enabled   = true;
+
+    uint64_t dueMs      = NO_DEADLINE;
+    uint64_t intervalMs = 0;
+
+    void OnChangeNotification(uint64_t nowMs) {
+        if (!enabled) return;
+        intervalMs = initialMs;
+        dueMs      = nowMs + intervalMs;
+    }
+
+    // Milliseconds until the next check, or NO_DEADLINE when idle.
+    uint64_t NextDelay(uint64_t nowMs) const {
+        if (dueMs == NO_DEADLINE) return NO_DEADLINE;
+        return dueMs > nowMs ? dueMs - nowMs : 0;
+    }
+
+    bool Due(uint64_t nowMs) const { return dueMs != NO_DEADLINE && nowMs >= dueMs; }
+
+    // Call after running a due check; `changed` is whether it found a new
+    // layout.
+    void OnChecked(uint64_t nowMs, bool changed) {
+        if (changed) {
+            OnChangeNotification(nowMs);
+            return;
+        }
+        if (intervalMs >= maxMs) {
+            dueMs = NO_DEADLINE;
+            return;
+        }
+        intervalMs *= 2;
+        if (intervalMs > maxMs) intervalMs = maxMs;
+        dueMs = nowMs + intervalMs;
+    }
+};
+
+// Counts thread wakeups attributable to topology tracking.
+struct WakeupCounter {
+    uint64_t startMs       = 0;
+    uint64_t notifications = 0;  // OS change notifications handled
+    uint64_t timerWakeups  = 0;  // verification timer expiries
+
+    uint64_t Total() const { return notifications + timerWakeups; }
+
+    double PerHour(uint64_t nowMs) const {
+        uint64_t elapsed = nowMs > startMs ? nowMs - startMs : 0;
+        if (!elapsed) return 0.0;
+        return static_cast<double>(Total()) * 3600000.0 / static_cast<double>(elapsed);
+    }
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+// Shadow evaluation of a candidate crossing decision. The mapping thread
+// hands every crossing (both monitor rects, the segment and the decision it
+// applied) to a worker through an SPSC queue and never waits: a full queue
+// drops the crossing and the caller counts it. The worker re-runs each
+// crossing with the live implementation and the candidate, times both on
+// the same thread, and records where the candidate's answer differs. Only
+// the live decision is ever applied.
+
+#include "mapping.h"
+#include "metrics.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using MappingFn = CrossingDecision (*)(const Rect& src, const Rect& dst, Point from, Point to);
+
+struct ShadowCrossing {
+    Rect             src, dst;
+    Point            from, to;
+    int              srcIndex, dstIndex;
+    CrossingDecision live;  // what the mapping thread applied
+    uint32_t         time;
+};
+
+enum class ShadowDiff { None, Edge, Remap, Position };
+
+inline ShadowDiff CompareDecisions(const CrossingDecision& live, const CrossingDecision& cand) {
+    if (live.hit.edge != cand.hit.edge) return ShadowDiff::Edge;
+    if (live.remapped != cand.remapped) return ShadowDiff::Remap;
+    if (live.remapped && live.mapped != cand.mapped) return ShadowDiff::Position;
+    return ShadowDiff::None;
+}
+
+inline const char* ShadowDiffName(ShadowDiff d) {
+    switch (d) {
+    case ShadowDiff::Edge:     return "edge";
+    case ShadowDiff::Remap:    return "remap";
+    case ShadowDiff::Position: return "position";
+    default:                   return "none";
+    }
+}
+
+struct ShadowDivergence {
+    ShadowCrossing   crossing;
+    CrossingDecision candidate;
+    ShadowDiff       kind;
+};
+
+// Called on the shadow thread for every divergence.
+using DivergenceFn = void (*)(void* ctx, const ShadowDivergence& d);
+
+class ShadowEvaluator {
+public:
+    static constexpr int    TIMING_REPS = 8;   // calls per implementation and crossing
+    static constexpr size_t BATCH       = 32;
+
+    explicit ShadowEvaluator(size_t capacity = 1024) : queue_(capacity) {}
+    ShadowEvaluator(const ShadowEvaluator&) = delete;
+    ShadowEvaluator& operator=(const ShadowEvaluator&) = delete;
+    ~ShadowEvaluator() { Stop(); }
+
+    // metrics is the shadow thread's own block (may be null).
+    void Start(MappingFn candidate, ThreadMetrics* metrics, DivergenceFn onDivergence = nullptr,
+               void* ctx = nullptr, MappingFn live = MapCrossing) {
+        Stop();
+        candidate_    = candidate;
+        live_         = live;
+        metrics_      = metrics;
+        onDivergence_ = onDivergence;
+        ctx_          = ctx;
+        stop_         = false;
+        thread_       = std::thread([this] { Run(); });
+    }
+
+    // Evaluates whatever is still queued, then joins.
+    void Stop() {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    bool Running() const { return thread_.joinable(); }
+
+    // Mapping thread. Never blocks; false when the queue is full.
+    bool Submit(const ShadowCrossing& c) {
+        if (!queue_.TryPush(c)) return false;
+        submitted_.store(submitted_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // Pairs with the fence in Run: either the worker sees the item
+        // before sleeping, or we see it asleep and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+        return true;
+    }
+
+    // Mapping thread: waits until everything submitted so far is evaluated
+    // (replays that read results between phases).
+    void Drain() const {
+        SpinWait wait;
+        uint64_t target = submitted_.load(std::memory_order_relaxed);
+        while (evaluated_.load(std::memory_order_acquire) < target) wait();
+    }
+
+private:
+    void Run() {
+        ShadowCrossing batch[BATCH];
+        for (;;) {
+            size_t n = queue_.PopBatch(batch, BATCH);
+            for (size_t i = 0; i < n; ++i) Evaluate(batch[i]);
+            if (n) {
+                evaluated_.fetch_add(n, std::memory_order_release);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue_.SizeApprox() == 0) {
+                if (stop_) break;
+                wake_.wait(lock);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void Evaluate(const ShadowCrossing& c) {
+        // Alternate which implementation runs first so neither always gets
+        // the warmer cache
+        bool liveFirst = (order_++ & 1) == 0;
+        CrossingDecision cand{}, live{};
+        uint64_t liveNs = 0, candNs = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            bool runLive = (pass == 0) == liveFirst;
+            MappingFn fn = runLive ? live_ : candidate_;
+            CrossingDecision& out = runLive ? live : cand;
+            uint64_t t0 = MetricsNowNs();
+            for (int r = 0; r < TIMING_REPS; ++r) out = fn(c.src, c.dst, c.from, c.to);
+            (runLive ? liveNs : candNs) = MetricsNowNs() - t0;
+        }
+        ShadowDiff kind = CompareDecisions(c.live, cand);
+        {
+            MetricsUpdate update(metrics_);
+            if (metrics_) {
+                metrics_->shadowEvaluated.Add();
+                metrics_->shadowTimedCalls.Add(TIMING_REPS);
+                metrics_->shadowLiveNs.Add(liveNs);
+                metrics_->shadowCandidateNs.Add(candNs);
+                if (kind == ShadowDiff::Edge) metrics_->shadowEdgeDiffs.Add();
+                else if (kind == ShadowDiff::Remap) metrics_->shadowRemapDiffs.Add();
+                else if (kind == ShadowDiff::Position) metrics_->shadowPositionDiffs.Add();
+            }
+        }
+        if (kind != ShadowDiff::None && onDivergence_) onDivergence_(ctx_, {c, cand, kind});
+    }
+
+    SpscQueue<ShadowCrossing> queue_;
+    MappingFn      candidate_    = nullptr;
+    MappingFn      live_         = MapCrossing;
+    ThreadMetrics* metrics_      = nullptr;
+    DivergenceFn   onDivergence_ = nullptr;
+    void*          ctx_          = nullptr;
+    uint64_t       order_        = 0;  // shadow thread
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> submitted_{0};  // mapping thread
+    alignas(CACHE_LINE) std::atomic<uint64_t> evaluated_{0};  // shadow thread
+    std::atomic<bool>       sleeping_{false};
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    bool                    stop_ = false;  // guarded by mutex_
+    std::thread             thread_;
+};
+
+// --- Candidates ---
+// Each differs from MapCrossing in one decision, so a divergence points at
+// that decision.
+
+// Corner exits (the segment leaves exactly through a corner) take the edge
+// that faces the destination monitor, instead of following the dominant
+// axis of motion.
+inline CrossingDecision MapCrossingCornerFacing(const Rect& src, const Rect& dst, Point from, Point to) {
+    CrossingDecision d = MapCrossing(src, dst, from, to);
+    Edge e = d.hit.edge;
+    auto faces = [&](Edge edge) {
+        switch (edge) {
+        case Edge::Left:   return dst.right <= src.left;
+        case Edge::Right:  return dst.left >= src.right;
+        case Edge::Top:    return dst.bottom <= src.top;
+        case Edge::Bottom: return dst.top >= src.bottom;
+        default:           return false;
+        }
+    };
+    if (e == Edge::None || faces(e)) return d;
+
+    // Hit coordinate on the chosen edge tells which corner, if any
+    bool horiz = e == Edge::Left || e == Edge::Right;
+    double lo = horiz ? static_cast<double>(src.top) : static_cast<double>(src.left);
+    double hi = horiz ? static_cast<double>(src.bottom) : static_cast<double>(src.right);
+    Edge other = Edge::None;
+    if (d.hit.coord == lo) other = horiz ? Edge::Top : Edge::Left;
+    else if (d.hit.coord == hi) other = horiz ? Edge::Bottom : Edge::Right;
+    if (other == Edge::None || !faces(other)) return d;
+
+    CrossingDecision alt{{other, d.hit.t, horiz ? (e == Edge::Left ? static_cast<double>(src.left)
+                                                                    : static_cast<double>(src.right))
+                                                : (e == Edge::Top ? static_cast<double>(src.top)
+                                                                  : static_cast<double>(src.bottom))},
+                         false, to};
+    double srcCoord = (other == Edge::Left || other == Edge::Right) ? static_cast<double>(from.y)
+                                                                    : static_cast<double>(from.x);
+    Point mapped;
+    if (RemapCursor(src, dst, other, srcCoord, mapped) && mapped != to) {
+        alt.remapped = true;
+        alt.mapped   = mapped;
+    }
+    return alt;
+}
+
+// Lands on the destination's edge pixel instead of 1 px inside it.
+inline CrossingDecision MapCrossingNoInset(const Rect& src, const Rect& dst, Point from, Point to) {
+    CrossingDecision d = MapCrossing(src, dst, from, to);
+    Edge e = d.hit.edge;
+    Point mapped;
+    double srcCoord = (e == Edge::Left || e == Edge::Right) ? static_cast<double>(from.y)
+                                                            : static_cast<double>(from.x);
+    if (e == Edge::None || !RemapCursor(src, dst, e, srcCoord, mapped)) return d;
+
+    bool horiz = e == Edge::Left || e == Edge::Right;
+    long srcStart = horiz ? src.top : src.left, srcLen = horiz ? src.bottom - src.top : src.right - src.left;
+    long dstStart = horiz ? dst.top : dst.left, dstLen = horiz ? dst.bottom - dst.top : dst.right - dst.left;
+    double pct = std::clamp((srcCoord - srcStart) / static_cast<double>(srcLen), 0.0, 1.0);
+    long along = std::clamp(dstStart + static_cast<long>(std::lround(pct * dstLen)), dstStart,
+                            dstStart + dstLen - 1);
+    switch (e) {
+    case Edge::Right:  mapped = {dst.left, along};       break;
+    case Edge::Left:   mapped = {dst.right - 1, along};  break;
+    case Edge::Bottom: mapped = {along, dst.top};        break;
+    default:           mapped = {along, dst.bottom - 1}; break;
+    }
+    d.remapped = mapped != to;
+    d.mapped   = d.remapped ? mapped : to;
+    return d;
+}
+
+struct ShadowCandidate {
+    const char* name;
+    MappingFn   fn;
+    const char* description;
+};
+
+static const ShadowCandidate SHADOW_CANDIDATES[] = {
+    {"live", MapCrossing, "the live implementation (control, never diverges)"},
+    {"corner-facing", MapCrossingCornerFacing, "corner exits take the edge facing the destination"},
+    {"no-inset", MapCrossingNoInset, "land on the destination edge pixel, no 1 px inset"},
+};
+
+inline const ShadowCandidate* FindShadowCandidate(const char* name) {
+    for (const auto& c : SHADOW_CANDIDATES)
+        if (strcmp(c.name, name) == 0) return &c;
+    return nullptr;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+// A named shared-memory mapping of fixed size: POSIX shm_open, or a
+// pagefile-backed file mapping on Windows. The creator maps it read-write;
+// readers map it read-only, so they can never write into the owner's data.
+// On POSIX a region outlives a crashed owner, so the creator replaces an
+// existing one only when the pid recorded in its header is gone. A region
+// without a pid yet is another instance still setting it up: the creator
+// waits for the pid and never replaces such a region. (A creator killed in
+// that microsecond window leaves a name that has to be removed by hand.)
+// Windows mappings die with their last handle, so nothing stale is left to
+// replace there and an existing name always fails.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class SharedRegion {
+public:
+    SharedRegion() = default;
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+    ~SharedRegion() { Close(); }
+
+    // Writer side. Fails if another live instance owns the name or is still
+    // creating it, or the mapping cannot be created. The memory is zeroed. `pidOffset` locates
+    // the owner's uint64_t pid in the region, which the owner stores before
+    // publishing anything else.
+    bool Create(const std::string& name, size_t size, size_t pidOffset) {
+        Close();
+        name_ = name;
+        size_ = size;
+#if defined(_WIN32)
+        handle_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size),
+                                     name.c_str());
+        if (!handle_) return Fail("CreateFileMapping failed");
+        if (GetLastError() == ERROR_ALREADY_EXISTS) return Fail("another instance owns the region");
+        view_ = MapViewOfFile(handle_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd < 0 && errno == EEXIST) {
+            Owner owner = OwnerOf(name, pidOffset);
+            for (int waited = 0; owner == Owner::Starting && waited < STARTUP_WAIT_MS; waited += 10) {
+                usleep(10000);
+                owner = OwnerOf(name, pidOffset);
+            }
+            if (owner == Owner::Starting) return Fail("another instance is still creating the region");
+            if (owner == Owner::Alive) return Fail("another instance owns the region");
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        }
+        if (fd < 0) return Fail("shm_open failed");
+        owner_ = true;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            return Fail("ftruncate failed");
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        view_ = p == MAP_FAILED ? nullptr : p;
+#endif
+        if (!view_) return Fail("mapping failed");
+        return true;
+    }
+
+    // Reader side: maps an existing region of at least `size` bytes.
+    bool Open(const std::string& name, size_t size) {
+        Close();
+        name_ = name;
+        size_ = size;
+#if defined(_WIN32)
+        handle_ = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+        if (!handle_) return Fail("no such region (is cursor_mapper running?)");
+        view_ = MapViewOfFile(handle_, FILE_MAP_READ, 0, 0, size);
+#else
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return Fail("no such region (is cursor_mapper running?)");
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+            close(fd);
+            return Fail("region too small for this layout");
+        }
+        void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        view_ = p == MAP_FAILED ? nullptr : p;
+#endif
+        if (!view_) return Fail("mapping failed");
+        return true;
+    }
+
+    void Close() {
+        if (view_) {
+#if defined(_WIN32)
+            UnmapViewOfFile(view_);
+#else
+            munmap(view_, size_);
+#endif
+            view_ = nullptr;
+        }
+#if defined(_WIN32)
+        if (handle_) CloseHandle(handle_);
+        handle_ = nullptr;
+#else
+        if (owner_) shm_unlink(name_.c_str());
+        owner_ = false;
+#endif
+    }
+
+    void* Data() const { return view_; }
+    bool IsOpen() const { return view_ != nullptr; }
+    const char* Error() const { return error_; }
+
+    // For wrappers that fail after mapping (bad header): unmap and report.
+    bool Fail(const char* why) {
+        error_ = why;
+        Close();
+        return false;
+    }
+
+private:
+#if !defined(_WIN32)
+    static constexpr int STARTUP_WAIT_MS = 1000;  // for a creator to record its pid
+
+    enum class Owner { Alive, Gone, Starting };
+
+    // Gone when the recorded pid no longer exists (or the region vanished);
+    // Starting while the pid is not recorded yet (region still being sized,
+    // pid still 0). Regions we cannot even open belong to someone else.
+    static Owner OwnerOf(const std::string& name, size_t pidOffset) {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return errno == ENOENT ? Owner::Gone : Owner::Alive;
+        size_t len = pidOffset + sizeof(uint64_t);
+        struct stat st{};
+        Owner owner = Owner::Alive;
+        if (fstat(fd, &st) == 0) {
+            if (static_cast<size_t>(st.st_size) < len) {
+                owner = Owner::Starting;
+            } else if (void* p = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0); p != MAP_FAILED) {
+                uint64_t pid = 0;
+                memcpy(&pid, static_cast<const char*>(p) + pidOffset, sizeof(pid));
+                munmap(p, len);
+                if (pid == 0) owner = Owner::Starting;
+                else if (kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) owner = Owner::Gone;
+            }
+        }
+        close(fd);
+        return owner;
+    }
+#endif
+
+    std::string name_;
+    size_t      size_  = 0;
+    void*       view_  = nullptr;
+    const char* error_ = "";
+#if defined(_WIN32)
+    HANDLE handle_ = nullptr;
+#else
+    bool owner_ = false;
+#endif
+};
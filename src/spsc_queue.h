@@ -0,0 +1,110 @@
+#pragma once
+
+// Bounded lock-free single-producer / single-consumer ring.
+// Producer and consumer indices live on separate cache lines, and each side
+// keeps a private copy of the other's index so the shared line is only
+// touched when the cached view says the ring looks full / empty.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static constexpr size_t CACHE_LINE = 64;
+
+inline void CpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Spin briefly on an empty / full queue, then start yielding so an endpoint
+// sharing a core with its peer still makes progress.
+struct SpinWait {
+    unsigned spins = 0;
+
+    void operator()() {
+        if (++spins < 64) CpuRelax();
+        else std::this_thread::yield();
+    }
+    void Reset() { spins = 0; }
+};
+
+template <typename T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_  = cap - 1;
+        slots_ = std::make_unique<T[]>(cap);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t Capacity() const { return mask_ + 1; }
+
+    // --- Producer side ---
+
+    bool TryPush(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // --- Consumer side ---
+
+    bool TryPop(T& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) return false;
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pops up to max items with a single index publish.
+    size_t PopBatch(T* out, size_t max) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) return 0;
+        }
+        size_t n = std::min(max, cachedTail_ - head);
+        for (size_t i = 0; i < n; ++i) out[i] = slots_[(head + i) & mask_];
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Approximate; exact only when called from either endpoint while the
+    // other side is idle.
+    size_t SizeApprox() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};  // written by consumer
+    size_t cachedTail_ = 0;                            // consumer's view of tail_
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};  // written by producer
+    size_t cachedHead_ = 0;                            // producer's view of head_
+    alignas(CACHE_LINE) size_t mask_ = 0;
+    std::unique_ptr<T[]> slots_;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+// Live statistics in shared memory. The daemon places its ThreadMetrics
+// blocks directly in a named mapping (shared_region.h), so external
+// readers see counters without any request to the process: no socket, no
+// context switch on the daemon side.
+// Consistency comes from each block's seqlock; readers map the region
+// read-only and can never stall the writer.
+//
+// Layout is fixed and versioned: bump STATS_LAYOUT_VERSION whenever
+// ThreadMetrics or StatsHeader change shape.
+
+#include "metrics.h"
+#include "shared_region.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+
+static constexpr uint32_t STATS_MAGIC          = 0x4d53434dU;  // "MCSM"
+static constexpr uint32_t STATS_LAYOUT_VERSION = 2;
+static constexpr size_t   STATS_SLOTS          = MetricsRegistry::MAX_THREADS;
+
+#if defined(_WIN32)
+static constexpr const char* DEFAULT_STATS_NAME = "Local\\cursor_mapper_stats";
+#else
+static constexpr const char* DEFAULT_STATS_NAME = "/cursor_mapper_stats";
+#endif
+
+struct alignas(CACHE_LINE) StatsHeader {
+    std::atomic<uint32_t> magic{0};  // stored last by the creator
+    uint32_t layoutVersion = 0;
+    uint32_t blockSize     = 0;      // sizeof(ThreadMetrics)
+    uint32_t slots         = 0;
+    uint64_t pid           = 0;
+    uint64_t startUnixMs   = 0;
+};
+
+struct StatsLayout {
+    StatsHeader   header;
+    ThreadMetrics blocks[STATS_SLOTS];  // unused slots stay zero
+};
+
+class StatsRegion {
+public:
+    // Writer side: creates the region read-write, replacing a stale one left
+    // by a crashed instance. Fails if another live instance owns the name or
+    // the mapping cannot be created.
+    bool Create(const std::string& name) {
+        if (!region_.Create(name, sizeof(StatsLayout), offsetof(StatsHeader, pid))) return false;
+        view_ = new (region_.Data()) StatsLayout();
+        StatsHeader& h = view_->header;
+        h.layoutVersion = STATS_LAYOUT_VERSION;
+        h.blockSize     = sizeof(ThreadMetrics);
+        h.slots         = STATS_SLOTS;
+#if defined(_WIN32)
+        h.pid = GetCurrentProcessId();
+#else
+        h.pid = static_cast<uint64_t>(getpid());
+#endif
+        h.startUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        h.magic.store(STATS_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    // Reader side: maps an existing region read-only and checks its layout.
+    bool Open(const std::string& name) {
+        view_ = nullptr;
+        if (!region_.Open(name, sizeof(StatsLayout))) return false;
+        view_ = static_cast<StatsLayout*>(region_.Data());
+        const StatsHeader& h = view_->header;
+        if (h.magic.load(std::memory_order_acquire) != STATS_MAGIC) return Fail("region not initialised");
+        if (h.layoutVersion != STATS_LAYOUT_VERSION || h.blockSize != sizeof(ThreadMetrics) ||
+            h.slots != STATS_SLOTS)
+            return Fail("layout version mismatch");
+        return true;
+    }
+
+    void Close() {
+        region_.Close();
+        view_ = nullptr;
+    }
+
+    bool IsOpen() const { return view_ != nullptr; }
+    const char* Error() const { return region_.Error(); }
+    const StatsHeader& Header() const { return view_->header; }
+
+    // Writer: hand these to MetricsRegistry::UseStorage().
+    ThreadMetrics* Blocks() { return view_->blocks; }
+
+    // Reader: sums consistent snapshots of every slot; returns how many were
+    // still mid-update after all retries.
+    size_t Total(ThreadMetrics& total) const {
+        size_t torn = 0;
+        for (const ThreadMetrics& b : view_->blocks)
+            if (!b.SnapshotInto(total)) ++torn;
+        return torn;
+    }
+
+private:
+    bool Fail(const char* why) {
+        view_ = nullptr;
+        return region_.Fail(why);
+    }
+
+    SharedRegion region_;
+    StatsLayout* view_ = nullptr;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+// Immutable topology snapshots handed from the thread that detects layout
+// changes to the mapping thread. Publishing is a single atomic pointer
+// store; the mapping thread never waits on the writer.
+//
+// Reclamation assumes one reader (the mapping thread). The reader announces
+// the version it is using; since it only ever moves forward, every retired
+// snapshot older than that version is unreachable and the writer frees it.
+
+#include "mapping.h"
+#include "probes.h"
+#include "remap_policy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Stretch of edge two touching monitors share: leaving src through `edge`
+// within [overlapStart, overlapEnd) (y for left / right, x for top / bottom)
+// lands on dst.
+struct TopologyPortal {
+    int  src, dst;
+    Edge edge;
+    long overlapStart, overlapEnd;
+};
+
+struct TopologySnapshot {
+    uint64_t                       version = 0;
+    std::vector<Rect>              monitors;
+    std::vector<TopologyPortal>    portals;  // derived from monitors, BuildPortals order
+    bool                           baked = false;  // is the layout compiled in (baked_topology.h)
+    PortalPolicyTable              policies;       // per-portal strategies (remap_policy.h)
+    std::vector<PortalPolicyTable> profiles;       // per-application profiles (app_profiles.h)
+};
+
+// Portal graph of a layout, ordered by source monitor, then edge, then
+// destination. O(n^2) over the monitors; built once per layout.
+inline std::vector<TopologyPortal> BuildPortals(const std::vector<Rect>& mons) {
+    std::vector<TopologyPortal> out;
+    static const Edge EDGES[] = {Edge::Left, Edge::Right, Edge::Top, Edge::Bottom};
+    for (size_t s = 0; s < mons.size(); ++s) {
+        const Rect& a = mons[s];
+        for (Edge e : EDGES) {
+            for (size_t d = 0; d < mons.size(); ++d) {
+                const Rect& b = mons[d];
+                if (d == s) continue;
+                bool touches = (e == Edge::Left && b.right == a.left) || (e == Edge::Right && b.left == a.right) ||
+                               (e == Edge::Top && b.bottom == a.top) || (e == Edge::Bottom && b.top == a.bottom);
+                if (!touches) continue;
+                bool vertical = e == Edge::Left || e == Edge::Right;
+                long lo = vertical ? std::max(a.top, b.top) : std::max(a.left, b.left);
+                long hi = vertical ? std::min(a.bottom, b.bottom) : std::min(a.right, b.right);
+                if (hi > lo) out.push_back({static_cast<int>(s), static_cast<int>(d), e, lo, hi});
+            }
+        }
+    }
+    return out;
+}
+
+// Per-portal transforms for `config`, in portal order, and the strategy of
+// every monitor pair; mmPerPx holds each monitor's pixel pitch (0 or
+// missing: unknown).
+inline PortalPolicyTable BuildPortalPolicies(const std::vector<Rect>& mons, const std::vector<TopologyPortal>& portals,
+                                             const PortalStrategyConfig& config,
+                                             const std::vector<double>& mmPerPx = {}) {
+    PortalPolicyTable table;
+    size_t n = mons.size();
+    table.count   = n;
+    table.maxJump = config.maxJump;
+    table.mmPerPx.assign(n, 0.0);
+    std::copy_n(mmPerPx.begin(), std::min(n, mmPerPx.size()), table.mmPerPx.begin());
+    auto pitch = [&](int m) { return table.mmPerPx[static_cast<size_t>(m)]; };
+    table.pairPortal.assign(n * n, -1);
+    table.pairStrategy.assign(n * n, RemapStrategy::Percent);
+    for (size_t s = 0; s < n; ++s) {
+        for (size_t d = 0; d < n; ++d) {
+            if (s == d) continue;
+            RemapStrategy strategy = config.For(static_cast<int>(s), static_cast<int>(d));
+            table.pairStrategy[s * n + d] = strategy;
+            table.custom = table.custom || strategy != RemapStrategy::Percent;
+        }
+    }
+    table.transforms.reserve(portals.size());
+    for (const TopologyPortal& p : portals) {
+        PortalTransform t = MakePortalTransform(mons[p.src], mons[p.dst], p.edge, p.overlapStart, p.overlapEnd,
+                                                config.For(p.src, p.dst), config.maxJump);
+        DefaultPolicySet::Build(t, pitch(p.src), pitch(p.dst));
+        // Two rects touch along one side at most, so the pair is unique
+        table.pairPortal[static_cast<size_t>(p.src) * n + static_cast<size_t>(p.dst)] =
+            static_cast<int32_t>(table.transforms.size());
+        table.transforms.push_back(t);
+    }
+    return table;
+}
+
+class SnapshotPublisher {
+public:
+    SnapshotPublisher() = default;
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    ~SnapshotPublisher() {
+        delete current_.load(std::memory_order_relaxed);
+        for (auto* s : retired_) delete s;
+    }
+
+    // --- Writer side ---
+
+    // Stamps the next version, swaps it in and frees what it can.
+    // Returns the version assigned.
+    uint64_t Publish(std::unique_ptr<TopologySnapshot> snap) {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        snap->version = ++lastVersion_;
+        CURSOR_MAPPER_PROBE2(topology_published, lastVersion_, snap->monitors.size());
+        TopologySnapshot* old = current_.exchange(snap.release(), std::memory_order_acq_rel);
+        if (old) retired_.push_back(old);
+        ReclaimLocked();
+        return lastVersion_;
+    }
+
+    // Frees retired snapshots the reader has moved past; returns how many
+    // are still waiting.
+    size_t Reclaim() {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return ReclaimLocked();
+    }
+
+    size_t RetiredCount() const {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return retired_.size();
+    }
+
+    // Version the reader last acquired (0 before its first Acquire).
+    uint64_t ReaderVersion() const { return readerVersion_.load(std::memory_order_acquire); }
+
+    // --- Reader side (single mapping thread) ---
+
+    // Current snapshot, or nullptr before the first Publish. The pointer
+    // stays valid until the reader acquires a newer one.
+    const TopologySnapshot* Acquire() {
+        const TopologySnapshot* s = current_.load(std::memory_order_acquire);
+        if (s && s->version != readerVersion_.load(std::memory_order_relaxed))
+            readerVersion_.store(s->version, std::memory_order_release);
+        return s;
+    }
+
+private:
+    size_t ReclaimLocked() {
+        uint64_t inUse = readerVersion_.load(std::memory_order_acquire);
+        size_t kept = 0;
+        for (auto* s : retired_) {
+            if (s->version < inUse) delete s;
+            else retired_[kept++] = s;
+        }
+        retired_.resize(kept);
+        return kept;
+    }
+
+    std::atomic<TopologySnapshot*> current_{nullptr};
+    alignas(64) std::atomic<uint64_t> readerVersion_{0};
+
+    mutable std::mutex             writerMutex_;  // writers only, never the reader
+    uint64_t                       lastVersion_ = 0;
+    std::vector<TopologySnapshot*> retired_;
+};
@@ -0,0 +1,208 @@
+#pragma once
+
+// Persisted topology snapshots, so a restart on a known layout skips
+// deriving the portal graph. One file per layout, named after the hash of
+// the topology signature; a file is used only when its hash matches the
+// live signature and it passes validation, otherwise the snapshot is built
+// from the rects as usual and the file rewritten. A loaded file is copied
+// into an ordinary snapshot; nothing keeps the mapping. For layouts up to
+// a few dozen monitors deriving is faster than loading (bench_startup).
+//
+// The file is position independent: a 64-byte header, then fixed-width
+// little-endian tables addressed by offsets from the start of the file (as
+// in trace_format.h, so one file serves 32- and 64-bit `long`). A checksum
+// over everything after the header catches torn or stale writes.
+
+#include "mapped_file.h"
+#include "topology.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static constexpr char     TOPOLOGY_CACHE_MAGIC[8]     = {'C', 'M', 'T', 'O', 'P', 'O', '\0', '\0'};
+static constexpr uint32_t TOPOLOGY_CACHE_VERSION      = 1;
+static constexpr uint32_t TOPOLOGY_CACHE_MAX_MONITORS = 64;
+
+struct TopologyCacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t headerSize;     // sizeof(TopologyCacheHeader)
+    uint64_t signatureHash;  // TopologySignatureHash of the layout
+    uint64_t fileSize;
+    uint64_t checksum;       // FNV-1a over bytes [headerSize, fileSize)
+    uint32_t monitorCount;
+    uint32_t monitorOffset;  // CachedMonitor[monitorCount]
+    uint32_t portalCount;
+    uint32_t portalOffset;   // CachedPortal[portalCount]
+    uint8_t  reserved[8];
+};
+
+struct CachedMonitor {
+    int32_t left, top, right, bottom;
+};
+
+struct CachedPortal {
+    uint16_t src, dst;
+    uint32_t edge;  // Edge
+    int32_t  overlapStart, overlapEnd;
+};
+
+static_assert(sizeof(TopologyCacheHeader) == 64, "topology cache header layout changed");
+static_assert(sizeof(CachedMonitor) == 16 && sizeof(CachedPortal) == 16, "topology cache table layout changed");
+
+// FNV-1a, 64-bit. Keys cache files by signature and checks their payload.
+inline uint64_t TopologySignatureHash(const void* data, size_t size, uint64_t h = 0xcbf29ce484222325ull) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+inline uint64_t TopologySignatureHash(const std::string& signature) {
+    return TopologySignatureHash(signature.data(), signature.size());
+}
+
+// <dir>/topology-<hash>.bin
+inline std::string TopologyCachePath(const std::string& dir, uint64_t signatureHash) {
+    char name[40];
+    snprintf(name, sizeof(name), "topology-%016llx.bin", static_cast<unsigned long long>(signatureHash));
+    if (dir.empty()) return name;
+    char last = dir.back();
+    return dir + (last == '/' || last == '\\' ? "" : "/") + name;
+}
+
+// --- Writing ---
+
+inline std::vector<uint8_t> SerializeTopologyCache(uint64_t signatureHash, const TopologySnapshot& snap) {
+    TopologyCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TOPOLOGY_CACHE_MAGIC, sizeof(h.magic));
+    h.version       = TOPOLOGY_CACHE_VERSION;
+    h.headerSize    = sizeof(h);
+    h.signatureHash = signatureHash;
+    h.monitorCount  = static_cast<uint32_t>(snap.monitors.size());
+    h.monitorOffset = sizeof(h);
+    h.portalCount   = static_cast<uint32_t>(snap.portals.size());
+    h.portalOffset  = h.monitorOffset + h.monitorCount * static_cast<uint32_t>(sizeof(CachedMonitor));
+    h.fileSize      = h.portalOffset + uint64_t{h.portalCount} * sizeof(CachedPortal);
+
+    std::vector<uint8_t> out(h.fileSize);
+    auto* mons = reinterpret_cast<CachedMonitor*>(out.data() + h.monitorOffset);
+    for (size_t i = 0; i < snap.monitors.size(); ++i) {
+        const Rect& r = snap.monitors[i];
+        mons[i] = {static_cast<int32_t>(r.left), static_cast<int32_t>(r.top), static_cast<int32_t>(r.right),
+                   static_cast<int32_t>(r.bottom)};
+    }
+    auto* portals = reinterpret_cast<CachedPortal*>(out.data() + h.portalOffset);
+    for (size_t i = 0; i < snap.portals.size(); ++i) {
+        const TopologyPortal& p = snap.portals[i];
+        portals[i] = {static_cast<uint16_t>(p.src), static_cast<uint16_t>(p.dst), static_cast<uint32_t>(p.edge),
+                      static_cast<int32_t>(p.overlapStart), static_cast<int32_t>(p.overlapEnd)};
+    }
+    h.checksum = TopologySignatureHash(out.data() + sizeof(h), out.size() - sizeof(h));
+    memcpy(out.data(), &h, sizeof(h));
+    return out;
+}
+
+// Writes a sibling temp file and renames it over `path`, so a reader never
+// maps a half-written file.
+inline bool WriteTopologyCache(const std::string& path, uint64_t signatureHash, const TopologySnapshot& snap) {
+    if (snap.monitors.empty() || snap.monitors.size() > TOPOLOGY_CACHE_MAX_MONITORS) return false;
+    std::vector<uint8_t> bytes = SerializeTopologyCache(signatureHash, snap);
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = fclose(f) == 0 && ok;
+#if defined(_WIN32)
+    ok = ok && MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    ok = ok && rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
+
+// --- Reading ---
+
+// Checks a mapped cache file against the live signature hash; why is set
+// on failure.
+inline bool ValidateTopologyCache(const uint8_t* data, uint64_t size, uint64_t signatureHash, const char** why) {
+    TopologyCacheHeader h;
+    if (size < sizeof(h)) {
+        *why = "truncated";
+        return false;
+    }
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, TOPOLOGY_CACHE_MAGIC, sizeof(h.magic)) != 0) {
+        *why = "not a topology cache";
+        return false;
+    }
+    if (h.version != TOPOLOGY_CACHE_VERSION || h.headerSize != sizeof(h)) {
+        *why = "unsupported cache version";
+        return false;
+    }
+    if (h.signatureHash != signatureHash) {
+        *why = "signature mismatch";
+        return false;
+    }
+    uint64_t monEnd    = uint64_t{h.monitorOffset} + uint64_t{h.monitorCount} * sizeof(CachedMonitor);
+    uint64_t portalEnd = uint64_t{h.portalOffset} + uint64_t{h.portalCount} * sizeof(CachedPortal);
+    if (h.fileSize != size || h.monitorCount == 0 || h.monitorCount > TOPOLOGY_CACHE_MAX_MONITORS ||
+        h.monitorOffset < sizeof(h) || h.portalOffset < monEnd || portalEnd > size ||
+        h.portalCount > h.monitorCount * h.monitorCount * 4 || h.monitorOffset % 4 || h.portalOffset % 4) {
+        *why = "bad table layout";
+        return false;
+    }
+    if (TopologySignatureHash(data + sizeof(h), size - sizeof(h)) != h.checksum) {
+        *why = "checksum mismatch";
+        return false;
+    }
+    const auto* mons = reinterpret_cast<const CachedMonitor*>(data + h.monitorOffset);
+    for (uint32_t i = 0; i < h.monitorCount; ++i) {
+        if (mons[i].right <= mons[i].left || mons[i].bottom <= mons[i].top) {
+            *why = "empty monitor rect";
+            return false;
+        }
+    }
+    const auto* portals = reinterpret_cast<const CachedPortal*>(data + h.portalOffset);
+    for (uint32_t i = 0; i < h.portalCount; ++i) {
+        const CachedPortal& p = portals[i];
+        if (p.src >= h.monitorCount || p.dst >= h.monitorCount || p.edge < static_cast<uint32_t>(Edge::Left) ||
+            p.edge > static_cast<uint32_t>(Edge::Bottom) || p.overlapEnd <= p.overlapStart) {
+            *why = "bad portal";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Snapshot for `signatureHash` from <dir>, or nullptr (why set) when there
+// is no usable file. The mapping is dropped once the tables are copied out.
+inline std::unique_ptr<TopologySnapshot> LoadTopologyCache(const std::string& dir, uint64_t signatureHash,
+                                                           const char** why) {
+    MappedFile file;
+    if (!file.Open(TopologyCachePath(dir, signatureHash))) {
+        *why = "no cache file";
+        return nullptr;
+    }
+    if (!ValidateTopologyCache(file.Data(), file.Size(), signatureHash, why)) return nullptr;
+
+    TopologyCacheHeader h;
+    memcpy(&h, file.Data(), sizeof(h));
+    auto snap = std::make_unique<TopologySnapshot>();
+    const auto* mons = reinterpret_cast<const CachedMonitor*>(file.Data() + h.monitorOffset);
+    snap->monitors.reserve(h.monitorCount);
+    for (uint32_t i = 0; i < h.monitorCount; ++i)
+        snap->monitors.push_back({mons[i].left, mons[i].top, mons[i].right, mons[i].bottom});
+    const auto* portals = reinterpret_cast<const CachedPortal*>(file.Data() + h.portalOffset);
+    snap->portals.reserve(h.portalCount);
+    for (uint32_t i = 0; i < h.portalCount; ++i) {
+        const CachedPortal& p = portals[i];
+        snap->portals.push_back({p.src, p.dst, static_cast<Edge>(p.edge), p.overlapStart, p.overlapEnd});
+    }
+    return snap;
+}
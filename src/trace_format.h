@@ -0,0 +1,130 @@
+#pragma once
+
+// On-disk motion trace: a 256-byte header carrying the monitor layout the
+// trace was recorded on, followed by fixed-size records (pointer position
+// as the OS reported it, before any remapping). Fixed-size records let
+// readers memory-map a file and split it at any record boundary.
+//
+// Integers are little-endian and fixed width, so traces move between
+// Windows (32-bit long) and Linux (64-bit long) unchanged.
+
+#include "mapping.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr char     TRACE_MAGIC[8]     = {'C', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+static constexpr uint32_t TRACE_VERSION      = 1;
+static constexpr size_t   TRACE_MAX_MONITORS = 8;
+
+struct TraceRect {
+    int32_t left, top, right, bottom;
+};
+
+struct TraceHeader {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  recordSize;    // sizeof(TraceRecord)
+    uint32_t  monitorCount;  // <= TRACE_MAX_MONITORS
+    uint32_t  reserved;
+    TraceRect monitors[TRACE_MAX_MONITORS];
+    uint8_t   pad[104];      // header is 256 bytes; records start after it
+};
+
+struct TraceRecord {
+    int32_t  x, y;
+    uint32_t time;   // ms, same clock as MotionSample::time
+    uint32_t flags;  // reserved, 0
+};
+
+static_assert(sizeof(TraceHeader) == 256, "trace header layout changed");
+static_assert(sizeof(TraceRecord) == 16, "trace record layout changed");
+
+inline TraceHeader MakeTraceHeader(const std::vector<Rect>& monitors) {
+    TraceHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version      = TRACE_VERSION;
+    h.recordSize   = sizeof(TraceRecord);
+    h.monitorCount = static_cast<uint32_t>(monitors.size() < TRACE_MAX_MONITORS ? monitors.size()
+                                                                                 : TRACE_MAX_MONITORS);
+    for (uint32_t i = 0; i < h.monitorCount; ++i) {
+        const Rect& r = monitors[i];
+        h.monitors[i] = {static_cast<int32_t>(r.left), static_cast<int32_t>(r.top),
+                         static_cast<int32_t>(r.right), static_cast<int32_t>(r.bottom)};
+    }
+    return h;
+}
+
+// Checks a header read from a file of fileSize bytes; why is set on failure.
+inline bool ValidateTraceHeader(const TraceHeader& h, uint64_t fileSize, const char** why) {
+    if (fileSize < sizeof(TraceHeader) || memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) != 0) {
+        *why = "not a cursor_mapper trace";
+        return false;
+    }
+    if (h.version != TRACE_VERSION || h.recordSize != sizeof(TraceRecord)) {
+        *why = "unsupported trace version";
+        return false;
+    }
+    if (h.monitorCount == 0 || h.monitorCount > TRACE_MAX_MONITORS) {
+        *why = "bad monitor count";
+        return false;
+    }
+    return true;
+}
+
+inline std::vector<Rect> TraceMonitors(const TraceHeader& h) {
+    std::vector<Rect> out;
+    for (uint32_t i = 0; i < h.monitorCount && i < TRACE_MAX_MONITORS; ++i)
+        out.push_back({h.monitors[i].left, h.monitors[i].top, h.monitors[i].right, h.monitors[i].bottom});
+    return out;
+}
+
+// Complete records in a file of fileSize bytes (a torn tail is ignored).
+inline uint64_t TraceRecordCount(uint64_t fileSize) {
+    return fileSize < sizeof(TraceHeader) ? 0 : (fileSize - sizeof(TraceHeader)) / sizeof(TraceRecord);
+}
+
+// Buffered sequential writer.
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter() { Close(); }
+
+    bool Open(const std::string& path, const std::vector<Rect>& monitors) {
+        Close();
+        file_ = fopen(path.c_str(), "wb");
+        if (!file_) return false;
+        TraceHeader h = MakeTraceHeader(monitors);
+        if (fwrite(&h, sizeof(h), 1, file_) != 1) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool Append(Point p, uint32_t time, uint32_t flags = 0) {
+        TraceRecord r{static_cast<int32_t>(p.x), static_cast<int32_t>(p.y), time, flags};
+        return file_ && fwrite(&r, sizeof(r), 1, file_) == 1;
+    }
+
+    bool AppendRecords(const TraceRecord* records, size_t count) {
+        return file_ && fwrite(records, sizeof(TraceRecord), count, file_) == count;
+    }
+
+    // Returns false if any buffered write failed.
+    bool Close() {
+        if (!file_) return true;
+        bool ok = fclose(file_) == 0;
+        file_ = nullptr;
+        return ok;
+    }
+
+private:
+    FILE* file_ = nullptr;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+// Human-like synthetic pointer motion for benchmarks and trace corpora.
+//
+// Movements are point-to-point with a minimum-jerk profile
+// (s = 10t^3 - 15t^4 + 6t^5) and Fitts'-law duration (a + b log2(D/W + 1)),
+// sampled at the polling rate, with Gaussian sensor jitter. Some movements
+// are flicks (fast, overshooting) and some aim past a monitor edge, so the
+// cursor parks against it or crosses to the neighbour. Reported positions
+// are clipped to the desktop the way the OS clips the cursor: a point in
+// no monitor is clamped into the monitor the cursor was on. Pauses between
+// movements advance time without producing samples.
+//
+// Output is cut into fixed-size chunks generated independently (and in
+// parallel) from (seed, chunk index). Each chunk starts at its own home
+// point, and its last movement runs to the next chunk's home point, so
+// chunks join without a jump. The same config and chunk size give the
+// same bytes for any thread count.
+
+#include "filter_chain.h"   // MotionSample
+#include "mapping.h"
+#include "trace_format.h"   // TraceRecord
+#include "work_stealing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct TrajectoryConfig {
+    std::vector<Rect> monitors;
+    double   pollHz      = 1000.0;  // 125 .. 8000
+    uint64_t seed        = 1;
+    double   fittsA      = 0.05;    // s
+    double   fittsB      = 0.12;    // s per bit
+    double   targetWidth = 32.0;    // px
+    double   jitterPx    = 0.35;    // sensor noise stddev
+    double   flickChance = 0.05;    // share of movements that are flicks
+    double   parkChance  = 0.15;    // share aimed past an edge of the current monitor
+    double   crossChance = 0.30;    // share of ordinary targets on another monitor
+    double   pauseMeanMs = 250.0;   // mean idle gap between movements
+};
+
+// xorshift64* with a splitmix64 seed: fast, deterministic, good enough for
+// motion noise.
+struct TrajectoryRng {
+    uint64_t s;
+
+    explicit TrajectoryRng(uint64_t seed) {
+        uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        s = (z ^ (z >> 31)) | 1;
+    }
+    uint64_t Next() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545f4914f6cdd1dull;
+    }
+    double Uniform() { return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0); }
+    // Two N(0, 1) approximations, each a rescaled sum of four 16-bit
+    // uniforms from one draw: close enough for jitter, and cheap.
+    void GaussianPair(double& a, double& b) {
+        a = Sum4(Next());
+        b = Sum4(Next());
+    }
+
+private:
+    static double Sum4(uint64_t r) {
+        uint64_t sum = (r & 0xffff) + ((r >> 16) & 0xffff) + ((r >> 32) & 0xffff) + (r >> 48);
+        return (static_cast<double>(sum) - 2.0 * 65535.0) * (1.7320508075688772 / 65536.0);
+    }
+};
+
+// Output adapters: the generator writes either replay input or trace records.
+inline void StoreSample(MotionSample& out, Point p, Point prev, uint32_t timeMs) {
+    out = {p, static_cast<double>(p.x - prev.x), static_cast<double>(p.y - prev.y), timeMs, 0};
+}
+inline void StoreSample(TraceRecord& out, Point p, Point, uint32_t timeMs) {
+    out = {static_cast<int32_t>(p.x), static_cast<int32_t>(p.y), timeMs, 0};
+}
+inline void ShiftTime(MotionSample& s, uint32_t ms) { s.time += ms; }
+inline void ShiftTime(TraceRecord& r, uint32_t ms) { r.time += ms; }
+
+class TrajectoryGenerator {
+public:
+    explicit TrajectoryGenerator(TrajectoryConfig cfg) : cfg_(std::move(cfg)) {
+        if (cfg_.monitors.empty()) cfg_.monitors.push_back({0, 0, 1920, 1080});
+        cfg_.pollHz = std::clamp(cfg_.pollHz, 1.0, 100000.0);
+    }
+
+    const TrajectoryConfig& Config() const { return cfg_; }
+
+    // Start of chunk k, inside a monitor chosen from the seed.
+    Point HomePoint(uint64_t chunk) const {
+        TrajectoryRng rng(cfg_.seed ^ (chunk * 0xd1b54a32d192ed03ull) ^ 0x5bd1e995ull);
+        const Rect& m = cfg_.monitors[rng.Next() % cfg_.monitors.size()];
+        return {m.left + static_cast<long>(rng.Uniform() * static_cast<double>(m.right - m.left - 1)),
+                m.top + static_cast<long>(rng.Uniform() * static_cast<double>(m.bottom - m.top - 1))};
+    }
+
+    // Fills out[0..n) with chunk `chunk`; times are ms from the chunk start.
+    // Returns the chunk's duration in whole ms (next chunk's time offset).
+    template <typename Out>
+    uint32_t GenerateChunk(uint64_t chunk, Out* out, size_t n) const {
+        TrajectoryRng rng(cfg_.seed * 0x9e3779b97f4a7c15ull + chunk);
+        const double dtMs = 1000.0 / cfg_.pollHz;
+        // Samples held back for the final movement to the next home point
+        const size_t reserve = std::max<size_t>(8, static_cast<size_t>(0.6 * cfg_.pollHz));
+
+        Point home = HomePoint(chunk);
+        State st{static_cast<double>(home.x), static_cast<double>(home.y), home,
+                 MonitorIndexFromPoint(cfg_.monitors.data(), cfg_.monitors.size(), home), 0.0};
+        size_t written = 0;
+        while (written < n) {
+            size_t remaining = n - written;
+            if (remaining <= reserve || remaining <= 1) {
+                Point next = HomePoint(chunk + 1);
+                written += Move(st, static_cast<double>(next.x), static_cast<double>(next.y), remaining,
+                                remaining, 0.0, rng, out + written);
+                break;
+            }
+            if (written) st.timeMs += -std::log(1.0 - rng.Uniform()) * cfg_.pauseMeanMs;
+
+            double tx, ty, overshoot = 1.0, bScale = 1.0;
+            double r = rng.Uniform();
+            const Rect& cur = cfg_.monitors[st.monitor >= 0 ? st.monitor : 0];
+            if (r < cfg_.flickChance) {
+                PickPoint(AnyMonitor(rng), rng, tx, ty);
+                overshoot = 1.04 + 0.08 * rng.Uniform();
+                bScale    = 0.5;
+            } else if (r < cfg_.flickChance + cfg_.parkChance) {
+                PickEdgeBeyond(cur, rng, tx, ty);
+            } else if (rng.Uniform() < cfg_.crossChance && cfg_.monitors.size() > 1) {
+                PickPoint(AnyMonitor(rng), rng, tx, ty);
+            } else {
+                PickPoint(cur, rng, tx, ty);
+            }
+            tx = st.x + (tx - st.x) * overshoot;
+            ty = st.y + (ty - st.y) * overshoot;
+
+            double dist = std::hypot(tx - st.x, ty - st.y);
+            double seconds = cfg_.fittsA + bScale * cfg_.fittsB * std::log2(dist / cfg_.targetWidth + 1.0);
+            size_t samples = std::max<size_t>(1, static_cast<size_t>(std::max(seconds, 0.02) * cfg_.pollHz));
+            // Cut short (not sped up) where it would eat into the reserve
+            written += Move(st, tx, ty, samples, std::min(samples, remaining - reserve), cfg_.jitterPx, rng,
+                            out + written);
+        }
+        return static_cast<uint32_t>(std::ceil(st.timeMs + dtMs));
+    }
+
+private:
+    struct State {
+        double x, y;     // cursor position with the sub-pixel remainder
+        Point  pos;      // last reported position
+        int    monitor;  // monitor the cursor is on
+        double timeMs;
+    };
+
+    const Rect& AnyMonitor(TrajectoryRng& rng) const { return cfg_.monitors[rng.Next() % cfg_.monitors.size()]; }
+
+    static void PickPoint(const Rect& m, TrajectoryRng& rng, double& x, double& y) {
+        double mx = std::min(40.0, (m.right - m.left) / 4.0), my = std::min(40.0, (m.bottom - m.top) / 4.0);
+        x = m.left + mx + rng.Uniform() * (m.right - m.left - 2 * mx);
+        y = m.top + my + rng.Uniform() * (m.bottom - m.top - 2 * my);
+    }
+
+    // A point 20..140 px past a random edge of m: the cursor ends up pinned
+    // to that edge, or crosses it where a neighbour shares the edge.
+    static void PickEdgeBeyond(const Rect& m, TrajectoryRng& rng, double& x, double& y) {
+        PickPoint(m, rng, x, y);
+        double past = 20.0 + 120.0 * rng.Uniform();
+        switch (rng.Next() & 3) {
+        case 0: x = m.left - past; break;
+        case 1: x = m.right - 1 + past; break;
+        case 2: y = m.top - past; break;
+        default: y = m.bottom - 1 + past; break;
+        }
+    }
+
+    // lround without the libm call: half away from zero
+    static long RoundPx(double v) {
+        long i = static_cast<long>(v);
+        double f = v - static_cast<double>(i);
+        return i + (f >= 0.5) - (f <= -0.5);
+    }
+
+    // Clip to the desktop like the OS: stay on the current monitor unless
+    // the point lies on another one. Motion into a gap or off the desktop
+    // is lost, so the next delta starts from the clamped position.
+    Point Clip(State& st) const {
+        Point p{RoundPx(st.x), RoundPx(st.y)};
+        if (st.monitor >= 0 && Contains(cfg_.monitors[st.monitor], p)) return p;
+        int idx = MonitorIndexFromPoint(cfg_.monitors.data(), cfg_.monitors.size(), p);
+        if (idx >= 0) {
+            st.monitor = idx;
+            return p;
+        }
+        const Rect& m = cfg_.monitors[st.monitor >= 0 ? st.monitor : 0];
+        p  = {std::clamp(p.x, m.left, m.right - 1), std::clamp(p.y, m.top, m.bottom - 1)};
+        st.x = static_cast<double>(p.x);
+        st.y = static_cast<double>(p.y);
+        return p;
+    }
+
+    // The first `count` samples of a `samples`-long movement to (tx, ty).
+    // Each step covers the minimum-jerk share of the distance still left,
+    // which is the plain profile when nothing interferes and steers back
+    // after jitter or a clamp; the last step lands on the target.
+    template <typename Out>
+    size_t Move(State& st, double tx, double ty, size_t samples, size_t count, double jitter,
+                TrajectoryRng& rng, Out* out) const {
+        const double dtMs = 1000.0 / cfg_.pollHz;
+        double inv = 1.0 / static_cast<double>(samples), prevS = 0.0;
+        for (size_t k = 1; k <= count; ++k) {
+            double t = static_cast<double>(k) * inv;
+            double s = k == samples ? 1.0 : t * t * t * (10.0 + t * (-15.0 + 6.0 * t));
+            double share = (s - prevS) / (1.0 - prevS);
+            prevS = s;
+            st.x += (tx - st.x) * share;
+            st.y += (ty - st.y) * share;
+            if (jitter > 0.0 && k < samples) {
+                double jx, jy;
+                rng.GaussianPair(jx, jy);
+                st.x += jx * jitter;
+                st.y += jy * jitter;
+            }
+            Point p = Clip(st);
+            st.timeMs += dtMs;
+            StoreSample(out[k - 1], p, st.pos, static_cast<uint32_t>(st.timeMs));
+            st.pos = p;
+        }
+        return count;
+    }
+
+    TrajectoryConfig cfg_;
+};
+
+// Generates chunks [firstChunk, firstChunk + chunks) of chunkSamples each
+// into out, on `threads` workers. timeOffsetMs is the absolute time of the
+// first chunk on entry and of the chunk after the last one on return, so a
+// long stream can be produced batch by batch.
+template <typename Out>
+inline void GenerateTrajectory(const TrajectoryGenerator& gen, uint64_t firstChunk, size_t chunks,
+                               size_t chunkSamples, Out* out, unsigned threads, uint32_t& timeOffsetMs) {
+    std::vector<uint32_t> durations(chunks);
+    ParallelFor(static_cast<uint32_t>(chunks), threads, [&](unsigned, uint32_t c) {
+        durations[c] = gen.GenerateChunk(firstChunk + c, out + c * chunkSamples, chunkSamples);
+    });
+    std::vector<uint32_t> offsets(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        offsets[c] = timeOffsetMs;
+        timeOffsetMs += durations[c];
+    }
+    ParallelFor(static_cast<uint32_t>(chunks), threads, [&](unsigned, uint32_t c) {
+        if (!offsets[c]) return;
+        Out* p = out + c * chunkSamples;
+        for (size_t i = 0; i < chunkSamples; ++i) ShiftTime(p[i], offsets[c]);
+    });
+}
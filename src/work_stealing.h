@@ -0,0 +1,110 @@
+#pragma once
+
+// Work-stealing parallel loop over task indices 0..count-1 for offline
+// tools. Each worker starts with a contiguous slice; it claims tasks from
+// the front of its own slice, and when that runs dry it steals the back
+// half of the fullest other slice. A slice is one 64-bit atomic
+// (begin | end << 32) changed only by CAS, so there are no locks and a
+// slow worker's remaining tasks spread over the idle ones.
+
+#include "spsc_queue.h"  // CACHE_LINE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class WorkStealingRanges {
+public:
+    WorkStealingRanges(uint32_t count, unsigned workers)
+        : slices_(new Slice[workers ? workers : 1]), workers_(workers ? workers : 1) {
+        for (unsigned w = 0; w < workers_; ++w) {
+            uint32_t b = static_cast<uint32_t>(uint64_t{count} * w / workers_);
+            uint32_t e = static_cast<uint32_t>(uint64_t{count} * (w + 1) / workers_);
+            slices_[w].range.store(Pack(b, e), std::memory_order_relaxed);
+        }
+    }
+
+    // Next task for worker w; false when every slice is empty.
+    bool Next(unsigned w, uint32_t& task) {
+        for (;;) {
+            if (PopFront(w, task)) return true;
+            if (!Steal(w)) return false;
+        }
+    }
+
+    uint64_t Steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(CACHE_LINE) Slice {
+        std::atomic<uint64_t> range{0};
+    };
+
+    static uint64_t Pack(uint32_t b, uint32_t e) { return uint64_t{b} | (uint64_t{e} << 32); }
+    static uint32_t Begin(uint64_t r) { return static_cast<uint32_t>(r); }
+    static uint32_t End(uint64_t r) { return static_cast<uint32_t>(r >> 32); }
+
+    bool PopFront(unsigned w, uint32_t& task) {
+        auto& range = slices_[w].range;
+        uint64_t r = range.load(std::memory_order_acquire);
+        while (Begin(r) < End(r)) {
+            if (range.compare_exchange_weak(r, Pack(Begin(r) + 1, End(r)), std::memory_order_acq_rel)) {
+                task = Begin(r);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the back half of the fullest other slice into w's (empty) slice.
+    // Nobody else writes an empty slice, so a plain store installs it.
+    bool Steal(unsigned w) {
+        for (;;) {
+            unsigned victim = workers_;
+            uint64_t vr = 0;
+            uint32_t most = 0;
+            for (unsigned i = 1; i < workers_; ++i) {
+                unsigned v = (w + i) % workers_;
+                uint64_t r = slices_[v].range.load(std::memory_order_acquire);
+                uint32_t n = End(r) > Begin(r) ? End(r) - Begin(r) : 0;
+                if (n > most) {
+                    most   = n;
+                    victim = v;
+                    vr     = r;
+                }
+            }
+            if (victim == workers_) return false;
+            uint32_t take = (most + 1) / 2;
+            uint32_t cut  = End(vr) - take;
+            if (slices_[victim].range.compare_exchange_strong(vr, Pack(Begin(vr), cut),
+                                                              std::memory_order_acq_rel)) {
+                slices_[w].range.store(Pack(cut, End(vr)), std::memory_order_release);
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    std::unique_ptr<Slice[]> slices_;
+    unsigned                 workers_;
+    std::atomic<uint64_t>    steals_{0};
+};
+
+// Runs fn(worker, task) for every task on `workers` threads (the caller's
+// thread is worker 0). Returns the number of steals.
+template <typename Fn>
+inline uint64_t ParallelFor(uint32_t count, unsigned workers, Fn&& fn) {
+    if (!workers) workers = 1;
+    WorkStealingRanges ranges(count, workers);
+    auto run = [&](unsigned w) {
+        uint32_t task;
+        while (ranges.Next(w, task)) fn(w, task);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; ++w) threads.emplace_back(run, w);
+    run(0);
+    for (auto& t : threads) t.join();
+    return ranges.Steals();
+}
@@ -0,0 +1,359 @@
+// Offline analysis of recorded motion traces. Files are memory-mapped and
+// cut into fixed-size shards that a work-stealing pool processes; each
+// worker accumulates into its own cache-line-aligned block and the blocks
+// are summed after the join, so the hot loop shares nothing.
+//
+// Per consecutive pair of records (the only state a crossing needs, so a
+// shard just peeks at the record before it):
+//   - crossings per src->dst portal, and how many the remap moved
+//   - where along the source edge crossings happen (5% bins per portal)
+//   - jump length before remap (from -> raw landing point) and after
+//     (from -> remapped landing point), log2 px buckets
+//   - events per active second (seconds with no events are not counted)
+//
+//   cursor_mapper_analyze [--threads=N] [--shard-records=N] [--scaling] FILE...
+
+#include "mapped_file.h"
+#include "mapping.h"
+#include "spsc_queue.h"  // CACHE_LINE
+#include "trace_format.h"
+#include "work_stealing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr size_t COORD_BINS   = 20;  // 5% each along the source edge
+static constexpr size_t JUMP_BUCKETS = 16;  // 0: <1 px, i: [2^(i-1), 2^i) px
+static constexpr size_t EPS_BUCKETS  = 16;  // i: [2^i, 2^(i+1)) events/s
+static constexpr size_t MON          = TRACE_MAX_MONITORS;
+
+struct alignas(CACHE_LINE) Accum {
+    uint64_t events = 0, offscreen = 0, crossings = 0, remapped = 0;
+    uint64_t portal[MON][MON] = {};
+    uint64_t portalRemapped[MON][MON] = {};
+    uint64_t coord[MON][MON][COORD_BINS] = {};
+    uint64_t jumpBefore[JUMP_BUCKETS] = {};
+    uint64_t jumpAfter[JUMP_BUCKETS] = {};
+    uint64_t eps[EPS_BUCKETS] = {};
+
+    void Merge(const Accum& o) {
+        events += o.events;
+        offscreen += o.offscreen;
+        crossings += o.crossings;
+        remapped += o.remapped;
+        for (size_t s = 0; s < MON; ++s) {
+            for (size_t d = 0; d < MON; ++d) {
+                portal[s][d] += o.portal[s][d];
+                portalRemapped[s][d] += o.portalRemapped[s][d];
+                for (size_t b = 0; b < COORD_BINS; ++b) coord[s][d][b] += o.coord[s][d][b];
+            }
+        }
+        for (size_t i = 0; i < JUMP_BUCKETS; ++i) {
+            jumpBefore[i] += o.jumpBefore[i];
+            jumpAfter[i] += o.jumpAfter[i];
+        }
+        for (size_t i = 0; i < EPS_BUCKETS; ++i) eps[i] += o.eps[i];
+    }
+
+    // Field bytes only; the alignment tail is not initialised
+    bool operator==(const Accum& o) const { return memcmp(this, &o, offsetof(Accum, eps) + sizeof(eps)) == 0; }
+};
+
+static size_t Log2Bucket(uint64_t v, size_t buckets) {
+    size_t b = 0;
+    while (v && b + 1 < buckets) {
+        v >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+static size_t JumpBucket(Point a, Point b) {
+    double dx = static_cast<double>(b.x - a.x), dy = static_cast<double>(b.y - a.y);
+    return Log2Bucket(static_cast<uint64_t>(std::sqrt(dx * dx + dy * dy)), JUMP_BUCKETS);
+}
+
+static void CountSecond(Accum& a, uint64_t events) {
+    if (events) ++a.eps[std::min(Log2Bucket(events, EPS_BUCKETS + 1) - 1, EPS_BUCKETS - 1)];
+}
+
+struct TraceFile {
+    std::string       path;
+    MappedFile        map;
+    std::vector<Rect> monitors;
+    const TraceRecord* records = nullptr;
+    uint64_t          count = 0;
+};
+
+struct Shard {
+    uint32_t file;
+    uint64_t begin, end;  // record range
+    // Seconds cut by the shard edges, stitched together after the join
+    uint64_t firstSec = 0, firstCount = 0, lastSec = 0, lastCount = 0;
+};
+
+static void AnalyseShard(const TraceFile& f, Shard& sh, Accum& a) {
+    const Rect* mons = f.monitors.data();
+    size_t monCount = f.monitors.size();
+    const TraceRecord* rec = f.records;
+
+    uint64_t i = sh.begin;
+    Point prev{0, 0};
+    int prevMon = -1;
+    if (i > 0) {
+        prev    = {rec[i - 1].x, rec[i - 1].y};
+        prevMon = MonitorIndexFromPoint(mons, monCount, prev);
+    }
+
+    uint64_t sec = rec[i].time / 1000, secCount = 0;
+    bool first = true;
+    for (; i < sh.end; ++i) {
+        Point pt{rec[i].x, rec[i].y};
+        uint64_t s = rec[i].time / 1000;
+        if (s != sec) {
+            if (first) {
+                sh.firstSec   = sec;
+                sh.firstCount = secCount;
+                first = false;
+            } else {
+                CountSecond(a, secCount);
+            }
+            sec = s;
+            secCount = 0;
+        }
+        ++secCount;
+        ++a.events;
+
+        int cur = MonitorIndexFromPoint(mons, monCount, pt);
+        if (cur < 0) {
+            ++a.offscreen;
+        } else if (prevMon >= 0 && cur != prevMon) {
+            ++a.crossings;
+            ++a.portal[prevMon][cur];
+            const Rect& src = mons[prevMon];
+            HitResult hit = FindExitEdge(prev, pt, src);
+            Point mapped = pt;
+            if (hit.edge != Edge::None) {
+                bool vertical = hit.edge == Edge::Left || hit.edge == Edge::Right;
+                double coord = vertical ? static_cast<double>(prev.y) : static_cast<double>(prev.x);
+                double lo = vertical ? static_cast<double>(src.top) : static_cast<double>(src.left);
+                double hi = vertical ? static_cast<double>(src.bottom) : static_cast<double>(src.right);
+                double frac = (coord - lo) / (hi - lo);
+                size_t bin = static_cast<size_t>(std::clamp(frac, 0.0, 0.999999) * COORD_BINS);
+                ++a.coord[prevMon][cur][bin];
+                Point out;
+                if (RemapCursor(src, mons[cur], hit.edge, coord, out) && out != pt) {
+                    mapped = out;
+                    ++a.remapped;
+                    ++a.portalRemapped[prevMon][cur];
+                }
+            }
+            ++a.jumpBefore[JumpBucket(prev, pt)];
+            ++a.jumpAfter[JumpBucket(prev, mapped)];
+        }
+        prev = pt;
+        prevMon = cur;
+    }
+    if (first) {
+        sh.firstSec = sh.lastSec = sec;
+        sh.firstCount = secCount;
+        sh.lastCount  = 0;
+    } else {
+        sh.lastSec   = sec;
+        sh.lastCount = secCount;
+    }
+}
+
+// Joins seconds split across shard edges; shards are in file order.
+static void StitchSeconds(const std::vector<Shard>& shards, Accum& total) {
+    bool have = false;
+    uint32_t file = 0;
+    uint64_t sec = 0, count = 0;
+    auto flush = [&] {
+        if (have) CountSecond(total, count);
+        have = false;
+    };
+    for (const Shard& sh : shards) {
+        if (sh.file != file) {
+            flush();
+            file = sh.file;
+        }
+        if (have && sec == sh.firstSec) {
+            count += sh.firstCount;
+        } else {
+            flush();
+            have  = true;
+            sec   = sh.firstSec;
+            count = sh.firstCount;
+        }
+        if (sh.lastCount) {
+            flush();
+            have  = true;
+            sec   = sh.lastSec;
+            count = sh.lastCount;
+        }
+    }
+    flush();
+}
+
+static double Run(std::vector<TraceFile>& files, std::vector<Shard> shards, unsigned threads,
+                  Accum& total, uint64_t& steals) {
+    std::unique_ptr<Accum[]> perThread(new Accum[threads]);
+    auto t0 = std::chrono::steady_clock::now();
+    steals = ParallelFor(static_cast<uint32_t>(shards.size()), threads, [&](unsigned w, uint32_t task) {
+        AnalyseShard(files[shards[task].file], shards[task], perThread[w]);
+    });
+    for (unsigned w = 0; w < threads; ++w) total.Merge(perThread[w]);
+    StitchSeconds(shards, total);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void PrintHistogram(const char* title, const uint64_t* h, size_t n, const char* (*label)(size_t)) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += h[i];
+    printf("%s\n", title);
+    if (!sum) {
+        printf("  (none)\n");
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!h[i]) continue;
+        double pct = 100.0 * static_cast<double>(h[i]) / static_cast<double>(sum);
+        printf("  %-14s %12llu %6.2f%% %.*s\n", label(i), static_cast<unsigned long long>(h[i]), pct,
+               static_cast<int>(pct / 2), "##################################################");
+    }
+}
+
+static const char* JumpLabel(size_t i) {
+    static char buf[48];
+    if (i == 0) snprintf(buf, sizeof(buf), "<1 px");
+    else if (i == 1) snprintf(buf, sizeof(buf), "1 px");
+    else snprintf(buf, sizeof(buf), "%llu-%llu px", 1ull << (i - 1), (1ull << i) - 1);
+    return buf;
+}
+
+static const char* EpsLabel(size_t i) {
+    static char buf[48];
+    snprintf(buf, sizeof(buf), "%llu-%llu/s", 1ull << i, (1ull << (i + 1)) - 1);
+    return buf;
+}
+
+static void PrintReport(const Accum& a) {
+    printf("events %llu, offscreen %llu, crossings %llu (%llu remapped)\n",
+           static_cast<unsigned long long>(a.events), static_cast<unsigned long long>(a.offscreen),
+           static_cast<unsigned long long>(a.crossings), static_cast<unsigned long long>(a.remapped));
+    printf("portals (src->dst: crossings, remapped, position along source edge in 5%% bins)\n");
+    for (size_t s = 0; s < MON; ++s) {
+        for (size_t d = 0; d < MON; ++d) {
+            if (!a.portal[s][d]) continue;
+            printf("  %zu->%zu %10llu %10llu  |", s, d, static_cast<unsigned long long>(a.portal[s][d]),
+                   static_cast<unsigned long long>(a.portalRemapped[s][d]));
+            uint64_t most = *std::max_element(a.coord[s][d], a.coord[s][d] + COORD_BINS);
+            for (size_t b = 0; b < COORD_BINS; ++b) {
+                // 0-9 scale per portal so the shape is visible at any count
+                uint64_t c = a.coord[s][d][b];
+                printf("%c", c == 0 ? '.' : static_cast<char>('0' + (most ? c * 9 / most : 0)));
+            }
+            printf("|\n");
+        }
+    }
+    PrintHistogram("jump before remap (from -> raw landing)", a.jumpBefore, JUMP_BUCKETS, JumpLabel);
+    PrintHistogram("jump after remap (from -> remapped landing)", a.jumpAfter, JUMP_BUCKETS, JumpLabel);
+    PrintHistogram("events per active second", a.eps, EPS_BUCKETS, EpsLabel);
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t shardRecords = uint64_t{1} << 20;  // 16 MiB of records
+    bool scaling = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(1u, static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10)));
+        } else if (strncmp(argv[i], "--shard-records=", 16) == 0) {
+            shardRecords = std::max<uint64_t>(1, strtoull(argv[i] + 16, nullptr, 10));
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+        } else if (argv[i][0] == '-') {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Usage: cursor_mapper_analyze [--threads=N] [--shard-records=N] [--scaling] FILE...\n");
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        printf("Usage: cursor_mapper_analyze [--threads=N] [--shard-records=N] [--scaling] FILE...\n");
+        return 1;
+    }
+
+    std::vector<TraceFile> files;
+    std::vector<Shard> shards;
+    uint64_t bytes = 0;
+    for (const auto& path : paths) {
+        TraceFile f;
+        f.path = path;
+        const char* why = "cannot open";
+        if (!f.map.Open(path) || f.map.Size() < sizeof(TraceHeader) ||
+            !ValidateTraceHeader(*reinterpret_cast<const TraceHeader*>(f.map.Data()), f.map.Size(), &why)) {
+            printf("Skipping %s: %s\n", path.c_str(), why);
+            continue;
+        }
+        const auto& h = *reinterpret_cast<const TraceHeader*>(f.map.Data());
+        f.monitors = TraceMonitors(h);
+        f.records  = reinterpret_cast<const TraceRecord*>(f.map.Data() + sizeof(TraceHeader));
+        f.count    = TraceRecordCount(f.map.Size());
+        bytes += f.count * sizeof(TraceRecord);
+        uint32_t index = static_cast<uint32_t>(files.size());
+        for (uint64_t b = 0; b < f.count; b += shardRecords)
+            shards.push_back({index, b, std::min(f.count, b + shardRecords)});
+        files.push_back(std::move(f));
+    }
+    if (shards.empty()) {
+        printf("No records to analyse.\n");
+        return 1;
+    }
+
+    double gb = static_cast<double>(bytes) / 1e9;
+    printf("%zu file(s), %zu shard(s), %.3f GB of records\n", files.size(), shards.size(), gb);
+
+    Accum result;
+    uint64_t steals = 0;
+    if (scaling) {
+        // Warm the page cache so the first row is not an I/O measurement
+        Accum warm;
+        Run(files, shards, threads, warm, steals);
+        double base = 0.0;
+        bool identical = true;
+        printf("  %8s %10s %10s %10s %8s\n", "threads", "seconds", "GB/s", "speedup", "steals");
+        for (unsigned t = 1;; t = std::min(t * 2, threads)) {
+            Accum a;
+            double sec = Run(files, shards, t, a, steals);
+            if (t == 1) base = sec;
+            identical = identical && a == warm;
+            printf("  %8u %10.3f %10.2f %10.2f %8llu\n", t, sec, gb / sec, base / sec,
+                   static_cast<unsigned long long>(steals));
+            if (t == threads) break;
+        }
+        if (!identical) {
+            printf("Results differ between thread counts.\n");
+            return 1;
+        }
+        result.Merge(warm);
+    } else {
+        double sec = Run(files, shards, threads, result, steals);
+        printf("%u thread(s): %.3f s, %.2f GB/s, %.1f M events/s, %llu steals\n", threads, sec, gb / sec,
+               static_cast<double>(result.events) / sec / 1e6, static_cast<unsigned long long>(steals));
+    }
+    PrintReport(result);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Turns a layout description into a header with a constexpr layout for
+// BakedTopology (baked_topology.h). The description is what
+// `cursor_mapper --print-layout` prints on the target seat:
+//
+//   # comment
+//   signature 0123456789abcdef    (optional; omit to match on rects only)
+//   monitor LEFT TOP RIGHT BOTTOM (one per monitor, in published order)
+//
+//   cursor_mapper_bake --layout=FILE --out=HEADER [--name=IDENT]
+
+#include "baked_topology.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char* USAGE = "Usage: cursor_mapper_bake --layout=FILE --out=HEADER [--name=IDENT]\n";
+
+static bool IsIdentifier(const std::string& s) {
+    if (s.empty() || isdigit(static_cast<unsigned char>(s[0]))) return false;
+    for (char c : s)
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+    return true;
+}
+
+// Reads the description; prints the offending line and returns false on error.
+static bool ReadLayout(const std::string& path, std::vector<Rect>& mons, uint64_t& signatureHash) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        printf("Cannot open %s\n", path.c_str());
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        ++lineNo;
+        char* p = line;
+        while (isspace(static_cast<unsigned char>(*p))) ++p;
+        if (*p == '\0' || *p == '#') continue;
+        long l, t, r, b;
+        unsigned long long hash;
+        if (sscanf(p, "monitor %ld %ld %ld %ld", &l, &t, &r, &b) == 4 && r > l && b > t) {
+            mons.push_back({l, t, r, b});
+        } else if (sscanf(p, "signature %llx", &hash) == 1) {
+            signatureHash = hash;
+        } else {
+            printf("%s:%d: bad line: %s", path.c_str(), lineNo, line);
+            ok = false;
+        }
+    }
+    fclose(f);
+    if (ok && (mons.empty() || mons.size() > BAKED_MAX_MONITORS)) {
+        printf("%s: need 1..%zu monitors, got %zu\n", path.c_str(), BAKED_MAX_MONITORS, mons.size());
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::string layout, out, name = "BakedLayout";
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--layout=", 9) == 0) {
+            layout = argv[i] + 9;
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out = argv[i] + 6;
+        } else if (strncmp(argv[i], "--name=", 7) == 0) {
+            name = argv[i] + 7;
+        } else {
+            printf("Unknown option: %s\n%s", argv[i], USAGE);
+            return 1;
+        }
+    }
+    if (layout.empty() || out.empty()) {
+        printf("%s", USAGE);
+        return 1;
+    }
+    if (!IsIdentifier(name)) {
+        printf("Not an identifier: %s\n", name.c_str());
+        return 1;
+    }
+
+    std::vector<Rect> mons;
+    uint64_t signatureHash = 0;
+    if (!ReadLayout(layout, mons, signatureHash)) return 1;
+
+    FILE* f = fopen(out.c_str(), "w");
+    if (!f) {
+        printf("Cannot create %s\n", out.c_str());
+        return 1;
+    }
+    fprintf(f, "#pragma once\n\n// Generated by cursor_mapper_bake from %s; do not edit.\n\n", layout.c_str());
+    fprintf(f, "#include \"baked_topology.h\"\n\n");
+    fprintf(f, "struct %s {\n", name.c_str());
+    fprintf(f, "    static constexpr uint64_t SIGNATURE_HASH = 0x%016llxull;%s\n",
+            static_cast<unsigned long long>(signatureHash), signatureHash ? "" : "  // rects only");
+    fprintf(f, "    static constexpr Rect MONITORS[] = {\n");
+    for (const Rect& r : mons) fprintf(f, "        {%ld, %ld, %ld, %ld},\n", r.left, r.top, r.right, r.bottom);
+    fprintf(f, "    };\n};\n");
+    if (fclose(f) != 0) {
+        printf("Failed to write %s\n", out.c_str());
+        return 1;
+    }
+    printf("%s: %zu monitor(s)%s -> %s\n", name.c_str(), mons.size(), signatureHash ? ", signature checked" : "",
+           out.c_str());
+    return 0;
+}
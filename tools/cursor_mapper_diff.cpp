@@ -0,0 +1,129 @@
+// Differential validation of the mapping primitives: random and
+// adversarial inputs (differential.h) go through every implementation in
+// DIFF_VARIANTS and the frozen reference, on a work-stealing pool. Inputs
+// are numbered and generated from (seed, target, block), so "first
+// divergence" means the lowest-numbered failing input whatever the thread
+// count, and a run is reproducible from its seed. The first divergence per
+// target is shrunk to a minimal input before it is printed. Exit code 1 on
+// any divergence.
+//
+//   cursor_mapper_diff [--cases=N] [--threads=N] [--seed=N] [--target=NAME]
+
+#include "differential.h"
+#include "spsc_queue.h"  // CACHE_LINE
+#include "work_stealing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr uint64_t BLOCK_CASES = 1 << 14;
+static constexpr uint64_t NO_FAILURE  = ~uint64_t{0};
+
+static const char* USAGE =
+    "Usage: cursor_mapper_diff [--cases=N] [--threads=N] [--seed=N] [--target=monitor|exit|remap|crossing]\n";
+
+struct Failure {
+    uint64_t index   = NO_FAILURE;
+    size_t   variant = 0;
+};
+
+// Lowest failing input of one target, or NO_FAILURE.
+static Failure RunTarget(DiffTarget target, uint64_t cases, unsigned threads, uint64_t seed) {
+    uint64_t blocks = (cases + BLOCK_CASES - 1) / BLOCK_CASES;
+    std::vector<Failure> perBlock(blocks);
+    // Blocks past a known failure cannot hold the first one
+    std::atomic<uint64_t> firstBlock{NO_FAILURE};
+    ParallelFor(static_cast<uint32_t>(blocks), threads, [&](unsigned, uint32_t block) {
+        if (block > firstBlock.load(std::memory_order_relaxed)) return;
+        TrajectoryRng rng(seed ^ (static_cast<uint64_t>(target) << 56) ^ (uint64_t{block} * 0x9e3779b97f4a7c15ull));
+        uint64_t begin = uint64_t{block} * BLOCK_CASES, end = std::min(cases, begin + BLOCK_CASES);
+        DiffInput in;
+        for (uint64_t i = begin; i < end; ++i) {
+            GenerateDiffInput(target, rng, in);
+            for (size_t v = 0; v < std::size(DIFF_VARIANTS); ++v) {
+                if (DIFF_VARIANTS[v].target != target || DIFF_VARIANTS[v].same(in, nullptr)) continue;
+                perBlock[block] = {i, v};
+                uint64_t cur = firstBlock.load(std::memory_order_relaxed);
+                while (block < cur && !firstBlock.compare_exchange_weak(cur, block, std::memory_order_relaxed)) {
+                }
+                return;
+            }
+        }
+    });
+    uint64_t b = firstBlock.load();
+    return b == NO_FAILURE ? Failure{} : perBlock[b];
+}
+
+// Regenerates input `index` of a target (same stream as RunTarget).
+static DiffInput Regenerate(DiffTarget target, uint64_t index, uint64_t seed) {
+    uint64_t block = index / BLOCK_CASES;
+    TrajectoryRng rng(seed ^ (static_cast<uint64_t>(target) << 56) ^ (block * 0x9e3779b97f4a7c15ull));
+    DiffInput in;
+    for (uint64_t i = block * BLOCK_CASES; i <= index; ++i) GenerateDiffInput(target, rng, in);
+    return in;
+}
+
+int main(int argc, char** argv) {
+    uint64_t cases = 10000000, seed = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int only = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--cases=", 8) == 0) {
+            cases = std::max<uint64_t>(1, strtoull(argv[i] + 8, nullptr, 10));
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(1u, static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10)));
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--target=", 9) == 0) {
+            for (int t = 0; t < static_cast<int>(DiffTarget::Count); ++t)
+                if (strcmp(argv[i] + 9, DiffTargetName(static_cast<DiffTarget>(t))) == 0) only = t;
+            if (only < 0) {
+                printf("Unknown target: %s\n%s", argv[i] + 9, USAGE);
+                return 1;
+            }
+        } else {
+            printf("Unknown option: %s\n%s", argv[i], USAGE);
+            return 1;
+        }
+    }
+
+    printf("differential check: %llu inputs per target, %u thread(s), seed %llu\n",
+           static_cast<unsigned long long>(cases), threads, static_cast<unsigned long long>(seed));
+    bool clean = true;
+    for (int t = 0; t < static_cast<int>(DiffTarget::Count); ++t) {
+        if (only >= 0 && t != only) continue;
+        DiffTarget target = static_cast<DiffTarget>(t);
+        size_t variants = 0;
+        for (const auto& v : DIFF_VARIANTS) variants += v.target == target;
+
+        auto t0 = std::chrono::steady_clock::now();
+        Failure f = RunTarget(target, cases, threads, seed);
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (f.index == NO_FAILURE) {
+            printf("  %-9s %zu variant(s) match the reference  %.1f M inputs/s\n", DiffTargetName(target),
+                   variants, cases / s / 1e6);
+            continue;
+        }
+
+        clean = false;
+        const DiffVariant& v = DIFF_VARIANTS[f.variant];
+        DiffInput original = Regenerate(target, f.index, seed);
+        DiffInput minimal  = ShrinkDiffInput(original, v.same);
+        std::string detail;
+        v.same(minimal, &detail);
+        printf("  %-9s %s diverges at input %llu\n", DiffTargetName(target), v.name,
+               static_cast<unsigned long long>(f.index));
+        printf("    minimal:  %s\n", DiffInputText(minimal).c_str());
+        printf("              %s\n", detail.c_str());
+        printf("    original: %s\n", DiffInputText(original).c_str());
+    }
+    return clean ? 0 : 1;
+}
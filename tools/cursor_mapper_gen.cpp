@@ -0,0 +1,108 @@
+// Writes a synthetic motion trace (see trajectory.h) for benchmarks and
+// for cursor_mapper_analyze. Samples are generated in parallel, batch by
+// batch, and appended to the file; the output depends only on the options,
+// not on --threads.
+//
+//   cursor_mapper_gen --out=FILE [--samples=N] [--rate=HZ] [--seed=N]
+//                     [--monitor=L,T,R,B]... [--threads=N] [--chunk=N]
+
+#include "trace_format.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* USAGE =
+    "Usage: cursor_mapper_gen --out=FILE [--samples=N] [--rate=HZ] [--seed=N]\n"
+    "                         [--monitor=L,T,R,B]... [--threads=N] [--chunk=N]\n";
+
+static double SecondsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    TrajectoryConfig cfg;
+    std::string out;
+    uint64_t samples = 100000000;
+    size_t chunk = size_t{1} << 16;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--out=", 6) == 0) {
+            out = argv[i] + 6;
+        } else if (strncmp(argv[i], "--samples=", 10) == 0) {
+            samples = std::max<uint64_t>(1, strtoull(argv[i] + 10, nullptr, 10));
+        } else if (strncmp(argv[i], "--rate=", 7) == 0) {
+            cfg.pollHz = std::clamp(atof(argv[i] + 7), 125.0, 8000.0);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            cfg.seed = strtoull(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--monitor=", 10) == 0) {
+            long l, t, r, b;
+            if (sscanf(argv[i] + 10, "%ld,%ld,%ld,%ld", &l, &t, &r, &b) != 4 || r <= l || b <= t) {
+                printf("Bad monitor: %s\n", argv[i] + 10);
+                return 1;
+            }
+            cfg.monitors.push_back({l, t, r, b});
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(1u, static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10)));
+        } else if (strncmp(argv[i], "--chunk=", 8) == 0) {
+            chunk = std::max<size_t>(64, strtoull(argv[i] + 8, nullptr, 10));
+        } else {
+            printf("Unknown option: %s\n%s", argv[i], USAGE);
+            return 1;
+        }
+    }
+    if (out.empty()) {
+        printf("%s", USAGE);
+        return 1;
+    }
+    if (cfg.monitors.empty()) cfg.monitors = {{0, 0, 2560, 1440}, {2560, 200, 4480, 1280}, {-1920, 0, 0, 1080}};
+    if (cfg.monitors.size() > TRACE_MAX_MONITORS) {
+        printf("At most %zu monitors.\n", TRACE_MAX_MONITORS);
+        return 1;
+    }
+
+    TrajectoryGenerator gen(cfg);
+    TraceWriter writer;
+    if (!writer.Open(out, cfg.monitors)) {
+        printf("Cannot create %s\n", out.c_str());
+        return 1;
+    }
+
+    // Batches of whole chunks; the last chunk is cut short at --samples
+    const size_t batchChunks = std::max<size_t>(1, (size_t{64} << 20) / sizeof(TraceRecord) / chunk);
+    const uint64_t chunks = (samples + chunk - 1) / chunk;
+    std::unique_ptr<TraceRecord[]> buf(new TraceRecord[batchChunks * chunk]);
+    uint32_t timeMs = 0;
+    double genSeconds = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < chunks; first += batchChunks) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(batchChunks, chunks - first));
+        auto g0 = std::chrono::steady_clock::now();
+        GenerateTrajectory(gen, first, n, chunk, buf.get(), threads, timeMs);
+        genSeconds += SecondsSince(g0);
+        size_t records = static_cast<size_t>(std::min<uint64_t>(n * chunk, samples - first * chunk));
+        if (!writer.AppendRecords(buf.get(), records)) {
+            printf("Write to %s failed\n", out.c_str());
+            return 1;
+        }
+    }
+    if (!writer.Close()) {
+        printf("Write to %s failed\n", out.c_str());
+        return 1;
+    }
+    double total = SecondsSince(t0);
+
+    printf("%llu samples at %.0f Hz over %zu monitor(s), %.1f s of motion, seed %llu\n",
+           static_cast<unsigned long long>(samples), cfg.pollHz, cfg.monitors.size(), timeMs / 1000.0,
+           static_cast<unsigned long long>(cfg.seed));
+    printf("generate: %.1f M samples/s on %u thread(s); total with write: %.1f M samples/s\n",
+           samples / genSeconds / 1e6, threads, samples / total / 1e6);
+    return 0;
+}
@@ -0,0 +1,516 @@
+// Searches monitor arrangements for the one that best fits the user's real
+// movements. Traces recorded on one layout (cursor_mapper_gen or the hook's
+// recorder) are replayed once, in parallel shards as in
+// cursor_mapper_analyze. Each crossing is kept in source-monitor
+// coordinates with its exit edge, from a batch exit-edge pass per shard.
+// Identical crossings are merged with a weight.
+//
+// Arrangements: monitor 0 (or the one at the origin) stays put, and every
+// other monitor hangs off the neighbour it is crossed to most, on the same
+// side as recorded. What varies is each monitor's offset along that shared
+// edge, so siblings on one side can also swap order. Overlapping candidates
+// are rejected.
+//
+// The cost of a candidate is summed over the recorded crossings:
+//   remap distance: how far the percentage mapping moves the landing point
+//   jump:           exit point -> final landing point
+//   miss:           straight continuation no longer reaches the monitor the
+//                   user was heading for (--miss-cost each)
+// Distances are in mm when every monitor's --size is given, px otherwise.
+// Candidates are scored in parallel blocks on a work-stealing pool, over a
+// coarse grid first and then finer grids around the best.
+//
+//   cursor_mapper_layout [--size=W_MM,H_MM]... [--budget=N] [--miss-cost=X]
+//                        [--min-overlap=PX] [--threads=N] [--out=FILE] FILE...
+
+#include "mapped_file.h"
+#include "mapping.h"
+#include "spsc_queue.h"  // CACHE_LINE
+#include "topology.h"
+#include "trace_format.h"
+#include "work_stealing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* USAGE =
+    "Usage: cursor_mapper_layout [--size=W_MM,H_MM]... [--budget=N] [--miss-cost=X]\n"
+    "                            [--min-overlap=PX] [--threads=N] [--out=FILE] FILE...\n";
+
+static constexpr size_t   MON           = TRACE_MAX_MONITORS;
+static constexpr uint64_t SHARD_RECORDS = uint64_t{1} << 20;
+static constexpr uint32_t BLOCK         = 256;  // candidates per parallel task
+
+// One crossing, relative to the source monitor's top-left corner
+struct Crossing {
+    uint8_t  src, dst;
+    Edge     edge;
+    int32_t  fromX, fromY, toX, toY;
+    uint32_t weight;
+
+    bool SameMotion(const Crossing& o) const {
+        return src == o.src && dst == o.dst && fromX == o.fromX && fromY == o.fromY && toX == o.toX && toY == o.toY;
+    }
+    bool operator<(const Crossing& o) const {
+        if (src != o.src) return src < o.src;
+        if (dst != o.dst) return dst < o.dst;
+        if (fromX != o.fromX) return fromX < o.fromX;
+        if (fromY != o.fromY) return fromY < o.fromY;
+        if (toX != o.toX) return toX < o.toX;
+        return toY < o.toY;
+    }
+};
+
+struct TraceFile {
+    MappedFile         map;
+    const TraceRecord* records = nullptr;
+    uint64_t           count = 0;
+};
+
+// --- Replay: crossings out of the traces ---
+
+struct RawCrossing {
+    Point from, to;
+    int   src, dst;
+};
+
+// Batch exit-edge pass: one tight loop over a shard's crossings, with the
+// source rects already resolved.
+static void ExitEdges(const RawCrossing* raw, size_t n, const Rect* mons, Edge* out) {
+    for (size_t i = 0; i < n; ++i) out[i] = FindExitEdge(raw[i].from, raw[i].to, mons[raw[i].src]).edge;
+}
+
+static void ReplayShard(const TraceFile& f, uint64_t begin, uint64_t end, const std::vector<Rect>& mons,
+                        std::vector<Crossing>& out) {
+    const TraceRecord* rec = f.records;
+    std::vector<RawCrossing> raw;
+    Point prev{0, 0};
+    int prevMon = -1;
+    if (begin > 0) {
+        prev    = {rec[begin - 1].x, rec[begin - 1].y};
+        prevMon = MonitorIndexFromPoint(mons.data(), mons.size(), prev);
+    }
+    for (uint64_t i = begin; i < end; ++i) {
+        Point pt{rec[i].x, rec[i].y};
+        int cur = MonitorIndexFromPoint(mons.data(), mons.size(), pt);
+        if (cur >= 0 && prevMon >= 0 && cur != prevMon) raw.push_back({prev, pt, prevMon, cur});
+        prev    = pt;
+        prevMon = cur;
+    }
+    std::vector<Edge> edges(raw.size());
+    ExitEdges(raw.data(), raw.size(), mons.data(), edges.data());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (edges[i] == Edge::None) continue;
+        const Rect& s = mons[raw[i].src];
+        out.push_back({static_cast<uint8_t>(raw[i].src), static_cast<uint8_t>(raw[i].dst), edges[i],
+                       static_cast<int32_t>(raw[i].from.x - s.left), static_cast<int32_t>(raw[i].from.y - s.top),
+                       static_cast<int32_t>(raw[i].to.x - s.left), static_cast<int32_t>(raw[i].to.y - s.top), 1});
+    }
+}
+
+static std::vector<Crossing> Merge(std::vector<Crossing> all) {
+    std::sort(all.begin(), all.end());
+    std::vector<Crossing> out;
+    for (const Crossing& c : all) {
+        if (!out.empty() && out.back().SameMotion(c)) out.back().weight += c.weight;
+        else out.push_back(c);
+    }
+    return out;
+}
+
+// --- Arrangements ---
+
+// mon sits on `side` of parent; offset = its start along that side minus
+// the parent's, within [lo, hi] so the shared edge keeps minOverlap px.
+struct Attachment {
+    int  mon, parent;
+    Edge side;
+    long lo, hi, recorded;
+};
+
+struct Layout {
+    std::vector<long> w, h;  // px
+    int               root = 0;
+    Point             rootOrigin{0, 0};
+    std::vector<Attachment> attach;  // parents before children
+    std::vector<int>  fixedMons;     // not reachable through portals; stay put
+    std::vector<Point> fixedOrigin;
+};
+
+// Heaviest-first spanning tree over the recorded portals (Prim), weighted
+// by crossings in either direction.
+static Layout BuildLayout(const std::vector<Rect>& mons, const std::vector<Crossing>& crossings, long minOverlap) {
+    size_t n = mons.size();
+    Layout L;
+    for (const Rect& r : mons) {
+        L.w.push_back(r.right - r.left);
+        L.h.push_back(r.bottom - r.top);
+    }
+    int origin = MonitorIndexFromPoint(mons.data(), n, {0, 0});
+    L.root       = origin >= 0 ? origin : 0;
+    L.rootOrigin = {mons[L.root].left, mons[L.root].top};
+
+    uint64_t traffic[MON][MON] = {};
+    for (const Crossing& c : crossings) {
+        traffic[c.src][c.dst] += c.weight;
+        traffic[c.dst][c.src] += c.weight;
+    }
+    std::vector<TopologyPortal> portals = BuildPortals(mons);
+    std::vector<bool> placed(n, false);
+    placed[L.root] = true;
+    for (;;) {
+        const TopologyPortal* best = nullptr;
+        for (const TopologyPortal& p : portals) {
+            if (!placed[p.src] || placed[p.dst]) continue;
+            if (!best || traffic[p.src][p.dst] > traffic[best->src][best->dst]) best = &p;
+        }
+        if (!best) break;
+        const Rect& par = mons[best->src];
+        const Rect& ch  = mons[best->dst];
+        bool vertical = best->edge == Edge::Left || best->edge == Edge::Right;
+        long parLen = vertical ? par.bottom - par.top : par.right - par.left;
+        long chLen  = vertical ? ch.bottom - ch.top : ch.right - ch.left;
+        long ov     = std::min({minOverlap, parLen, chLen});
+        long rec    = vertical ? ch.top - par.top : ch.left - par.left;
+        L.attach.push_back({best->dst, best->src, best->edge, -(chLen - ov), parLen - ov, rec});
+        placed[best->dst] = true;
+    }
+    for (size_t m = 0; m < n; ++m) {
+        if (placed[m]) continue;
+        L.fixedMons.push_back(static_cast<int>(m));
+        L.fixedOrigin.push_back({mons[m].left, mons[m].top});
+    }
+    return L;
+}
+
+// Rects for one choice of offsets (one per attachment).
+static void Place(const Layout& L, const long* offsets, Rect* out) {
+    auto set = [&](int m, long x, long y) { out[m] = {x, y, x + L.w[m], y + L.h[m]}; };
+    set(L.root, L.rootOrigin.x, L.rootOrigin.y);
+    for (size_t i = 0; i < L.fixedMons.size(); ++i) set(L.fixedMons[i], L.fixedOrigin[i].x, L.fixedOrigin[i].y);
+    for (size_t i = 0; i < L.attach.size(); ++i) {
+        const Attachment& a = L.attach[i];
+        const Rect& p = out[a.parent];
+        switch (a.side) {
+        case Edge::Left:   set(a.mon, p.left - L.w[a.mon], p.top + offsets[i]);   break;
+        case Edge::Right:  set(a.mon, p.right, p.top + offsets[i]);               break;
+        case Edge::Top:    set(a.mon, p.left + offsets[i], p.top - L.h[a.mon]);   break;
+        default:           set(a.mon, p.left + offsets[i], p.bottom);             break;
+        }
+    }
+}
+
+static bool Overlaps(const Rect* r, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = i + 1; j < n; ++j)
+            if (r[i].left < r[j].right && r[j].left < r[i].right && r[i].top < r[j].bottom && r[j].top < r[i].bottom)
+                return true;
+    return false;
+}
+
+// --- Cost ---
+
+struct Score {
+    double   remap = 0.0, jump = 0.0, total = 0.0;
+    uint64_t misses = 0;
+};
+
+struct CostModel {
+    std::vector<double> pitchX, pitchY;  // mm (or 1) per px, per monitor
+    double missCost = 500.0;
+};
+
+static Score Evaluate(const Rect* rects, size_t n, const std::vector<Crossing>& crossings, const CostModel& cm) {
+    Score s;
+    if (Overlaps(rects, n)) {
+        s.total = std::numeric_limits<double>::infinity();
+        return s;
+    }
+    for (const Crossing& c : crossings) {
+        const Rect& src = rects[c.src];
+        const Rect& dst = rects[c.dst];
+        Point from{src.left + c.fromX, src.top + c.fromY};
+        Point to{src.left + c.toX, src.top + c.toY};
+        if (!Contains(dst, to)) {
+            s.misses += c.weight;
+            continue;
+        }
+        bool vertical = c.edge == Edge::Left || c.edge == Edge::Right;
+        Point landing = to;
+        RemapCursor(src, dst, c.edge, static_cast<double>(vertical ? from.y : from.x), landing);
+        double w  = static_cast<double>(c.weight);
+        double rx = static_cast<double>(landing.x - to.x) * cm.pitchX[c.dst];
+        double ry = static_cast<double>(landing.y - to.y) * cm.pitchY[c.dst];
+        double jx = static_cast<double>(landing.x - from.x) * 0.5 * (cm.pitchX[c.src] + cm.pitchX[c.dst]);
+        double jy = static_cast<double>(landing.y - from.y) * 0.5 * (cm.pitchY[c.src] + cm.pitchY[c.dst]);
+        s.remap += w * std::sqrt(rx * rx + ry * ry);
+        s.jump  += w * std::sqrt(jx * jx + jy * jy);
+    }
+    s.total = s.remap + s.jump + cm.missCost * static_cast<double>(s.misses);
+    return s;
+}
+
+// --- Search ---
+
+// Offsets to try per attachment; candidate k picks one from each list in
+// mixed radix (the first attachment varies fastest).
+struct Grid {
+    std::vector<std::vector<long>> values;
+
+    uint64_t Size() const {
+        uint64_t n = 1;
+        for (const auto& v : values) n *= v.size();
+        return n;
+    }
+    void Pick(uint64_t k, long* offsets) const {
+        for (size_t i = 0; i < values.size(); ++i) {
+            offsets[i] = values[i][k % values[i].size()];
+            k /= values[i].size();
+        }
+    }
+};
+
+// Offsets center + j*step within [lo, hi] for |j| <= reach
+static std::vector<long> Around(long center, long step, long reach, long lo, long hi) {
+    std::vector<long> v;
+    for (long j = -reach; j <= reach; ++j) {
+        long o = center + j * step;
+        if (o >= lo && o <= hi) v.push_back(o);
+    }
+    if (v.empty()) v.push_back(std::clamp(center, lo, hi));
+    return v;
+}
+
+struct alignas(CACHE_LINE) WorkerBest {
+    double   cost  = std::numeric_limits<double>::infinity();
+    uint64_t index = 0;
+};
+
+// Best candidate of the grid (lowest index among equal costs, so the
+// result does not depend on the thread count).
+static uint64_t SearchGrid(const Grid& grid, const Layout& L, const std::vector<Crossing>& crossings,
+                           const CostModel& cm, unsigned threads, double& bestCost) {
+    uint64_t size = grid.Size();
+    size_t n = L.w.size();
+    std::unique_ptr<WorkerBest[]> best(new WorkerBest[threads]);
+    uint32_t tasks = static_cast<uint32_t>((size + BLOCK - 1) / BLOCK);
+    ParallelFor(tasks, threads, [&](unsigned w, uint32_t task) {
+        long offsets[MON];
+        Rect rects[MON];
+        uint64_t end = std::min<uint64_t>(size, (uint64_t{task} + 1) * BLOCK);
+        for (uint64_t k = uint64_t{task} * BLOCK; k < end; ++k) {
+            grid.Pick(k, offsets);
+            Place(L, offsets, rects);
+            double cost = Evaluate(rects, n, crossings, cm).total;
+            if (cost < best[w].cost || (cost == best[w].cost && k < best[w].index)) best[w] = {cost, k};
+        }
+    });
+    WorkerBest out;
+    for (unsigned w = 0; w < threads; ++w)
+        if (best[w].cost < out.cost || (best[w].cost == out.cost && best[w].index < out.index)) out = best[w];
+    bestCost = out.cost;
+    return out.index;
+}
+
+static void PrintScore(const char* name, const Score& s, const char* unit) {
+    printf("  %-10s cost %14.1f  remap %12.1f %s  jump %12.1f %s  misses %llu\n", name, s.total, s.remap, unit, s.jump,
+           unit, static_cast<unsigned long long>(s.misses));
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t budget = uint64_t{1} << 18;
+    long minOverlap = 200;
+    CostModel cm;
+    std::vector<std::pair<double, double>> sizes;
+    std::string out;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--size=", 7) == 0) {
+            double w, h;
+            if (sscanf(argv[i] + 7, "%lf,%lf", &w, &h) != 2 || w <= 0.0 || h <= 0.0) {
+                printf("Bad size: %s\n", argv[i] + 7);
+                return 1;
+            }
+            sizes.push_back({w, h});
+        } else if (strncmp(argv[i], "--budget=", 9) == 0) {
+            budget = std::max<uint64_t>(64, strtoull(argv[i] + 9, nullptr, 10));
+        } else if (strncmp(argv[i], "--miss-cost=", 12) == 0) {
+            cm.missCost = std::max(0.0, atof(argv[i] + 12));
+        } else if (strncmp(argv[i], "--min-overlap=", 14) == 0) {
+            minOverlap = std::max(1L, strtol(argv[i] + 14, nullptr, 10));
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(1u, static_cast<unsigned>(strtoul(argv[i] + 10, nullptr, 10)));
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out = argv[i] + 6;
+        } else if (argv[i][0] == '-') {
+            printf("Unknown option: %s\n%s", argv[i], USAGE);
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        printf("%s", USAGE);
+        return 1;
+    }
+
+    // All traces must come from the same layout
+    std::vector<TraceFile> files;
+    std::vector<Rect> mons;
+    for (const auto& path : paths) {
+        TraceFile f;
+        const char* why = "cannot open";
+        if (!f.map.Open(path) || f.map.Size() < sizeof(TraceHeader) ||
+            !ValidateTraceHeader(*reinterpret_cast<const TraceHeader*>(f.map.Data()), f.map.Size(), &why)) {
+            printf("Skipping %s: %s\n", path.c_str(), why);
+            continue;
+        }
+        std::vector<Rect> m = TraceMonitors(*reinterpret_cast<const TraceHeader*>(f.map.Data()));
+        if (mons.empty()) {
+            mons = m;
+        } else if (m.size() != mons.size() ||
+                   !std::equal(m.begin(), m.end(), mons.begin(), [](const Rect& a, const Rect& b) {
+                       return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+                   })) {
+            printf("Skipping %s: recorded on a different layout\n", path.c_str());
+            continue;
+        }
+        f.records = reinterpret_cast<const TraceRecord*>(f.map.Data() + sizeof(TraceHeader));
+        f.count   = TraceRecordCount(f.map.Size());
+        files.push_back(std::move(f));
+    }
+    if (files.empty()) {
+        printf("No traces to replay.\n");
+        return 1;
+    }
+    if (!sizes.empty() && sizes.size() != mons.size()) {
+        printf("Give --size for all %zu monitors or none\n", mons.size());
+        return 1;
+    }
+    const char* unit = sizes.empty() ? "px" : "mm";
+    for (size_t m = 0; m < mons.size(); ++m) {
+        cm.pitchX.push_back(sizes.empty() ? 1.0 : sizes[m].first / static_cast<double>(mons[m].right - mons[m].left));
+        cm.pitchY.push_back(sizes.empty() ? 1.0 : sizes[m].second / static_cast<double>(mons[m].bottom - mons[m].top));
+    }
+
+    // Replay
+    auto t0 = std::chrono::steady_clock::now();
+    struct Shard {
+        uint32_t file;
+        uint64_t begin, end;
+    };
+    std::vector<Shard> shards;
+    uint64_t records = 0;
+    for (uint32_t fi = 0; fi < files.size(); ++fi) {
+        records += files[fi].count;
+        for (uint64_t b = 0; b < files[fi].count; b += SHARD_RECORDS)
+            shards.push_back({fi, b, std::min(files[fi].count, b + SHARD_RECORDS)});
+    }
+    std::vector<std::vector<Crossing>> perThread(threads);
+    ParallelFor(static_cast<uint32_t>(shards.size()), threads, [&](unsigned w, uint32_t task) {
+        const Shard& sh = shards[task];
+        ReplayShard(files[sh.file], sh.begin, sh.end, mons, perThread[w]);
+    });
+    std::vector<Crossing> all;
+    for (auto& v : perThread) all.insert(all.end(), v.begin(), v.end());
+    size_t total = all.size();
+    std::vector<Crossing> crossings = Merge(std::move(all));
+    double replaySec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%llu records, %zu crossings (%zu distinct) in %.3f s\n", static_cast<unsigned long long>(records), total,
+           crossings.size(), replaySec);
+    if (crossings.empty()) {
+        printf("No crossings recorded; nothing to optimise.\n");
+        return 1;
+    }
+
+    Layout L = BuildLayout(mons, crossings, minOverlap);
+    size_t attachCount = L.attach.size();
+    printf("%zu monitors, %zu movable, %u thread(s), distances in %s\n", mons.size(), attachCount, threads, unit);
+    std::vector<long> recorded(attachCount), best(attachCount);
+    for (size_t i = 0; i < attachCount; ++i) recorded[i] = L.attach[i].recorded;
+    Rect rects[MON];
+    Place(L, recorded.data(), rects);
+    Score recordedScore = Evaluate(rects, mons.size(), crossings, cm);
+    if (attachCount == 0) {
+        printf("Nothing to move.\n");
+        PrintScore("recorded", recordedScore, unit);
+        return 0;
+    }
+
+    // Coarse grid over the whole range, then finer grids around the best
+    // until the step is one pixel
+    long step = 1;
+    Grid grid;
+    for (;; step *= 2) {
+        grid.values.clear();
+        for (const Attachment& a : L.attach) grid.values.push_back(Around(a.lo, step, (a.hi - a.lo) / step, a.lo, a.hi));
+        if (grid.Size() <= budget) break;
+    }
+    long reach = 1;
+    while (std::pow(static_cast<double>(2 * (reach + 1) + 1), static_cast<double>(attachCount)) <=
+           static_cast<double>(budget))
+        ++reach;
+
+    uint64_t evaluated = 0;
+    double bestCost = 0.0;
+    auto s0 = std::chrono::steady_clock::now();
+    for (int round = 0;; ++round) {
+        uint64_t k = SearchGrid(grid, L, crossings, cm, threads, bestCost);
+        evaluated += grid.Size();
+        grid.Pick(k, best.data());
+        printf("  round %d: step %5ld px, %8llu candidates, best cost %.1f\n", round, step,
+               static_cast<unsigned long long>(grid.Size()), bestCost);
+        if (step == 1) break;
+        step = std::max(1L, step / (reach + 1));
+        grid.values.clear();
+        for (size_t i = 0; i < attachCount; ++i)
+            grid.values.push_back(Around(best[i], step, reach, L.attach[i].lo, L.attach[i].hi));
+    }
+    double searchSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+    printf("%llu layouts in %.3f s (%.0f layouts/s)\n", static_cast<unsigned long long>(evaluated), searchSec,
+           static_cast<double>(evaluated) / searchSec);
+
+    Place(L, best.data(), rects);
+    Score bestScore = Evaluate(rects, mons.size(), crossings, cm);
+    if (!(bestScore.total < recordedScore.total)) {
+        // The recorded offsets may fall between grid points
+        best = recorded;
+        Place(L, best.data(), rects);
+        bestScore = recordedScore;
+    }
+    PrintScore("recorded", recordedScore, unit);
+    PrintScore("best", bestScore, unit);
+    if (recordedScore.total > 0.0 && std::isfinite(recordedScore.total))
+        printf("  %.1f%% lower cost\n", 100.0 * (1.0 - bestScore.total / recordedScore.total));
+    for (size_t m = 0; m < mons.size(); ++m) {
+        const Rect& r = rects[m];
+        printf("  monitor %zu: %ld,%ld,%ld,%ld (moved %+ld,%+ld)\n", m, r.left, r.top, r.right, r.bottom,
+               r.left - mons[m].left, r.top - mons[m].top);
+    }
+
+    if (!out.empty()) {
+        // Same description format as --print-layout, for cursor_mapper_bake
+        FILE* f = fopen(out.c_str(), "w");
+        if (!f) {
+            printf("Cannot write %s\n", out.c_str());
+            return 1;
+        }
+        fprintf(f, "# cursor_mapper_layout: best of %llu arrangements, cost %.1f (recorded %.1f)\n",
+                static_cast<unsigned long long>(evaluated), bestScore.total, recordedScore.total);
+        for (size_t m = 0; m < mons.size(); ++m)
+            fprintf(f, "monitor %ld %ld %ld %ld\n", rects[m].left, rects[m].top, rects[m].right, rects[m].bottom);
+        fclose(f);
+        printf("Wrote %s\n", out.c_str());
+    }
+    return 0;
+}
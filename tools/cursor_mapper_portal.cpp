@@ -0,0 +1,234 @@
+// Remote portal daemon (remote_portal.h) on a virtual desktop: one portal
+// edge toward one peer over UDP. Two instances on loopback behave like two
+// machines sharing a mouse. The one started with --drive has the input
+// device. It sweeps a virtual cursor back and forth, so the cursor leaves
+// through the portal, is moved on the peer by forwarded motion, comes back,
+// and repeats. Local crossings go through EdgeRemapStage as in the hook.
+//
+//   cursor_mapper_portal --listen=[HOST:]PORT --peer=HOST:PORT --edge=SIDE
+//                        [--monitor=L,T,R,B]... [--drive=SECONDS]
+//                        [--duration=SECONDS] [--rate=HZ] [--speed=PX]
+//                        [--batch=N] [--flush-us=N] [--verbose]
+//
+// e.g. machine B to the right of machine A:
+//   cursor_mapper_portal --listen=7001 --peer=127.0.0.1:7000 --edge=left --duration=6
+//   cursor_mapper_portal --listen=7000 --peer=127.0.0.1:7001 --edge=right --drive=5
+
+#include "filter_chain.h"
+#include "remote_portal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* USAGE =
+    "Usage: cursor_mapper_portal --listen=[HOST:]PORT --peer=HOST:PORT --edge=left|right|top|bottom\n"
+    "                            [--monitor=L,T,R,B]... [--drive=SECONDS] [--duration=SECONDS]\n"
+    "                            [--rate=HZ] [--speed=PX] [--batch=N] [--flush-us=N] [--verbose]\n";
+
+static uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static bool ParseHostPort(const char* s, std::string& host, uint16_t& port) {
+    const char* colon = strrchr(s, ':');
+    host = colon ? std::string(s, colon) : std::string("127.0.0.1");
+    unsigned long p = strtoul(colon ? colon + 1 : s, nullptr, 10);
+    if (p == 0 || p > 65535 || host.empty()) return false;
+    port = static_cast<uint16_t>(p);
+    return true;
+}
+
+static Edge ParseEdge(const char* s) {
+    if (strcmp(s, "left") == 0) return Edge::Left;
+    if (strcmp(s, "right") == 0) return Edge::Right;
+    if (strcmp(s, "top") == 0) return Edge::Top;
+    if (strcmp(s, "bottom") == 0) return Edge::Bottom;
+    return Edge::None;
+}
+
+static bool SendToPeer(void* ctx, const void* data, size_t size) {
+    return static_cast<PortalSocket*>(ctx)->Send(data, size);
+}
+
+// The OS cursor of this side: clipped to the desktop, remapped on local
+// crossings, handed off when it pushes out through the portal edge.
+struct VirtualCursor {
+    EdgeRemapStage remap;
+    Point pos{0, 0};
+    int   monitor = -1;
+    bool  verbose = false;
+
+    void Place(Point p) {
+        pos     = p;
+        monitor = MonitorIndexFromPoint(remap.monitors.data(), remap.monitors.size(), p);
+        remap.Resync(p);
+    }
+
+    // Applies one delta; hands the cursor to the peer when it leaves
+    // through the portal.
+    void Move(long dx, long dy, PortalSession& session, uint64_t nowNs) {
+        const std::vector<Rect>& mons = remap.monitors;
+        Point target{pos.x + dx, pos.y + dy};
+        if (MonitorIndexFromPoint(mons.data(), mons.size(), target) >= 0) {
+            MotionSample s{target, static_cast<double>(dx), static_cast<double>(dy),
+                           static_cast<uint32_t>(nowNs / 1000000), 0};
+            remap.Process(&s, 1);
+            pos     = s.pos;
+            monitor = remap.lastMonitor;
+            return;
+        }
+        Edge exit = OuterExitEdge(mons, monitor, pos, dx, dy);
+        if (exit != Edge::None && exit == session.PortalEdge()) {
+            double along = OuterEdgeFraction(mons, exit, pos);
+            if (verbose) printf("leave  (%ld,%ld) %s %.3f\n", pos.x, pos.y, EdgeName(exit), along);
+            session.HandOff(along, nowNs);
+            return;
+        }
+        // Off the desktop elsewhere: clamp like the OS, the motion is lost
+        const Rect& rc = mons[monitor];
+        Place({std::clamp(target.x, rc.left, rc.right - 1), std::clamp(target.y, rc.top, rc.bottom - 1)});
+    }
+};
+
+int main(int argc, char** argv) {
+    std::string listenHost, peerHost;
+    uint16_t listenPort = 0, peerPort = 0;
+    Edge edge = Edge::None;
+    std::vector<Rect> mons;
+    double drive = 0.0, duration = 0.0, rateHz = 1000.0;
+    long speed = 12;
+    size_t batch = 16;
+    uint64_t flushUs = 1000;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--listen=", 9) == 0) {
+            if (!ParseHostPort(argv[i] + 9, listenHost, listenPort)) {
+                printf("Bad listen address: %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--peer=", 7) == 0) {
+            if (!ParseHostPort(argv[i] + 7, peerHost, peerPort)) {
+                printf("Bad peer address: %s\n", argv[i] + 7);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--edge=", 7) == 0) {
+            edge = ParseEdge(argv[i] + 7);
+        } else if (strncmp(argv[i], "--monitor=", 10) == 0) {
+            long l, t, r, b;
+            if (sscanf(argv[i] + 10, "%ld,%ld,%ld,%ld", &l, &t, &r, &b) != 4 || r <= l || b <= t) {
+                printf("Bad monitor: %s\n", argv[i] + 10);
+                return 1;
+            }
+            mons.push_back({l, t, r, b});
+        } else if (strncmp(argv[i], "--drive=", 8) == 0) {
+            drive = std::max(0.0, atof(argv[i] + 8));
+        } else if (strncmp(argv[i], "--duration=", 11) == 0) {
+            duration = std::max(0.0, atof(argv[i] + 11));
+        } else if (strncmp(argv[i], "--rate=", 7) == 0) {
+            rateHz = std::clamp(atof(argv[i] + 7), 125.0, 8000.0);
+        } else if (strncmp(argv[i], "--speed=", 8) == 0) {
+            speed = std::max(1L, strtol(argv[i] + 8, nullptr, 10));
+        } else if (strncmp(argv[i], "--batch=", 8) == 0) {
+            batch = std::clamp<size_t>(strtoull(argv[i] + 8, nullptr, 10), 1, PORTAL_MAX_BATCH);
+        } else if (strncmp(argv[i], "--flush-us=", 11) == 0) {
+            flushUs = strtoull(argv[i] + 11, nullptr, 10);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            printf("Unknown option: %s\n%s", argv[i], USAGE);
+            return 1;
+        }
+    }
+    if (!listenPort || !peerPort || edge == Edge::None) {
+        printf("%s", USAGE);
+        return 1;
+    }
+    if (mons.empty()) mons.push_back({0, 0, 1920, 1080});
+
+    PortalSocket sock;
+    if (!sock.Open(listenHost, listenPort) || !sock.SetPeer(peerHost, peerPort)) {
+        printf("Socket error: %s\n", sock.Error());
+        return 1;
+    }
+
+    std::random_device rd;
+    PortalSession session(edge, rd(), SendToPeer, &sock, batch);
+    VirtualCursor cursor;
+    cursor.verbose = verbose;
+    cursor.remap.SetMonitors(mons);
+    const Rect& home = mons[0];
+    cursor.Place({(home.left + home.right) / 2, (home.top + home.bottom) / 2});
+    session.SetCursorHere(drive > 0.0);  // the side with the input device starts with it
+    printf("Portal on %s edge -> %s:%u, %zu monitors%s\n", EdgeName(edge), peerHost.c_str(), peerPort, mons.size(),
+           drive > 0.0 ? ", driving" : "");
+
+    // Sweep along the portal axis, reversing every sweepTicks, with a slow
+    // drift across it so entry points vary
+    bool horizontal = edge == Edge::Left || edge == Edge::Right;
+    long sign = edge == Edge::Right || edge == Edge::Bottom ? 1 : -1;
+    const uint64_t tickNs   = static_cast<uint64_t>(1e9 / rateHz);
+    const uint64_t driveEnd = static_cast<uint64_t>(drive * 1e9);
+    const uint64_t runEnd   = duration > 0.0 ? static_cast<uint64_t>(duration * 1e9)
+                              : drive > 0.0  ? driveEnd + 500000000ull  // let the last packets land
+                                             : UINT64_MAX;
+    const uint64_t sweepTicks = static_cast<uint64_t>(rateHz * 0.6);
+    const uint64_t t0 = NowNs();
+    uint64_t tick = 0, nextTick = t0, nextPing = t0;
+    uint8_t buf[PORTAL_MAX_PACKET + 64];
+
+    for (;;) {
+        uint64_t now = NowNs();
+        if (now - t0 >= runEnd) break;
+
+        if (now - t0 < driveEnd && now >= nextTick) {
+            long along = (tick / sweepTicks) % 2 == 0 ? speed * sign : -speed * sign;
+            long across = (tick / 97) % 2 == 0 ? 1 : -1;
+            long dx = horizontal ? along : across, dy = horizontal ? across : along;
+            if (session.CursorHere()) cursor.Move(dx, dy, session, now);
+            else session.QueueMotion(dx, dy, now);
+            ++tick;
+            nextTick += tickNs;
+        }
+        if (now >= nextPing) {
+            session.Ping(now);
+            nextPing = now + 100000000;
+        }
+        session.Poll(now, flushUs * 1000);
+
+        uint64_t wakeNs = now - t0 < driveEnd ? nextTick : now + 1000000;
+        int timeoutMs = wakeNs > now ? static_cast<int>((wakeNs - now) / 1000000) : 0;
+        for (int n; (n = sock.Recv(buf, sizeof(buf), timeoutMs)) > 0; timeoutMs = 0) {
+            uint64_t at = NowNs();
+            PortalSession::Event ev = session.OnPacket(buf, static_cast<size_t>(n), mons, at);
+            if (ev.kind == PortalSession::Event::Entered) {
+                cursor.Place(ev.entry);
+                if (verbose) printf("enter  (%ld,%ld)\n", ev.entry.x, ev.entry.y);
+            } else if (ev.kind == PortalSession::Event::Moved) {
+                cursor.Move(ev.dx, ev.dy, session, at);
+            }
+        }
+    }
+
+    const PortalStats& st = session.Stats();
+    printf("Cursor %s at (%ld,%ld)\n", session.CursorHere() ? "here" : "on peer", cursor.pos.x, cursor.pos.y);
+    printf("Hand-offs: %llu out, %llu in (%llu Enter resends)\n", static_cast<unsigned long long>(st.handoffsOut),
+           static_cast<unsigned long long>(st.handoffsIn), static_cast<unsigned long long>(st.resends));
+    printf("Packets: %llu sent, %llu received, %llu rejected\n", static_cast<unsigned long long>(st.packetsSent),
+           static_cast<unsigned long long>(st.packetsReceived), static_cast<unsigned long long>(st.rejected));
+    printf("Motion in: %llu packets, %llu deltas, %llu late, %llu lost, %llu stray\n",
+           static_cast<unsigned long long>(st.motionPackets), static_cast<unsigned long long>(st.motionDeltas),
+           static_cast<unsigned long long>(st.motionLate), static_cast<unsigned long long>(st.motionLost),
+           static_cast<unsigned long long>(st.motionStray));
+    if (st.rttSamples)
+        printf("Round trip: %.1f us mean over %llu samples\n",
+               static_cast<double>(st.rttNsTotal) / static_cast<double>(st.rttSamples) / 1000.0,
+               static_cast<unsigned long long>(st.rttSamples));
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Prints the live counters of a running cursor_mapper from its shared stats
+// region. Reading never involves the daemon: the region is mapped
+// read-only and each block is copied under its seqlock. --crossings
+// instead follows the crossing bus and prints each monitor crossing as it
+// happens, with a note whenever this reader fell behind and lost events.
+//
+//   cursor_mapper_stat [--name=NAME] [--prometheus] [--watch=MS]
+//   cursor_mapper_stat --crossings[=BUS]
+
+#include "crossing_bus.h"
+#include "stats_shm.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Upper bound of the bucket holding quantile q, in ns (0 when empty).
+static uint64_t QuantileBoundNs(const LatencyHistogram& h, double q) {
+    uint64_t count = h.count.Load();
+    if (!count) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count));
+    uint64_t seen = 0, bound = LATENCY_FIRST_NS;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i, bound <<= 1) {
+        seen += h.buckets[i].Load();
+        if (seen > rank) return bound;
+    }
+    return UINT64_MAX;
+}
+
+static void PrintLatency(const char* label, uint64_t ns) {
+    if (ns == UINT64_MAX) printf(" %s >%.0f us", label, (LATENCY_FIRST_NS << (LATENCY_BUCKETS - 1)) / 1e3);
+    else if (ns >= 1000) printf(" %s <=%.1f us", label, ns / 1e3);
+    else printf(" %s <=%llu ns", label, static_cast<unsigned long long>(ns));
+}
+
+static void PrintSummary(const StatsHeader& h, const ThreadMetrics& t, size_t torn) {
+    auto n = [](const Counter& c) { return static_cast<unsigned long long>(c.Load()); };
+    uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    uint64_t upS = nowMs > h.startUnixMs ? (nowMs - h.startUnixMs) / 1000 : 0;
+    printf("cursor_mapper pid %llu, up %lluh%02llum%02llus%s\n", static_cast<unsigned long long>(h.pid),
+           static_cast<unsigned long long>(upS / 3600), static_cast<unsigned long long>(upS / 60 % 60),
+           static_cast<unsigned long long>(upS % 60), torn ? " (some blocks mid-update)" : "");
+    printf("  events     %llu (fast path %llu, offscreen %llu, crossings %llu)\n",
+           n(t.events), n(t.fastPath), n(t.offscreen), n(t.crossings));
+    printf("  warps      %llu remapped, %llu failed, %llu echoes\n",
+           n(t.remaps), n(t.warpFailures), n(t.echoes));
+    uint64_t count = t.mapLatency.count.Load();
+    printf("  latency   ");
+    if (count) {
+        printf(" mean %.0f ns,", static_cast<double>(t.mapLatency.sumNs.Load()) / static_cast<double>(count));
+        PrintLatency("p50", QuantileBoundNs(t.mapLatency, 0.50));
+        printf(",");
+        PrintLatency("p99", QuantileBoundNs(t.mapLatency, 0.99));
+        printf("\n");
+    } else {
+        printf(" no samples\n");
+    }
+    printf("  topology   %llu refreshes, %llu signature hits, %llu published\n",
+           n(t.refreshes), n(t.signatureHits), n(t.publishes));
+    if (t.shadowEvaluated.Load() || t.shadowDropped.Load()) {
+        printf("  shadow     %llu evaluated, %llu dropped; diverged %llu edge, %llu remap, %llu position",
+               n(t.shadowEvaluated), n(t.shadowDropped), n(t.shadowEdgeDiffs), n(t.shadowRemapDiffs),
+               n(t.shadowPositionDiffs));
+        if (uint64_t calls = t.shadowTimedCalls.Load())
+            printf("; live %.1f ns, candidate %.1f ns", static_cast<double>(t.shadowLiveNs.Load()) / calls,
+                   static_cast<double>(t.shadowCandidateNs.Load()) / calls);
+        printf("\n");
+    }
+    bool any = false;
+    for (size_t s = 0; s < METRICS_MAX_MONITORS; ++s) {
+        for (size_t d = 0; d < METRICS_MAX_MONITORS; ++d) {
+            if (!t.portal[s][d].Load()) continue;
+            printf(any ? ", %zu->%zu %llu" : "  portals    %zu->%zu %llu", s, d, n(t.portal[s][d]));
+            any = true;
+        }
+    }
+    if (any) printf("\n");
+}
+
+// Polls the bus until interrupted.
+static int FollowCrossings(const std::string& busName) {
+    CrossingBusReader reader;
+    if (!reader.Open(busName)) {
+        printf("Cannot open %s: %s\n", busName.c_str(), reader.Error());
+        return 1;
+    }
+    printf("Following crossings of cursor_mapper pid %llu\n",
+           static_cast<unsigned long long>(reader.Header().pid));
+    CrossingEvent events[64];
+    uint64_t lost = 0;
+    for (;;) {
+        size_t n = reader.Read(events, 64);
+        if (reader.Lost() != lost) {
+            printf("  ... %llu events lost\n", static_cast<unsigned long long>(reader.Lost() - lost));
+            lost = reader.Lost();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const CrossingEvent& e = events[i];
+            printf("%10u ms  %d -> %d  %-6s (%d,%d) -> (%d,%d)", e.time, e.src, e.dst,
+                   EdgeName(static_cast<Edge>(e.edge)), e.exitX, e.exitY, e.entryX, e.entryY);
+            if (e.flags & CROSSING_REMAPPED) printf("  remapped from (%d,%d)", e.rawX, e.rawY);
+            printf("\n");
+        }
+        if (n) fflush(stdout);
+        else std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string name = DEFAULT_STATS_NAME;
+    std::string busName;
+    bool prometheus = false;
+    unsigned watchMs = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--name=", 7) == 0) {
+            name = argv[i] + 7;
+        } else if (strcmp(argv[i], "--prometheus") == 0) {
+            prometheus = true;
+        } else if (strncmp(argv[i], "--watch=", 8) == 0) {
+            watchMs = static_cast<unsigned>(strtoul(argv[i] + 8, nullptr, 10));
+        } else if (strcmp(argv[i], "--crossings") == 0) {
+            busName = DEFAULT_BUS_NAME;
+        } else if (strncmp(argv[i], "--crossings=", 12) == 0) {
+            busName = argv[i] + 12;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            printf("Usage: cursor_mapper_stat [--name=NAME] [--prometheus] [--watch=MS]\n"
+                   "       cursor_mapper_stat --crossings[=BUS]\n");
+            return 1;
+        }
+    }
+    if (!busName.empty()) return FollowCrossings(busName);
+
+    StatsRegion region;
+    if (!region.Open(name)) {
+        printf("Cannot open %s: %s\n", name.c_str(), region.Error());
+        return 1;
+    }
+
+    uint64_t lastEvents = 0;
+    auto last = std::chrono::steady_clock::now();
+    for (bool first = true;; first = false) {
+        ThreadMetrics total;
+        size_t torn = region.Total(total);
+        if (prometheus) {
+            printf("%s", RenderPrometheus(total).c_str());
+        } else {
+            PrintSummary(region.Header(), total, torn);
+            if (!first) {
+                auto now = std::chrono::steady_clock::now();
+                double s = std::chrono::duration<double>(now - last).count();
+                printf("  rate       %.0f events/s\n", static_cast<double>(total.events.Load() - lastEvents) / s);
+                last = now;
+            }
+            lastEvents = total.events.Load();
+        }
+        if (!watchMs) break;
+        fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::milliseconds(watchMs));
+    }
+    return 0;
+}